@@ -77,6 +77,13 @@ bool GLibDispatcher::add_connection( std::shared_ptr<Connection> connection ){
     m_priv->m_channelToConnection[ newChannel ] = connection;
     guint sourceId = g_io_add_watch( newChannel, G_IO_IN, &GLibDispatcher::channel_data_cb, this );
 
+    // Dispatching also expires any asynchronous calls that have timed out
+    if( connection->timeout_fd() >= 0 ){
+        GIOChannel* timeoutChannel = g_io_channel_unix_new( connection->timeout_fd() );
+        m_priv->m_channelToConnection[ timeoutChannel ] = connection;
+        g_io_add_watch( timeoutChannel, G_IO_IN, &GLibDispatcher::channel_data_cb, this );
+    }
+
     SIMPLELOGGER_TRACE( LOGGER_NAME, "Adding connection" );
     return true;
 }
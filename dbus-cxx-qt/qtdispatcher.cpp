@@ -79,6 +79,18 @@ bool QtDispatcher::add_connection( std::shared_ptr<DBus::Connection> connection
     connect( socketNotify.get(), &QSocketNotifier::activated,
              this, &QtDispatcher::activated );
 
+    // Dispatching also expires any asynchronous calls that have timed out
+    int timeoutFd = connection->timeout_fd();
+    if( timeoutFd >= 0 ){
+        m_priv->m_fdToConnection[ timeoutFd ] = connection;
+
+        std::shared_ptr<QSocketNotifier> timeoutNotify = std::make_shared<QSocketNotifier>( timeoutFd, QSocketNotifier::Read );
+        m_priv->m_socketNotifiers.push_back( timeoutNotify );
+
+        connect( timeoutNotify.get(), &QSocketNotifier::activated,
+                 this, &QtDispatcher::activated );
+    }
+
     return true;
 }
 
@@ -42,6 +42,8 @@ public:
     QVector<std::shared_ptr<DBus::SignalProxyBase>> m_signalHandlers;
     QMutex m_signalsMutex;
     QQueue<std::shared_ptr<const SignalMessage>> m_signalsQueue;
+    QMutex m_workMutex;
+    QQueue<std::function<void()>> m_workQueue;
 };
 
 QtThreadDispatcher::QtThreadDispatcher() :
@@ -98,6 +100,24 @@ void QtThreadDispatcher::add_signal( std::shared_ptr<const SignalMessage> messag
     Q_EMIT notifyMainThread();
 }
 
+void QtThreadDispatcher::add_signals( const std::vector<std::shared_ptr<const SignalMessage>>& messages ){
+    QMutexLocker lock( &m_priv->m_signalsMutex );
+
+    for( std::shared_ptr<const SignalMessage> message : messages ){
+        m_priv->m_signalsQueue.push_back( message );
+    }
+
+    Q_EMIT notifyMainThread();
+}
+
+void QtThreadDispatcher::add_work( std::function<void()> work ){
+    QMutexLocker lock( &m_priv->m_workMutex );
+
+    m_priv->m_workQueue.push_back( work );
+
+    Q_EMIT notifyMainThread();
+}
+
 void QtThreadDispatcher::sendMessages(){
     {
         QMutexLocker lock( &m_priv->m_objMessageMutex );
@@ -122,4 +142,20 @@ void QtThreadDispatcher::sendMessages(){
             }
         }
     }
+
+    {
+        QQueue<std::function<void()>> work;
+
+        {
+            QMutexLocker lock( &m_priv->m_workMutex );
+            work.swap( m_priv->m_workQueue );
+        }
+
+        while( work.size() ){
+            std::function<void()> func = work.front();
+            work.pop_front();
+
+            func();
+        }
+    }
 }
@@ -44,6 +44,8 @@ public:
     void add_signal_proxy( std::shared_ptr<SignalProxyBase> handler );
     bool remove_signal_proxy( std::shared_ptr<SignalProxyBase> handler );
     void add_signal( std::shared_ptr<const SignalMessage> message );
+    void add_signals( const std::vector<std::shared_ptr<const SignalMessage>>& messages );
+    void add_work( std::function<void()> work );
 
     static std::shared_ptr<QtThreadDispatcher> create();
 
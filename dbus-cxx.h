@@ -13,6 +13,7 @@
 #endif
 
 #include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/awaitable.h>
 #include <dbus-cxx/callmessage.h>
 #include <dbus-cxx/connection.h>
 #include <dbus-cxx/signal.h>
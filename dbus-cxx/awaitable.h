@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx/error.h>
+#include <dbus-cxx/pendingcall.h>
+#include <dbus-cxx/returnmessage.h>
+#include <dbus-cxx/threaddispatcher.h>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <sigc++/sigc++.h>
+
+#ifndef DBUSCXX_AWAITABLE_H
+#define DBUSCXX_AWAITABLE_H
+
+namespace DBus {
+
+/**
+ * @defgroup awaitable Coroutine support
+ *
+ * Awaitable types that allow method calls and signals to be used with
+ * co_await in C++20 code.  The library itself does not need C++20; these
+ * types only become awaitable when used from a coroutine.
+ */
+
+namespace priv {
+
+/**
+ * Resume the given coroutine, either directly or in the thread represented
+ * by the given ThreadDispatcher.
+ *
+ * @return False, without resuming the coroutine, if the ThreadDispatcher
+ * can't run work
+ */
+template <typename T_handle>
+bool resume_coroutine( T_handle handle, std::shared_ptr<ThreadDispatcher> resume_on ) {
+    if( resume_on ) {
+        try {
+            resume_on->add_work( [handle]() mutable { handle.resume(); } );
+        } catch( const ErrorNotSupported& ) {
+            return false;
+        }
+    } else {
+        handle.resume();
+    }
+
+    return true;
+}
+
+}
+
+/**
+ * The result of MethodProxy::async().  When awaited, the calling coroutine is
+ * suspended until the reply to the call comes in, and then resumed with the
+ * return value of the method(or the error is thrown).
+ *
+ * By default the coroutine is resumed in the dispatcher thread; use
+ * resume_on() to resume in the thread of a ThreadDispatcher instead.
+ *
+ * @ingroup awaitable
+ */
+template <typename T_return>
+class MethodCallAwaitable {
+public:
+    MethodCallAwaitable( std::shared_ptr<PendingCall> call ) :
+        m_call( call ),
+        m_resumeFailed( false ) {}
+
+    /**
+     * Resume the awaiting coroutine in the thread represented by the given
+     * ThreadDispatcher.
+     */
+    MethodCallAwaitable& resume_on( std::shared_ptr<ThreadDispatcher> disp ) {
+        m_resumeOn = disp;
+        return *this;
+    }
+
+    std::shared_ptr<PendingCall> pending_call() const {
+        return m_call;
+    }
+
+    bool await_ready() const {
+        return !m_call || ( !m_resumeOn && ( m_call->completed() || m_call->is_canceled() ) );
+    }
+
+    template <typename T_handle>
+    void await_suspend( T_handle handle ) {
+        // The coroutine may be resumed(and this destroyed) before set_notify
+        // returns, so don't use any members after this point.
+        std::shared_ptr<PendingCall> call = m_call;
+        std::shared_ptr<ThreadDispatcher> resume_on = m_resumeOn;
+        MethodCallAwaitable* self = this;
+
+        call->set_notify( [self, handle, resume_on]( std::shared_ptr<PendingCall> ) mutable {
+            if( priv::resume_coroutine( handle, resume_on ) ) { return; }
+
+            // We are still suspended, so this is still around; resume here
+            // so that co_await throws
+            self->m_resumeFailed = true;
+            handle.resume();
+        } );
+    }
+
+    T_return await_resume() {
+        if( !m_call ) { throw ErrorDisconnected(); }
+
+        if( m_resumeFailed ) {
+            throw ErrorNotSupported( "The ThreadDispatcher to resume on can't run work" );
+        }
+
+        if( m_call->is_canceled() ) { throw ErrorCallCanceled( "The call was canceled" ); }
+
+        std::shared_ptr<const ReturnMessage> retmsg = m_call->return_message();
+
+        if constexpr( !std::is_void_v<T_return> ) {
+            T_return retval;
+            retmsg >> retval;
+            return retval;
+        }
+    }
+
+private:
+    std::shared_ptr<PendingCall> m_call;
+    std::shared_ptr<ThreadDispatcher> m_resumeOn;
+    bool m_resumeFailed;
+};
+
+/**
+ * Awaits the next emission of a signal.  The awaiting coroutine is resumed
+ * from the thread that emits the signal, with the arguments of the signal:
+ * nothing for a signal with no arguments, the value for a signal with one
+ * argument, or a std::tuple of all of the arguments otherwise.
+ *
+ * The coroutine may await from any thread; for a SignalProxy handled in the
+ * dispatcher thread, it is then resumed in the dispatcher thread.  As with
+ * sigc++ signals in general, connecting is not thread-safe, so the signal
+ * must not be emitted while the coroutine is starting to wait.  Start
+ * waiting before doing whatever causes the signal to be sent.
+ *
+ * @ingroup awaitable
+ */
+template <typename... T_arg>
+class SignalAwaitable {
+private:
+    using tuple_type = std::tuple<std::decay_t<T_arg>...>;
+
+    struct State {
+        bool fired = false;
+        sigc::connection connection;
+        std::optional<tuple_type> values;
+    };
+
+public:
+    SignalAwaitable( sigc::signal<void( T_arg... )> signal ) :
+        m_signal( signal ),
+        m_state( std::make_shared<State>() ) {}
+
+    bool await_ready() const {
+        return false;
+    }
+
+    template <typename T_handle>
+    void await_suspend( T_handle handle ) {
+        std::shared_ptr<State> state = m_state;
+
+        state->connection = m_signal.connect( [state, handle]( T_arg... args ) {
+            if( state->fired ) { return; }
+
+            state->fired = true;
+            state->connection.disconnect();
+            state->values.emplace( args... );
+            priv::resume_coroutine( handle, std::shared_ptr<ThreadDispatcher>() );
+        } );
+    }
+
+    auto await_resume() {
+        if constexpr( sizeof...( T_arg ) == 0 ) {
+            return;
+        } else if constexpr( sizeof...( T_arg ) == 1 ) {
+            return std::get<0>( std::move( *m_state->values ) );
+        } else {
+            return std::move( *m_state->values );
+        }
+    }
+
+private:
+    sigc::signal<void( T_arg... )> m_signal;
+    std::shared_ptr<State> m_state;
+};
+
+}
+
+#endif
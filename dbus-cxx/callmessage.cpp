@@ -44,6 +44,11 @@ CallMessage::CallMessage( const std::string& path, const std::string& method ) {
     set_member( method );
 }
 
+CallMessage::CallMessage( std::shared_ptr<const MessageHeaderTemplate> header_template ) :
+    Message() {
+    set_header_template( header_template );
+}
+
 std::shared_ptr<CallMessage> CallMessage::create() {
     return std::shared_ptr<CallMessage>( new CallMessage() );
 }
@@ -60,6 +65,10 @@ std::shared_ptr<CallMessage> CallMessage::create( const std::string& path, const
     return std::shared_ptr<CallMessage>( new CallMessage( path, method ) );
 }
 
+std::shared_ptr<CallMessage> CallMessage::create( std::shared_ptr<const MessageHeaderTemplate> header_template ) {
+    return std::shared_ptr<CallMessage>( new CallMessage( header_template ) );
+}
+
 std::shared_ptr<ReturnMessage> CallMessage::create_reply() const {
     if( !this->is_valid() ) { return std::shared_ptr<ReturnMessage>(); }
 
@@ -143,7 +152,7 @@ void CallMessage::set_no_reply( bool no_reply ) {
 }
 
 bool CallMessage::expects_reply() const {
-    return flags() & DBUSCXX_MESSAGE_NO_REPLY_EXPECTED;
+    return !( flags() & DBUSCXX_MESSAGE_NO_REPLY_EXPECTED );
 }
 
 MessageType CallMessage::type() const {
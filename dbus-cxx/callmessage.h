@@ -42,6 +42,8 @@ protected:
 
     CallMessage( const std::string& path, const std::string& method );
 
+    CallMessage( std::shared_ptr<const MessageHeaderTemplate> header_template );
+
 public:
 
     static std::shared_ptr<CallMessage> create();
@@ -52,6 +54,14 @@ public:
 
     static std::shared_ptr<CallMessage> create( const std::string& path, const std::string& method );
 
+    /**
+     * Create a new CallMessage whose path, interface, member and destination
+     * come from the given pre-marshaled template.
+     *
+     * @param header_template The template to create the message from
+     */
+    static std::shared_ptr<CallMessage> create( std::shared_ptr<const MessageHeaderTemplate> header_template );
+
     /**
      * Create a reply to this call message.
      *
@@ -88,6 +98,10 @@ public:
 
     void set_no_reply( bool no_reply = true );
 
+    /**
+     * Returns true if the caller expects a reply to this message, i.e. the
+     * NO_REPLY_EXPECTED flag is not set.
+     */
     bool expects_reply() const;
 
     virtual MessageType type() const;
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "concurrencylimiter.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+using DBus::priv::ConcurrencyLimiter;
+
+class ConcurrencyLimiter::priv_data {
+public:
+    priv_data() :
+        m_maxInFlight( 0 ),
+        m_maxQueued( 0 ),
+        m_inFlight( 0 ),
+        m_waiting( 0 ),
+        m_rejected( 0 )
+    {}
+
+    std::atomic<unsigned int> m_maxInFlight;
+    std::atomic<unsigned int> m_maxQueued;
+    std::atomic<unsigned int> m_inFlight;
+    /*
+     * How many calls are parked, or are about to be; only changed with the
+     * lock held
+     */
+    std::atomic<unsigned int> m_waiting;
+    std::atomic<uint64_t> m_rejected;
+    std::mutex m_lock;
+    std::deque<std::function<void()>> m_parked;
+
+    /*
+     * Give the free turns to the calls that have been parked the longest.
+     * The lock must be held; the calls are resumed after it is let go.
+     */
+    void give_out_turns( std::vector<std::function<void()>>* toResume ) {
+        unsigned int maxInFlight = m_maxInFlight;
+
+        while( !m_parked.empty() &&
+            ( maxInFlight == 0 || m_inFlight < maxInFlight ) ) {
+            toResume->push_back( std::move( m_parked.front() ) );
+            m_parked.pop_front();
+            m_waiting--;
+            m_inFlight++;
+        }
+    }
+};
+
+ConcurrencyLimiter::ConcurrencyLimiter() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+ConcurrencyLimiter::~ConcurrencyLimiter() {
+}
+
+void ConcurrencyLimiter::set_limits( unsigned int maxInFlight, unsigned int maxQueued ) {
+    std::vector<std::function<void()>> toResume;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+        m_priv->m_maxInFlight = maxInFlight;
+        m_priv->m_maxQueued = maxQueued;
+
+        // The limit may have gone up, so give out the new turns
+        m_priv->give_out_turns( &toResume );
+    }
+
+    for( std::function<void()>& resume : toResume ) {
+        resume();
+    }
+}
+
+ConcurrencyLimiter::Admission ConcurrencyLimiter::acquire( std::function<void()> resume ) {
+    if( m_priv->m_maxInFlight == 0 ) {
+        // No limit, so there is no need to lock
+        m_priv->m_inFlight++;
+        return Admission::Run;
+    }
+
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    unsigned int maxInFlight = m_priv->m_maxInFlight;
+
+    // Count ourselves as waiting before looking at how many calls are
+    // running, so that a call that finishes right now can't miss us
+    m_priv->m_waiting++;
+
+    if( maxInFlight == 0 || m_priv->m_inFlight < maxInFlight ) {
+        m_priv->m_waiting--;
+        m_priv->m_inFlight++;
+        return Admission::Run;
+    }
+
+    if( m_priv->m_parked.size() >= m_priv->m_maxQueued ) {
+        m_priv->m_waiting--;
+        m_priv->m_rejected++;
+        return Admission::Rejected;
+    }
+
+    m_priv->m_parked.push_back( std::move( resume ) );
+
+    return Admission::Parked;
+}
+
+void ConcurrencyLimiter::release() {
+    std::vector<std::function<void()>> toResume;
+
+    m_priv->m_inFlight--;
+
+    // Anybody that is waiting has already counted itself before checking
+    // m_inFlight, so it can't be missed here
+    if( m_priv->m_waiting == 0 ) { return; }
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+        m_priv->give_out_turns( &toResume );
+    }
+
+    for( std::function<void()>& resume : toResume ) {
+        resume();
+    }
+}
+
+unsigned int ConcurrencyLimiter::max_in_flight() const {
+    return m_priv->m_maxInFlight;
+}
+
+unsigned int ConcurrencyLimiter::max_queued() const {
+    return m_priv->m_maxQueued;
+}
+
+uint64_t ConcurrencyLimiter::rejected() const {
+    return m_priv->m_rejected;
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_CONCURRENCYLIMITER_H
+#define DBUS_CXX_CONCURRENCYLIMITER_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * Limits how many calls can be running at once, and how many more can be
+ * waiting for a turn to run.  Calls past that are rejected.
+ *
+ * A call that has to wait doesn't hold up the thread that is handling it;
+ * it is parked, and resumed by whichever call gives up its turn first.
+ *
+ * This class is thread-safe.
+ */
+class ConcurrencyLimiter {
+public:
+    enum class Admission {
+        /** The call has its turn and may run now */
+        Run,
+        /** The call has been parked until it gets a turn */
+        Parked,
+        /** The call must be rejected */
+        Rejected,
+    };
+
+    ConcurrencyLimiter();
+
+    ~ConcurrencyLimiter();
+
+    /**
+     * @param maxInFlight How many calls may run at once, or 0 for no limit
+     * @param maxQueued How many calls may wait for one of the running calls to finish
+     */
+    void set_limits( unsigned int maxInFlight, unsigned int maxQueued );
+
+    /**
+     * Get permission to run a call.  If there are already as many calls
+     * running as there can be, the call is parked.
+     *
+     * @param resume Called once a parked call has its turn, from the thread
+     * that gave the turn up.  It should hand the call off to run somewhere
+     * else rather than running it right there.
+     * @return Whether the call may run now, has been parked, or must be rejected
+     */
+    Admission acquire( std::function<void()> resume );
+
+    /**
+     * Finish a call that has its turn, giving the turn to the call that has
+     * been parked the longest, if there is one.
+     */
+    void release();
+
+    unsigned int max_in_flight() const;
+
+    unsigned int max_queued() const;
+
+    /** How many calls have been rejected */
+    uint64_t rejected() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_CONCURRENCYLIMITER_H */
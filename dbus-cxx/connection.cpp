@@ -10,7 +10,9 @@
 #include <dbus-cxx/signalmessage.h>
 #include <dbus-cxx/errormessage.h>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <functional>
 #include <memory>
 #include <utility>
 #include "callmessage.h"
@@ -18,16 +20,23 @@
 #include "error.h"
 #include "message.h"
 #include "object.h"
+#include "objectpathregistry.h"
+#include "incomingqueue.h"
 #include "objectproxy.h"
+#include "outgoingqueue.h"
 #include "path.h"
 #include "pendingcall.h"
+#include "replywaitertable.h"
 #include "returnmessage.h"
 #include <sigc++/sigc++.h>
 #include "signalproxy.h"
+#include "signalroutingtable.h"
+#include "timerwheel.h"
 #include "transport.h"
 #include "simpletransport.h"
 #include <poll.h>
 #include "utility.h"
+#include "workstealingpool.h"
 #include "daemon-proxy/DBusDaemonProxy.h"
 #include "interfaceproxy.h"
 #include "transport.h"
@@ -38,6 +47,8 @@
 
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <set>
+#include <unordered_map>
 #include <thread>
 
 #define DBUSCXX_REQUEST_NAME_REPLY_PRIMARY_OWNER 0x01
@@ -61,23 +72,17 @@ namespace sigc { template <typename T_return, typename ...T_arg> class slot; }
 
 static const char* LOGGER_NAME = "DBus.Connection";
 
+/* The most messages to read, and to process, in one call to dispatch() */
+#define MAX_MESSAGES_PER_DISPATCH 32
+
 namespace DBus {
 
-struct ExpectingResponse {
-    std::mutex cv_lock;
-    std::condition_variable cv;
-    std::shared_ptr<Message> reply;
+struct PendingCallEntry {
+    std::shared_ptr<PendingCall> call;
+    priv::TimerWheel::Timer* timeout;
 };
 
-struct OutgoingMessage {
-    std::shared_ptr<const Message> msg;
-    uint32_t serial;
-};
-
-struct PathHandlingEntry {
-    std::shared_ptr<Object> handler;
-    std::thread::id handlingThread;
-};
+typedef std::unordered_map<uint32_t, PendingCallEntry> PendingCalls;
 
 struct ObjectProxyThreadInfo {
     std::shared_ptr<ObjectProxy> handler;
@@ -94,22 +99,56 @@ public:
     priv_data() :
         m_currentSerial( 1 ),
         m_dispatchingThread( std::this_thread::get_id() ),
-        m_dispatchStatus( DispatchStatus::COMPLETE )
-    {}
+        m_dispatchStatus( DispatchStatus::COMPLETE ),
+        m_hasMatchChanges( false ),
+        m_threadPoolSize( 0 ),
+        m_threadPoolOrdering( ThreadPoolOrdering::None ),
+        m_directBlockingSend( false ),
+        m_busyPollWindow( 0 ),
+        m_busyPollHits( 0 ),
+        m_busyPollMisses( 0 ),
+        m_defaultTimeout( 20000 ) {
+        m_incomingMessages.set_watermark_callback( [this]( bool full ) {
+            m_incomingWatermark.emit( full );
+        } );
+    }
+
+    /**
+     * Get the serial to use for the next message; may be called from any thread.
+     */
+    uint32_t next_serial() {
+        uint32_t serial = m_currentSerial.fetch_add( 1, std::memory_order_relaxed );
+
+        // 0 is not a valid serial; skip it when we wrap around
+        if( serial == 0 ) {
+            serial = m_currentSerial.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        return serial;
+    }
 
     std::vector<uint8_t> m_sendBuffer;
-    uint32_t m_currentSerial;
+    std::atomic<uint32_t> m_currentSerial;
     std::shared_ptr<priv::Transport> m_transport;
     std::string m_uniqueName;
     std::thread::id m_dispatchingThread;
-    std::queue<std::shared_ptr<Message>> m_incomingMessages;
-    std::mutex m_outgoingLock;
-    std::queue<OutgoingMessage> m_outgoingMessages;
-    std::mutex m_expectingResponsesLock;
-    std::map<uint32_t, std::shared_ptr<ExpectingResponse>> m_expectingResponses;
+    priv::IncomingQueue m_incomingMessages;
+    sigc::signal<void(bool)> m_incomingWatermark;
+    /* Held by whoever is writing to the transport */
+    std::mutex m_writeLock;
+    priv::OutgoingQueue m_outgoingMessages;
+    priv::ReplyWaiterTable m_replyWaiters;
+    priv::SignalRoutingTable m_signalRoutes;
+    std::map<std::thread::id, std::unique_ptr<priv::SignalRoutingTable>> m_threadSignalRoutes;
+    std::map<std::thread::id, std::vector<std::shared_ptr<const SignalMessage>>> m_threadSignals;
+    mutable std::mutex m_pendingCallsLock;
+    PendingCalls m_pendingCalls;
+    /* Locked by m_pendingCallsLock */
+    priv::TimerWheel m_callTimeouts;
+    /* Functions waiting on m_callTimeouts to be run; locked by m_pendingCallsLock */
+    std::unordered_map<uint32_t, std::function<void()>> m_delayedCallbacks;
     DispatchStatus m_dispatchStatus;
-    std::mutex m_pathHandlerLock;
-    std::map<std::string, PathHandlingEntry> m_path_handler;
+    priv::ObjectPathRegistry m_objects;
     std::mutex m_threadDispatcherLock;
     std::map<std::thread::id, std::weak_ptr<ThreadDispatcher>> m_threadDispatchers;
     std::shared_ptr<DBusDaemonProxy> m_daemonProxy;
@@ -118,7 +157,24 @@ public:
     std::vector<FreeSignalThreadInfo> m_freeProxySignals;
     std::mutex m_objectProxiesLock;
     std::vector<ObjectProxyThreadInfo> m_objectProxies;
+    /* Locks m_listeningSignals and m_pendingMatchChanges */
+    mutable std::mutex m_matchLock;
     std::map<std::string,int> m_listeningSignals;
+    /* Match rules to change on the bus: 1 to add the rule, -1 to remove it */
+    std::map<std::string,int> m_pendingMatchChanges;
+    std::atomic<bool> m_hasMatchChanges;
+    sigc::signal<void(std::string, std::string)> m_matchError;
+    unsigned int m_threadPoolSize;
+    std::atomic<ThreadPoolOrdering> m_threadPoolOrdering;
+    std::unique_ptr<priv::WorkStealingPool> m_threadPool;
+    std::mutex m_threadPoolLock;
+    std::atomic<bool> m_directBlockingSend;
+    /* In microseconds */
+    std::atomic<int64_t> m_busyPollWindow;
+    std::atomic<uint64_t> m_busyPollHits;
+    std::atomic<uint64_t> m_busyPollMisses;
+    /* In milliseconds */
+    std::atomic<int> m_defaultTimeout;
 };
 
 Connection::Connection( BusType type ) {
@@ -306,43 +362,206 @@ bool Connection::add_match( const std::string& rule ) {
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "Adding the following match: " << rule );
 
     if( m_priv->m_daemonProxy ) {
-        std::map<std::string,int>::iterator it =
-                m_priv->m_listeningSignals.find( rule );
-        if( it == m_priv->m_listeningSignals.end() ){
-            m_priv->m_listeningSignals[ rule ] = 1;
-        }else{
-            int count = m_priv->m_listeningSignals[ rule ];
-            m_priv->m_listeningSignals[ rule ] = count + 1;
+        bool needsAdd = false;
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+            change_match_count( rule, 1 );
+            needsAdd = take_match_change( rule, 1 );
+        }
+
+        if( needsAdd ) {
+            m_priv->m_daemonProxy->AddMatch( rule );
         }
-        m_priv->m_daemonProxy->AddMatch( rule );
     }
 
     return true;
 }
 
 void Connection::add_match_nonblocking( const std::string& rule ) {
-    //    if ( not this->is_valid() ) return;
-    //    dbus_bus_add_match( m_cobj, rule.c_str(), nullptr );
+    if( !is_valid() ) {
+        throw ErrorDisconnected();
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Queueing the following match to add: " << rule );
+
+    if( !m_priv->m_daemonProxy ) { return; }
+
+    bool changed;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+        changed = change_match_count( rule, 1 );
+    }
+
+    if( changed ) { request_match_flush(); }
 }
 
 bool Connection::remove_match( const std::string& rule ) {
     if( m_priv->m_daemonProxy ){
-        std::map<std::string,int>::iterator it =
-                m_priv->m_listeningSignals.find( rule );
-        if( it != m_priv->m_listeningSignals.end() ){
-            int count = m_priv->m_listeningSignals[ rule ];
-            count--;
-            m_priv->m_listeningSignals[ rule ] = count;
-
-            if( count == 0 ){
-                m_priv->m_daemonProxy->RemoveMatch( rule );
-            }
+        bool needsRemove = false;
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+            change_match_count( rule, -1 );
+            needsRemove = take_match_change( rule, -1 );
+        }
+
+        if( needsRemove ){
+            m_priv->m_daemonProxy->RemoveMatch( rule );
         }
     }
 
     return true;
 }
 
+void Connection::remove_match_nonblocking( const std::string& rule ) {
+    if( !m_priv->m_daemonProxy ) { return; }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Queueing the following match to remove: " << rule );
+
+    bool changed;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+        changed = change_match_count( rule, -1 );
+    }
+
+    if( changed && is_valid() ) { request_match_flush(); }
+}
+
+size_t Connection::pending_match_changes() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+
+    return m_priv->m_pendingMatchChanges.size();
+}
+
+sigc::signal<void(std::string, std::string)>& Connection::signal_match_error() {
+    return m_priv->m_matchError;
+}
+
+bool Connection::change_match_count( const std::string& rule, int delta ) {
+    std::map<std::string,int>::iterator it = m_priv->m_listeningSignals.find( rule );
+    int count = ( it == m_priv->m_listeningSignals.end() ) ? 0 : it->second;
+    int busChange = 0;
+
+    if( count + delta < 0 ) {
+        // Removing a rule that we never added
+        return false;
+    }
+
+    count += delta;
+
+    if( count == 0 ) {
+        m_priv->m_listeningSignals.erase( rule );
+        busChange = -1;
+    } else {
+        m_priv->m_listeningSignals[ rule ] = count;
+
+        if( count == 1 && delta > 0 ) { busChange = 1; }
+    }
+
+    if( busChange == 0 ) { return false; }
+
+    int& pending = m_priv->m_pendingMatchChanges[ rule ];
+    pending += busChange;
+
+    if( pending == 0 ) {
+        // An add and a remove that were never sent cancel each other out
+        m_priv->m_pendingMatchChanges.erase( rule );
+    }
+
+    m_priv->m_hasMatchChanges = !m_priv->m_pendingMatchChanges.empty();
+
+    return true;
+}
+
+bool Connection::take_match_change( const std::string& rule, int change ) {
+    std::map<std::string,int>::iterator it = m_priv->m_pendingMatchChanges.find( rule );
+
+    if( it == m_priv->m_pendingMatchChanges.end() || it->second != change ) {
+        return false;
+    }
+
+    m_priv->m_pendingMatchChanges.erase( it );
+    m_priv->m_hasMatchChanges = !m_priv->m_pendingMatchChanges.empty();
+
+    return true;
+}
+
+void Connection::request_match_flush() {
+    m_priv->m_dispatchStatus = DispatchStatus::DATA_REMAINS;
+
+    // Don't dispatch here even if we are the dispatching thread, so that
+    // a bunch of changes made in a row go out together
+    m_priv->m_needsDispatching();
+}
+
+void Connection::queue_match_changes() {
+    if( !m_priv->m_hasMatchChanges ) { return; }
+
+    std::vector<std::string> rules;
+    std::vector<std::shared_ptr<PendingCall>> pending;
+
+    {
+        /*
+         * Hold the lock until the changes are queued, so that anybody else
+         * sending a message waits until the changes are ahead of it.
+         */
+        std::unique_lock<std::mutex> lock( m_priv->m_matchLock );
+        std::vector<std::shared_ptr<const CallMessage>> calls;
+
+        if( m_priv->m_pendingMatchChanges.empty() ) { return; }
+
+        calls.reserve( m_priv->m_pendingMatchChanges.size() );
+        rules.reserve( m_priv->m_pendingMatchChanges.size() );
+
+        for( const std::pair<const std::string, int>& change : m_priv->m_pendingMatchChanges ) {
+            std::shared_ptr<CallMessage> msg = CallMessage::create( "org.freedesktop.DBus",
+                    "/org/freedesktop/DBus",
+                    "org.freedesktop.DBus",
+                    change.second > 0 ? "AddMatch" : "RemoveMatch" );
+            msg << change.first;
+            calls.push_back( msg );
+            rules.push_back( change.first );
+        }
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Sending " << calls.size() << " match rule changes" );
+
+        // Pipeline all of the changes, and check on the replies as they come in
+        pending = queue_pending_calls( calls,
+                std::chrono::steady_clock::now() + std::chrono::milliseconds( m_priv->m_defaultTimeout ) );
+        m_priv->m_pendingMatchChanges.clear();
+        m_priv->m_hasMatchChanges = false;
+    }
+
+    std::weak_ptr<Connection> weakSelf = weak_from_this();
+
+    for( size_t x = 0; x < pending.size(); x++ ) {
+        std::string rule = rules[ x ];
+
+        pending[ x ]->set_notify( [weakSelf, rule]( std::shared_ptr<PendingCall> call ) {
+            std::shared_ptr<const Message> reply = call->reply();
+
+            if( call->is_canceled() ) { return; }
+
+            if( reply && reply->type() == MessageType::RETURN ) { return; }
+
+            std::string errorName = DBUSCXX_ERROR_NO_REPLY;
+
+            if( reply && reply->type() == MessageType::ERROR ) {
+                errorName = std::static_pointer_cast<const ErrorMessage>( reply )->name();
+            }
+
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to change match rule " << rule << ": " << errorName );
+
+            std::shared_ptr<Connection> self = weakSelf.lock();
+
+            if( self ) { self->m_priv->m_matchError.emit( rule, errorName ); }
+        } );
+    }
+}
+
 bool Connection::is_connected() const {
     //    if ( not this->is_valid() ) return false;
     //    return dbus_connection_get_is_connected( m_cobj );
@@ -372,201 +591,693 @@ uint32_t Connection::send( std::shared_ptr<const Message> msg ) {
 
     if( !msg ) { return 0; }
 
-    if( m_priv->m_currentSerial == 0 ) { m_priv->m_currentSerial = 1; }
+    if( !msg->is_valid() ) {
+        // Replies to calls that did not want a reply are invalid; drop them
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Not sending invalid message" );
+        return 0;
+    }
+
+    queue_match_changes();
+
+    uint32_t serial = m_priv->next_serial();
+    m_priv->m_outgoingMessages.push( msg, serial );
+
+    notify_dispatcher_or_dispatch();
+
+    return serial;
+}
+
+Connection& Connection::operator <<( std::shared_ptr<const Message> msg ) {
+    if( msg ) { this->send( msg ); }
+
+    return *this;
+}
+
+std::shared_ptr<ReturnMessage> Connection::send_with_reply_blocking( std::shared_ptr<const CallMessage> message, int timeout_milliseconds ) {
+
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+
+    if( !message ) { return std::shared_ptr<ReturnMessage>(); }
+
+    std::shared_ptr<ReturnMessage> retmsg;
+    int msToWait = timeout_milliseconds;
+
+    if( msToWait == -1 ) {
+        msToWait = m_priv->m_defaultTimeout;
+    }
+
+    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
+        uint32_t replySerialExpceted;
+        bool gotReply = false;
+
+        /*
+         * We are trying to do a blocking method call in the dispatching thread.
+         * Don't queue up this message, just send it, after anything that
+         * is already queued.
+         */
+        queue_match_changes();
+        flush();
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_writeLock );
+            replySerialExpceted = write_single_message( message );
+        }
+
+        /*
+         * Read messages until we find the one with the serial that we are expecting.
+         * The time spent spinning counts against the timeout as well, so
+         * keep track of the deadline rather than just the time spent polling.
+         */
+        std::vector<int> fds;
+        fds.push_back( m_priv->m_transport->fd() );
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+
+        do {
+            std::shared_ptr<Message> incoming = busy_poll_read( false );
+
+            if( !incoming ) {
+                msToWait = std::chrono::ceil<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now() ).count();
+
+                if( msToWait <= 0 ) {
+                    throw ErrorNoReply( "Did not receive a response in the alotted time" );
+                }
+
+                DBus::priv::wait_for_fd_activity( fds, msToWait );
+
+                if( std::chrono::steady_clock::now() >= deadline ) {
+                    throw ErrorNoReply( "Did not receive a response in the alotted time" );
+                }
+
+                if( !m_priv->m_transport->is_valid() ) {
+                    throw ErrorDisconnected();
+                }
+
+                incoming = m_priv->m_transport->readMessage();
+            }
+            {
+                std::ostringstream str;
+                str << incoming.get();
+                SIMPLELOGGER_DEBUG( LOGGER_NAME, "Got incoming " << str.str() );
+            }
+
+            if( incoming ) {
+                // Check to see what type of message we have, and if it might be a reply to our
+                // method call.
+                if( incoming->type() == MessageType::ERROR ) {
+                    std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( incoming );
+
+                    if( errmsg->reply_serial() == replySerialExpceted ) {
+                        errmsg->throw_error();
+                    }
+                } else if( incoming->type() == MessageType::RETURN ) {
+                    retmsg = std::static_pointer_cast<ReturnMessage>( incoming );
+
+                    if( retmsg->reply_serial() == replySerialExpceted ) {
+                        gotReply = true;
+                    }
+                }
+
+                if( !gotReply ) {
+                    queue_incoming_message( incoming );
+                }
+
+            }
+        } while( !gotReply );
+
+    } else {
+        /*
+         * We are trying to do a blocking method call in a thread that is not the dispatcher thread.
+         * Queue up the message and notify the dispatcher thread.
+         */
+        priv::ReplyWaiterTable::Slot* slot;
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+
+        {
+            /*
+             * Add the waiter before the message is queued, so that the
+             * dispatcher can't get the reply before we know about it.
+             */
+            queue_match_changes();
+
+            uint32_t serial = m_priv->next_serial();
+            slot = m_priv->m_replyWaiters.add_waiter( serial );
+
+            if( !m_priv->m_directBlockingSend || !write_directly( message, serial ) ) {
+                m_priv->m_outgoingMessages.push( message, serial );
+                notify_dispatcher_or_dispatch();
+            }
+        }
+
+        std::chrono::microseconds spinWindow( m_priv->m_busyPollWindow.load() );
+
+        if( spinWindow.count() > 0 ) {
+            if( m_priv->m_replyWaiters.spin_for_reply( slot, spinWindow ) ) {
+                m_priv->m_busyPollHits++;
+            } else {
+                m_priv->m_busyPollMisses++;
+            }
+        }
+
+        /*
+         * Wait for the dispatching thread to hand us the response
+         */
+        std::shared_ptr<Message> gotMessage = m_priv->m_replyWaiters.wait_for_reply( slot, deadline );
+
+        if( !gotMessage ) {
+            throw ErrorNoReply( "Did not receive a response in the alotted time" );
+        }
+
+        if( gotMessage->type() == MessageType::RETURN ) {
+            retmsg = std::static_pointer_cast<ReturnMessage>( gotMessage );
+        } else if( gotMessage->type() == MessageType::ERROR ) {
+            std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( gotMessage );
+            errmsg->throw_error();
+        } else {
+            throw ErrorUnknown( "Why are we here" );
+        }
+    }
+
+    return retmsg;
+}
+
+std::shared_ptr<PendingCall> Connection::send_with_reply_async( std::shared_ptr<const CallMessage> message, int timeout_milliseconds ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+
+    if( !message ) { return std::shared_ptr<PendingCall>(); }
+
+    int msToWait = timeout_milliseconds;
+
+    if( msToWait == -1 ) {
+        msToWait = m_priv->m_defaultTimeout;
+    }
+
+    std::shared_ptr<PendingCall> pending;
+
+    {
+        /*
+         * Register the call before it is queued, so that the dispatcher
+         * can't get the reply before we know about it.
+         */
+        PendingCallEntry entry;
+
+        queue_match_changes();
+
+        uint32_t serial = m_priv->next_serial();
+
+        pending = PendingCall::create( serial );
+        pending->set_connection( weak_from_this() );
+        entry.call = pending;
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+            entry.timeout = m_priv->m_callTimeouts.schedule(
+                std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait ), serial );
+            m_priv->m_pendingCalls[ serial ] = entry;
+        }
+
+        m_priv->m_outgoingMessages.push( message, serial );
+    }
+
+    notify_dispatcher_or_dispatch();
+
+    return pending;
+}
+
+std::vector<std::shared_ptr<PendingCall>> Connection::send_with_reply_batch_async( const std::vector<std::shared_ptr<const CallMessage>>& msgs, int timeout_milliseconds ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+
+    int msToWait = timeout_milliseconds;
+
+    if( msToWait == -1 ) {
+        msToWait = m_priv->m_defaultTimeout;
+    }
+
+    queue_match_changes();
+
+    std::vector<std::shared_ptr<PendingCall>> pending =
+        queue_pending_calls( msgs, std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait ) );
+
+    notify_dispatcher_or_dispatch();
+
+    return pending;
+}
+
+std::vector<std::shared_ptr<PendingCall>> Connection::send_with_reply_batch( const std::vector<std::shared_ptr<const CallMessage>>& msgs, int timeout_milliseconds ) {
+    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+
+    int msToWait = timeout_milliseconds;
+
+    if( msToWait == -1 ) {
+        msToWait = m_priv->m_defaultTimeout;
+    }
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds( msToWait );
+
+    queue_match_changes();
+
+    std::vector<std::shared_ptr<PendingCall>> pending = queue_pending_calls( msgs, deadline );
+
+    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
+        /*
+         * We are in the dispatching thread, so nobody else is going to read
+         * the replies for us.  Write out the batch now, and read messages
+         * until all of our calls are done; anything else is queued up to be
+         * processed later, the same as send_with_reply_blocking() does.
+         */
+        std::set<uint32_t> outstanding;
+        std::vector<int> fds;
+
+        for( std::shared_ptr<PendingCall> call : pending ) {
+            if( call ) { outstanding.insert( call->serial() ); }
+        }
+
+        flush();
+
+        fds.push_back( m_priv->m_transport->fd() );
+
+        while( !outstanding.empty() ) {
+            std::chrono::steady_clock::duration remaining = deadline - std::chrono::steady_clock::now();
+
+            if( remaining.count() <= 0 ) { break; }
+
+            if( !m_priv->m_transport->is_valid() ) {
+                throw ErrorDisconnected();
+            }
+
+            std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+
+            if( !incoming ) {
+                DBus::priv::wait_for_fd_activity( fds,
+                    std::chrono::ceil<std::chrono::milliseconds>( remaining ).count() );
+                continue;
+            }
+
+            uint32_t reply_serial = 0;
+
+            if( incoming->type() == MessageType::RETURN ) {
+                reply_serial = std::static_pointer_cast<ReturnMessage>( incoming )->reply_serial();
+            } else if( incoming->type() == MessageType::ERROR ) {
+                reply_serial = std::static_pointer_cast<ErrorMessage>( incoming )->reply_serial();
+            }
+
+            if( outstanding.erase( reply_serial ) ) {
+                std::shared_ptr<PendingCall> call = take_pending_call( reply_serial );
+
+                if( call ) { call->set_reply( incoming ); }
+            } else {
+                queue_incoming_message( incoming );
+            }
+        }
+    } else {
+        notify_dispatcher_or_dispatch();
+
+        for( std::shared_ptr<PendingCall> call : pending ) {
+            if( call && !call->block_until( deadline ) ) { break; }
+        }
+    }
+
+    /*
+     * Anything that is still outstanding has timed out.  Don't wait for the
+     * dispatcher to notice this, as some dispatchers only process timeouts
+     * when there is activity on the connection.
+     */
+    for( std::shared_ptr<PendingCall> call : pending ) {
+        if( !call || call->completed() ) { continue; }
+
+        if( take_pending_call( call->serial() ) ) {
+            call->set_reply( std::shared_ptr<Message>() );
+        } else {
+            // The reply is being handed to the call right now
+            call->block();
+        }
+    }
+
+    return pending;
+}
+
+std::vector<std::shared_ptr<PendingCall>> Connection::queue_pending_calls( const std::vector<std::shared_ptr<const CallMessage>>& msgs,
+    std::chrono::steady_clock::time_point deadline ) {
+    std::vector<std::shared_ptr<PendingCall>> pending;
+
+    pending.reserve( msgs.size() );
+
+    {
+        /*
+         * Register all of the calls before any of them are queued, so that the
+         * dispatcher can't get a reply before we know about it.
+         */
+        std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+
+        for( std::shared_ptr<const CallMessage> msg : msgs ) {
+            if( !msg ) {
+                pending.push_back( std::shared_ptr<PendingCall>() );
+                continue;
+            }
+
+            PendingCallEntry entry;
+            uint32_t serial = m_priv->next_serial();
+
+            entry.call = PendingCall::create( serial );
+            entry.call->set_connection( weak_from_this() );
+            entry.timeout = m_priv->m_callTimeouts.schedule( deadline, serial );
+            m_priv->m_pendingCalls[ serial ] = entry;
+            pending.push_back( entry.call );
+        }
+    }
+
+    for( size_t x = 0; x < msgs.size(); x++ ) {
+        if( !pending[ x ] ) { continue; }
+
+        m_priv->m_outgoingMessages.push( msgs[ x ], pending[ x ]->serial() );
+    }
+
+    return pending;
+}
+
+std::shared_ptr<PendingCall> Connection::take_pending_call( uint32_t serial ) {
+    std::shared_ptr<PendingCall> pending;
+    std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+    PendingCalls::iterator it = m_priv->m_pendingCalls.find( serial );
+
+    if( it != m_priv->m_pendingCalls.end() ) {
+        pending = it->second.call;
+        m_priv->m_callTimeouts.cancel( it->second.timeout );
+        m_priv->m_pendingCalls.erase( it );
+    }
+
+    return pending;
+}
+
+int Connection::timeout_fd() const {
+    return m_priv->m_callTimeouts.fd();
+}
+
+void Connection::set_default_timeout( std::chrono::milliseconds timeout ) {
+    m_priv->m_defaultTimeout = timeout.count();
+}
+
+std::chrono::milliseconds Connection::default_timeout() const {
+    return std::chrono::milliseconds( m_priv->m_defaultTimeout.load() );
+}
+
+void Connection::run_on_dispatcher( std::function<void()> callback, std::chrono::milliseconds delay ) {
+    if( !callback ) { return; }
+
+    // Take a serial so that the id can't be the same as a pending call's
+    uint32_t id = m_priv->next_serial();
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+        m_priv->m_callTimeouts.schedule( std::chrono::steady_clock::now() + delay, id );
+        m_priv->m_delayedCallbacks[ id ] = callback;
+    }
+
+    // Let the dispatcher pick up the new timeout, without calling it here
+    m_priv->m_dispatchStatus = DispatchStatus::DATA_REMAINS;
+    m_priv->m_needsDispatching();
+}
+
+int Connection::next_timeout_milliseconds() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+
+    if( m_priv->m_callTimeouts.empty() ) { return -1; }
+
+    std::chrono::steady_clock::duration remaining =
+        m_priv->m_callTimeouts.next_expiry() - std::chrono::steady_clock::now();
+
+    if( remaining.count() <= 0 ) { return 0; }
+
+    // Round up so that we don't wake up just before the timeout
+    return std::chrono::ceil<std::chrono::milliseconds>( remaining ).count();
+}
+
+void Connection::process_pending_call_timeouts() {
+    std::vector<std::shared_ptr<PendingCall>> timedOut;
+    std::vector<std::function<void()>> callbacks;
+    std::vector<uint32_t> expired;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_pendingCallsLock );
+
+        m_priv->m_callTimeouts.advance( std::chrono::steady_clock::now(), &expired );
+
+        for( uint32_t serial : expired ) {
+            PendingCalls::iterator it = m_priv->m_pendingCalls.find( serial );
+
+            if( it != m_priv->m_pendingCalls.end() ) {
+                timedOut.push_back( it->second.call );
+                m_priv->m_pendingCalls.erase( it );
+                continue;
+            }
+
+            std::unordered_map<uint32_t, std::function<void()>>::iterator callback =
+                m_priv->m_delayedCallbacks.find( serial );
+
+            if( callback != m_priv->m_delayedCallbacks.end() ) {
+                callbacks.push_back( std::move( callback->second ) );
+                m_priv->m_delayedCallbacks.erase( callback );
+            }
+        }
+    }
+
+    // A call without a reply throws ErrorNoReply to whoever is waiting on it
+    for( std::shared_ptr<PendingCall> call : timedOut ) {
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Asynchronous call with serial " << call->serial() << " timed out" );
+        call->set_reply( std::shared_ptr<Message>() );
+    }
+
+    for( std::function<void()>& callback : callbacks ) {
+        callback();
+    }
+}
+
+void Connection::flush() {
+    if( !this->is_valid() ) { return; }
+
+    if( m_priv->m_outgoingMessages.empty() ) { return; }
+
+    std::vector<uint32_t> unserializable;
+
+    {
+        // Only the writer waits on this lock; threads that are sending
+        // messages just push them onto the queue
+        std::unique_lock lock( m_priv->m_writeLock );
+        std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>> toWrite;
+
+        if( m_priv->m_outgoingMessages.pop_all( &toWrite ) == 0 ) { return; }
+
+        // Write everything at once, so that queued up calls are pipelined
+        m_priv->m_transport->writeMessages( toWrite, &unserializable );
+    }
+
+    for( uint32_t serial : unserializable ) {
+        fail_unsent_message( serial );
+    }
+}
+
+void Connection::fail_unsent_message( uint32_t serial ) {
+    SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to serialize message with serial " << serial );
+
+    std::shared_ptr<ErrorMessage> errmsg = ErrorMessage::create();
+    errmsg->set_reply_serial( serial );
+    errmsg->set_name( DBUSCXX_ERROR_FAILED );
+    errmsg->set_message( "Unable to serialize the message" );
+
+    if( m_priv->m_replyWaiters.complete( serial, errmsg ) ) {
+        return;
+    }
+
+    std::shared_ptr<PendingCall> pending = take_pending_call( serial );
+
+    if( pending ) {
+        pending->set_reply( errmsg );
+    }
+}
+
+std::shared_ptr<Message> Connection::busy_poll_read( bool stopForOutgoing ) {
+    std::chrono::microseconds window( m_priv->m_busyPollWindow.load() );
+
+    if( window.count() <= 0 ) { return std::shared_ptr<Message>(); }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + window;
+
+    do {
+        std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+
+        if( incoming ) {
+            m_priv->m_busyPollHits++;
+            return incoming;
+        }
+
+        if( !m_priv->m_transport->is_valid() ||
+            ( stopForOutgoing && !m_priv->m_outgoingMessages.empty() ) ) {
+            // There's something else to do; this isn't a hit or a miss
+            return std::shared_ptr<Message>();
+        }
+    } while( std::chrono::steady_clock::now() < end );
+
+    m_priv->m_busyPollMisses++;
+
+    return std::shared_ptr<Message>();
+}
+
+bool Connection::busy_poll() {
+    if( !this->is_valid() ) { return false; }
+
+    if( m_priv->m_incomingMessages.reading_paused() ) { return false; }
+
+    if( std::this_thread::get_id() != m_priv->m_dispatchingThread ) {
+        throw ErrorIncorrectDispatchThread( "Calling Connection::busy_poll from non-dispatching thread" );
+    }
+
+    std::shared_ptr<Message> incoming = busy_poll_read( true );
 
-    OutgoingMessage outgoing;
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_outgoingLock );
-        outgoing.msg = msg;
-        outgoing.serial = m_priv->m_currentSerial++;
-        m_priv->m_outgoingMessages.push( outgoing );
+    if( incoming ) {
+        queue_incoming_message( incoming );
+        m_priv->m_dispatchStatus = DispatchStatus::DATA_REMAINS;
+        return true;
     }
 
-    notify_dispatcher_or_dispatch();
-
-    return outgoing.serial;
+    return !m_priv->m_outgoingMessages.empty();
 }
 
-Connection& Connection::operator <<( std::shared_ptr<const Message> msg ) {
-    if( msg ) { this->send( msg ); }
+void Connection::set_busy_poll_window( std::chrono::microseconds window ) {
+    m_priv->m_busyPollWindow = window.count();
+}
 
-    return *this;
+std::chrono::microseconds Connection::busy_poll_window() const {
+    return std::chrono::microseconds( m_priv->m_busyPollWindow.load() );
 }
 
-std::shared_ptr<ReturnMessage> Connection::send_with_reply_blocking( std::shared_ptr<const CallMessage> message, int timeout_milliseconds ) {
+BusyPollStats Connection::busy_poll_stats() const {
+    BusyPollStats stats;
 
-    if( !this->is_valid() ) { throw ErrorDisconnected(); }
+    stats.hits = m_priv->m_busyPollHits;
+    stats.misses = m_priv->m_busyPollMisses;
 
-    if( !message ) { return std::shared_ptr<ReturnMessage>(); }
+    return stats;
+}
 
-    std::shared_ptr<ReturnMessage> retmsg;
-    int msToWait = timeout_milliseconds;
+void Connection::queue_incoming_message( std::shared_ptr<Message> msg ) {
+    // A thread that is blocked waiting for this reply can have it right
+    // away, instead of after everything that is queued up ahead of it
+    if( msg->type() == MessageType::RETURN &&
+        m_priv->m_replyWaiters.complete( std::static_pointer_cast<ReturnMessage>( msg )->reply_serial(), msg ) ) {
+        return;
+    } else if( msg->type() == MessageType::ERROR &&
+        m_priv->m_replyWaiters.complete( std::static_pointer_cast<ErrorMessage>( msg )->reply_serial(), msg ) ) {
+        return;
+    }
 
-    if( msToWait == -1 ) {
-        // Use a sane default value
-        msToWait = 20000;
+    if( m_priv->m_incomingMessages.push( msg ) != priv::IncomingQueue::PushResult::Rejected ) {
+        return;
     }
 
-    if( m_priv->m_dispatchingThread == std::this_thread::get_id() ) {
-        uint32_t replySerialExpceted;
-        bool gotReply = false;
+    std::shared_ptr<CallMessage> callmsg = std::static_pointer_cast<CallMessage>( msg );
 
-        /*
-         * We are trying to do a blocking method call in the dispatching thread.
-         * Don't queue up this message, just send it.
-         */
-        {
-            std::unique_lock<std::mutex> lock( m_priv->m_outgoingLock );
-            replySerialExpceted = write_single_message( message );
-        }
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Incoming queue is full; rejecting call with serial " << callmsg->serial() );
 
-        /*
-         * Read messages until we find the one with the serial that we are expecting
-         */
-        std::vector<int> fds;
-        fds.push_back( m_priv->m_transport->fd() );
+    std::shared_ptr<ErrorMessage> errmsg = callmsg->create_error_reply();
+    errmsg->set_name( DBUSCXX_ERROR_LIMITS_EXCEEDED );
+    errmsg->set_message( "Too many messages waiting to be processed" );
 
-        do {
-            std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> fdResponse =
-                DBus::priv::wait_for_fd_activity( fds, msToWait );
+    if( !errmsg->is_valid() ) { return; }
 
-            msToWait -= std::get<3>( fdResponse ).count();
+    // We are on the dispatching thread here, possibly in the middle of a
+    // dispatch; queue the reply up directly and let the dispatch flush it,
+    // instead of going through send() and dispatching again.
+    m_priv->m_outgoingMessages.push( errmsg, m_priv->next_serial() );
+    m_priv->m_dispatchStatus = DispatchStatus::DATA_REMAINS;
+}
 
-            if( msToWait <= 0 ) {
-                throw ErrorNoReply( "Did not receive a response in the alotted time" );
-            }
+void Connection::set_incoming_queue_limits( size_t maxMessages, size_t maxBytes ) {
+    m_priv->m_incomingMessages.set_limits( maxMessages, maxBytes );
+}
 
-            if( !m_priv->m_transport->is_valid() ) {
-                throw ErrorDisconnected();
-            }
+void Connection::set_incoming_overflow_policy( IncomingOverflowPolicy policy ) {
+    m_priv->m_incomingMessages.set_policy( policy );
+}
 
-            std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
-            {
-                std::ostringstream str;
-                str << incoming.get();
-                SIMPLELOGGER_DEBUG( LOGGER_NAME, "Got incoming " << str.str() );
-            }
+IncomingOverflowPolicy Connection::incoming_overflow_policy() const {
+    return m_priv->m_incomingMessages.policy();
+}
 
-            if( incoming ) {
-                // Check to see what type of message we have, and if it might be a reply to our
-                // method call.
-                if( incoming->type() == MessageType::ERROR ) {
-                    std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( incoming );
+IncomingQueueStats Connection::incoming_queue_stats() const {
+    IncomingQueueStats stats;
 
-                    if( errmsg->reply_serial() == replySerialExpceted ) {
-                        errmsg->throw_error();
-                    }
-                } else if( incoming->type() == MessageType::RETURN ) {
-                    retmsg = std::static_pointer_cast<ReturnMessage>( incoming );
+    stats.messages = m_priv->m_incomingMessages.size();
+    stats.bytes = m_priv->m_incomingMessages.bytes();
+    stats.peakMessages = m_priv->m_incomingMessages.peak_size();
+    stats.droppedSignals = m_priv->m_incomingMessages.dropped_signals();
+    stats.rejectedCalls = m_priv->m_incomingMessages.rejected_calls();
+    stats.pausedReads = m_priv->m_incomingMessages.paused_reads();
+    stats.highWatermarkCrossings = m_priv->m_incomingMessages.high_watermark_crossings();
 
-                    if( retmsg->reply_serial() == replySerialExpceted ) {
-                        gotReply = true;
-                    }
-                }
+    return stats;
+}
 
-                if( !gotReply ) {
-                    m_priv->m_incomingMessages.push( incoming );
-                }
+sigc::signal<void(bool)>& Connection::signal_incoming_queue_watermark() {
+    return m_priv->m_incomingWatermark;
+}
 
-            }
-        } while( !gotReply );
+void Connection::set_fair_call_scheduling( bool fair ) {
+    m_priv->m_incomingMessages.set_fair_scheduling( fair );
+}
 
-    } else {
-        /*
-         * We are trying to do a blocking method call in a thread that is not the dispatcher thread.
-         * Queue up the message and notify the dispatcher thread.
-         */
-        uint32_t serial;
-        std::shared_ptr<ExpectingResponse> ex;
+bool Connection::fair_call_scheduling() const {
+    return m_priv->m_incomingMessages.fair_scheduling();
+}
 
-        {
-            OutgoingMessage outgoing;
-            std::scoped_lock<std::mutex, std::mutex> lock( m_priv->m_outgoingLock, m_priv->m_expectingResponsesLock );
-            outgoing.msg = message;
-            outgoing.serial = m_priv->m_currentSerial++;
-            m_priv->m_outgoingMessages.push( outgoing );
-            serial = outgoing.serial;
-
-            // Add this to our expecting responses
-            ex = std::make_shared<ExpectingResponse>();
-            m_priv->m_expectingResponses[ serial ] = ex;
-        }
+void Connection::set_fair_call_quantum( unsigned int quantum ) {
+    m_priv->m_incomingMessages.set_fair_quantum( quantum );
+}
 
-        notify_dispatcher_or_dispatch();
+unsigned int Connection::fair_call_quantum() const {
+    return m_priv->m_incomingMessages.fair_quantum();
+}
 
-        {
-            /*
-             * Lock on the expecting response; when the response comes in, we will notify from
-             * the dispatching thread
-             */
-            std::chrono::time_point now = std::chrono::steady_clock::now();
-            std::unique_lock<std::mutex> lock( ex->cv_lock );
-            bool status = ex->cv.wait_until( lock, now + std::chrono::milliseconds( msToWait ), [this, serial] {
-                std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-                std::map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
-                    m_priv->m_expectingResponses.find( serial );
-
-                // return false if the waiting should be continued
-                return ( *it ).second->reply.get() != nullptr;
-            } );
-            std::shared_ptr<ExpectingResponse> resp;
+void Connection::set_incoming_lane_weights( unsigned int replies, unsigned int calls, unsigned int signals ) {
+    m_priv->m_incomingMessages.set_lane_weights( replies, calls, signals );
+}
 
-            {
-                /*
-                 * Now remove our expecting response to free up memory
-                 */
-                std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-                std::map<uint32_t, std::shared_ptr<ExpectingResponse>>::iterator it =
-                        m_priv->m_expectingResponses.find( serial );
-                resp = ( *it ).second;
-
-                m_priv->m_expectingResponses.erase( it );
-            }
+std::map<std::string, size_t> Connection::sender_queue_depths() const {
+    return m_priv->m_incomingMessages.sender_depths();
+}
 
-            if( !resp ) {
-                throw ErrorUnexpectedResponse();
-            }
+bool Connection::write_directly( std::shared_ptr<const Message> msg, uint32_t serial ) {
+    // Anything already queued must go out first, and if somebody else is
+    // writing right now then we would only be waiting on them
+    if( !m_priv->m_outgoingMessages.empty() ) { return false; }
 
-            if( status ) {
-                std::shared_ptr<Message> gotMessage = resp->reply;
-
-                if( gotMessage->type() == MessageType::RETURN ) {
-                    retmsg = std::static_pointer_cast<ReturnMessage>( gotMessage );
-                } else if( gotMessage->type() == MessageType::ERROR ) {
-                    std::shared_ptr<ErrorMessage> errmsg = std::static_pointer_cast<ErrorMessage>( gotMessage );
-                    errmsg->throw_error();
-                } else if( gotMessage->type() == MessageType::SIGNAL ) {
-                } else {
-                    throw ErrorUnknown( "Why are we here" );
-                }
-            } else {
-                throw ErrorNoReply( "Did not receive a response in the alotted time" );
-            }
-        }
-    }
+    std::unique_lock<std::mutex> lock( m_priv->m_writeLock, std::try_to_lock );
 
-    return retmsg;
-}
+    if( !lock.owns_lock() || !m_priv->m_outgoingMessages.empty() ) { return false; }
 
-void Connection::flush() {
-    if( !this->is_valid() ) { return; }
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Writing message with serial " << serial << " from the calling thread" );
 
-    {
-        std::unique_lock lock( m_priv->m_outgoingLock );
+    // The reply is read by the dispatcher like any other message; it will
+    // wake up as soon as the reply comes in on the transport.  If the write
+    // fails the transport is no longer valid, so there is no point in
+    // queueing the message up again.
+    ssize_t written = m_priv->m_transport->writeMessage( msg, serial );
 
-        while( !m_priv->m_outgoingMessages.empty() ) {
-            OutgoingMessage outgoing = m_priv->m_outgoingMessages.front();
-            m_priv->m_outgoingMessages.pop();
+    lock.unlock();
 
-            m_priv->m_transport->writeMessage( outgoing.msg, outgoing.serial );
-        }
+    if( written == 0 ) {
+        fail_unsent_message( serial );
     }
+
+    return true;
 }
 
 uint32_t Connection::write_single_message( std::shared_ptr<const Message> msg ) {
-    uint32_t retval = m_priv->m_currentSerial;
-    m_priv->m_transport->writeMessage( msg, m_priv->m_currentSerial++ );
-    return retval;
+    uint32_t serial = m_priv->next_serial();
+    m_priv->m_transport->writeMessage( msg, serial );
+    return serial;
 }
 
 DispatchStatus Connection::dispatch_status( ) const {
@@ -575,6 +1286,29 @@ DispatchStatus Connection::dispatch_status( ) const {
     return m_priv->m_dispatchStatus;
 }
 
+int Connection::read_incoming_messages( int maxMessages ) {
+    int numRead = 0;
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Try to read a message" );
+
+    while( numRead < maxMessages ) {
+        if( m_priv->m_incomingMessages.reading_paused() ) {
+            // Leave the rest on the socket until we have caught up
+            m_priv->m_incomingMessages.count_paused_read();
+            break;
+        }
+
+        std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+
+        if( !incoming ) { break; }
+
+        queue_incoming_message( incoming );
+        numRead++;
+    }
+
+    return numRead;
+}
+
 DispatchStatus Connection::dispatch( ) {
     if( std::this_thread::get_id() != m_priv->m_dispatchingThread ) {
         throw ErrorIncorrectDispatchThread( "Calling Connection::dispatch from non-dispatching thread" );
@@ -586,20 +1320,30 @@ DispatchStatus Connection::dispatch( ) {
     }
 
     // Write out any messages we have waiting to be written
+    queue_match_changes();
     flush();
 
-    // Try to read a message
-    {
-        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Try to read a message" );
-        std::shared_ptr<Message> incoming = m_priv->m_transport->readMessage();
+    process_pending_call_timeouts();
 
-        if( incoming ) {
-            m_priv->m_incomingMessages.push( incoming );
-        }
+    // Read all of the messages that are available, so that messages that
+    // come in together are processed together
+    int numRead = read_incoming_messages( MAX_MESSAGES_PER_DISPATCH );
+
+    // Process as many messages as we could have read, so that the queue
+    // can't keep growing while messages keep coming in.  What has been sent
+    // is written and what came in is read in between, so that a call or a
+    // reply can still get ahead of the signals that are queued up.
+    for( int x = 0; x < MAX_MESSAGES_PER_DISPATCH; x++ ) {
+        if( m_priv->m_incomingMessages.empty() ) { break; }
+
+        process_single_message();
+
+        flush();
+        numRead += read_incoming_messages( MAX_MESSAGES_PER_DISPATCH - numRead );
     }
 
-    // Process any messages that we need to
-    process_single_message();
+    // Hand the signals from this round to the ThreadDispatchers in one batch
+    send_thread_signals();
 
     if( m_priv->m_outgoingMessages.empty() &&
         m_priv->m_incomingMessages.empty() ) {
@@ -616,8 +1360,7 @@ void Connection::process_single_message() {
 
     if( m_priv->m_incomingMessages.empty() ) { return; }
 
-    msgToProcess = m_priv->m_incomingMessages.front();
-    m_priv->m_incomingMessages.pop();
+    msgToProcess = m_priv->m_incomingMessages.pop();
 
     if( msgToProcess->type() == MessageType::RETURN ||
         msgToProcess->type() == MessageType::ERROR ) {
@@ -629,16 +1372,22 @@ void Connection::process_single_message() {
             reply_serial = std::static_pointer_cast<ErrorMessage>( msgToProcess )->reply_serial();
         }
 
-        {
-            std::unique_lock<std::mutex> lock( m_priv->m_expectingResponsesLock );
-            if( m_priv->m_expectingResponses.find( reply_serial ) != m_priv->m_expectingResponses.end() ) {
-                // This is a response to something that a different thread is waiting for.
-                // Update the data and notify the thread!
-                m_priv->m_expectingResponses[ reply_serial ]->reply = msgToProcess;
-                m_priv->m_expectingResponses[ reply_serial ]->cv.notify_one();
-                return;
-            }
+        if( m_priv->m_replyWaiters.complete( reply_serial, msgToProcess ) ) {
+            // This is a response to something that a different thread is waiting for.
+            return;
+        }
+
+        std::shared_ptr<PendingCall> pending = take_pending_call( reply_serial );
+
+        if( pending ) {
+            // This is a response to an asynchronous call; complete it here
+            pending->set_reply( msgToProcess );
+            return;
         }
+
+        // The call was canceled, or has already timed out
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Dropping reply to " << reply_serial << "; nobody is waiting for it" );
+        return;
     }
 
     std::shared_ptr<CallMessage> callmsg;
@@ -656,70 +1405,203 @@ void Connection::process_single_message() {
 }
 
 void Connection::process_call_message( std::shared_ptr<const CallMessage> callmsg ) {
-    std::string path = callmsg->path();
-    PathHandlingEntry entry;
-    bool error = false;
-
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_pathHandlerLock );
-        std::map<std::string, PathHandlingEntry>::iterator it;
-        it = m_priv->m_path_handler.find( path );
-
-        if( it != m_priv->m_path_handler.end() ) {
-            entry = it->second;
-        } else {
-            error = true;
-        }
-    }
+    // Look the path up in place, without copying it out of the message
+    priv::ObjectPathRegistry::Entry entry =
+        m_priv->m_objects.lookup( callmsg->header_field_view( MessageHeaderFields::Path ) );
 
-    if( error && callmsg ) {
-        std::shared_ptr<ErrorMessage> errMsg =
-            ErrorMessage::create( callmsg, DBUSCXX_ERROR_FAILED, "Could not find given path" );
+    if( !entry.handler ) {
+        std::shared_ptr<ErrorMessage> errMsg = callmsg->create_error_reply();
+        errMsg->set_name( DBUSCXX_ERROR_FAILED );
+        errMsg->set_message( "Could not find given path" );
         send( errMsg );
         return;
     }
 
-    if( entry.handlingThread == m_priv->m_dispatchingThread ) {
+    if( !entry.handlingThread ) {
+        // Not associated with any thread; see thread_id_from_calling()
+        submit_to_thread_pool( entry.handler, callmsg );
+    } else if( *entry.handlingThread == m_priv->m_dispatchingThread ) {
         // We are in the dispatching thread here, so we can simply call the handle method
         HandlerResult res = entry.handler->handle_message( callmsg );
         send_error_on_handler_result( callmsg, res );
     } else {
         // A different thread needs to handle this.
-        std::shared_ptr<ThreadDispatcher> disp = m_priv->m_threadDispatchers[ entry.handlingThread ].lock();
+        std::shared_ptr<ThreadDispatcher> disp = m_priv->m_threadDispatchers[ *entry.handlingThread ].lock();
 
         if( !disp ) {
             // Remove all invalid thread dispatchers, return an error
             remove_invalid_threaddispatchers_and_associated_objects();
 
             if( callmsg ) {
-                std::shared_ptr<ErrorMessage> errMsg =
-                    ErrorMessage::create( callmsg, DBUSCXX_ERROR_FAILED, "Could not find given path" );
+                std::shared_ptr<ErrorMessage> errMsg = callmsg->create_error_reply();
+                errMsg->set_name( DBUSCXX_ERROR_FAILED );
+                errMsg->set_message( "Could not find given path" );
                 send( errMsg );
                 return;
             }
         } else {
+            // Any signals that came in before this call must get there first
+            send_thread_signals();
             disp->add_message( entry.handler, callmsg );
         }
     }
 }
 
+void Connection::start_thread_pool() {
+    std::unique_lock<std::mutex> lock( m_priv->m_threadPoolLock );
+
+    if( !m_priv->m_threadPool ) {
+        m_priv->m_threadPool = std::make_unique<priv::WorkStealingPool>( m_priv->m_threadPoolSize );
+    }
+}
+
+void Connection::submit_to_thread_pool( std::shared_ptr<Object> handler, std::shared_ptr<const CallMessage> callmsg ) {
+    std::weak_ptr<Connection> weakSelf = weak_from_this();
+    std::function<void()> task = [weakSelf, handler, callmsg]() {
+        std::shared_ptr<Connection> self = weakSelf.lock();
+
+        if( !self ) { return; }
+
+        HandlerResult res = handler->handle_message( callmsg );
+        self->send_error_on_handler_result( callmsg, res );
+    };
+
+    submit_to_thread_pool( handler, callmsg, task );
+}
+
+void Connection::submit_to_thread_pool( std::shared_ptr<Object> handler,
+    std::shared_ptr<const CallMessage> callmsg,
+    std::function<void()> task ) {
+    start_thread_pool();
+
+    switch( m_priv->m_threadPoolOrdering.load() ) {
+    case ThreadPoolOrdering::None:
+        m_priv->m_threadPool->submit( task );
+        break;
+
+    case ThreadPoolOrdering::PerObject:
+        m_priv->m_threadPool->submit( handler->path(), task );
+        break;
+
+    case ThreadPoolOrdering::PerSender:
+        m_priv->m_threadPool->submit( callmsg->sender(), task );
+        break;
+    }
+}
+
+void Connection::run_in_handling_thread( std::shared_ptr<const CallMessage> callmsg,
+    std::function<void()> work,
+    std::function<void()> unable ) {
+    std::weak_ptr<Connection> weakSelf = weak_from_this();
+
+    run_on_dispatcher( [weakSelf, callmsg, work, unable]() {
+        std::shared_ptr<Connection> self = weakSelf.lock();
+
+        if( !self ) {
+            unable();
+            return;
+        }
+
+        priv::ObjectPathRegistry::Entry entry =
+            self->m_priv->m_objects.lookup( callmsg->header_field_view( MessageHeaderFields::Path ) );
+
+        if( !entry.handler ) {
+            unable();
+        } else if( !entry.handlingThread ) {
+            self->submit_to_thread_pool( entry.handler, callmsg, work );
+        } else if( *entry.handlingThread == self->m_priv->m_dispatchingThread ) {
+            work();
+        } else {
+            std::shared_ptr<ThreadDispatcher> disp = self->m_priv->m_threadDispatchers[ *entry.handlingThread ].lock();
+
+            if( !disp ) {
+                unable();
+                return;
+            }
+
+            try {
+                disp->add_work( work );
+            } catch( const ErrorNotSupported& ) {
+                unable();
+            }
+        }
+    } );
+}
+
 void Connection::process_signal_message( std::shared_ptr<const SignalMessage> msg ) {
+    if( m_priv->m_signalRoutes.needs_rebuild() ) {
+        rebuild_signal_routes();
+    }
+
+    // Only give the signal to the proxies that could possibly match it
+    for( std::shared_ptr<SignalProxyBase> proxyBase : m_priv->m_signalRoutes.lookup( msg ) ){
+        proxyBase->handle_signal( msg );
+    }
+
+    // Queue this signal up for the ThreadDispatchers that have a proxy for it.
+    // These are sent in one batch per thread once we run out of messages.
+    for( std::pair<const std::thread::id, std::unique_ptr<priv::SignalRoutingTable>>& thrRoutes : m_priv->m_threadSignalRoutes ) {
+        if( thrRoutes.second->lookup( msg ).empty() ) { continue; }
+
+        m_priv->m_threadSignals[ thrRoutes.first ].push_back( msg );
+    }
+}
+
+void Connection::send_thread_signals() {
+    if( m_priv->m_threadSignals.empty() ) { return; }
+
+    std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
+
+    for( std::pair<const std::thread::id, std::vector<std::shared_ptr<const SignalMessage>>>& thrSignals : m_priv->m_threadSignals ) {
+        std::map<std::thread::id, std::weak_ptr<ThreadDispatcher>>::iterator it =
+            m_priv->m_threadDispatchers.find( thrSignals.first );
+
+        if( it == m_priv->m_threadDispatchers.end() ) { continue; }
+
+        std::shared_ptr<ThreadDispatcher> disp = it->second.lock();
+
+        if( disp ) {
+            disp->add_signals( thrSignals.second );
+        }
+    }
+
+    m_priv->m_threadSignals.clear();
+}
+
+
+void Connection::invalidate_signal_routes() {
+    m_priv->m_signalRoutes.invalidate();
+}
+
+void Connection::rebuild_signal_routes() {
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Rebuilding signal routes" );
+
+    m_priv->m_signalRoutes.clear();
+    m_priv->m_threadSignalRoutes.clear();
+
     {
-        // See if any of our free handlers can handle this
         std::unique_lock<std::mutex> lock( m_priv->m_freeProxySignalsLock );
 
         for( FreeSignalThreadInfo& sigInfo : m_priv->m_freeProxySignals ) {
-            if( sigInfo.handlingThread != m_priv->m_dispatchingThread ){
+            if( sigInfo.handlingThread == m_priv->m_dispatchingThread ){
+                m_priv->m_signalRoutes.add( sigInfo.handler );
                 continue;
             }
 
-            sigInfo.handler->handle_signal( msg );
+            // This proxy is handled by a ThreadDispatcher; keep track of which one
+            std::unique_ptr<priv::SignalRoutingTable>& thrRoutes =
+                m_priv->m_threadSignalRoutes[ sigInfo.handlingThread ];
+
+            if( !thrRoutes ) {
+                thrRoutes = std::make_unique<priv::SignalRoutingTable>();
+                thrRoutes->clear();
+            }
+
+            thrRoutes->add( sigInfo.handler );
         }
     }
 
-    std::vector<std::shared_ptr<SignalProxyBase>> proxies;
     {
-        // Tell all of our normal ObjectProxy classes to handle it as well
         std::unique_lock lock( m_priv->m_objectProxiesLock );
 
         for( ObjectProxyThreadInfo& thrInfo : m_priv->m_objectProxies ){
@@ -727,33 +1609,15 @@ void Connection::process_signal_message( std::shared_ptr<const SignalMessage> ms
                 continue;
             }
 
-            for( std::pair<std::string,std::shared_ptr<InterfaceProxy>> iface : thrInfo.handler->interfaces() ){
+            for( const std::pair<const std::string, std::shared_ptr<InterfaceProxy>>& iface : thrInfo.handler->interfaces() ){
                 for( std::shared_ptr<SignalProxyBase> signal : iface.second->signals() ){
-                    proxies.push_back( signal );
+                    m_priv->m_signalRoutes.add( signal );
                 }
             }
         }
     }
-
-    for( std::shared_ptr<SignalProxyBase> proxyBase : proxies ){
-        proxyBase->handle_signal( msg );
-    }
-
-    // Give this signal to all of our ThreadDispatchers as well
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
-
-        for( auto const& x : m_priv->m_threadDispatchers ) {
-            std::shared_ptr<ThreadDispatcher> disp = x.second.lock();
-
-            if( disp ) {
-                disp->add_signal( msg );
-            }
-        }
-    }
 }
 
-
 void Connection::send_error_on_handler_result( std::shared_ptr<const CallMessage> callmsg, HandlerResult result ) {
     if( result == HandlerResult::Handled ) {
         return;
@@ -828,27 +1692,28 @@ std::shared_ptr<Object> Connection::create_object( const std::string& path, Thre
 }
 
 RegistrationStatus Connection::register_object( std::shared_ptr<Object> object, ThreadForCalling calling ) {
-    if( !object ) { return RegistrationStatus::Failed_Invalid_Object; }
+    return register_object( object, calling, false );
+}
 
-    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Connection::register_object at path " << object->path() );
+RegistrationStatus Connection::register_fallback_object( std::shared_ptr<Object> object, ThreadForCalling calling ) {
+    return register_object( object, calling, true );
+}
 
-    std::unique_lock<std::mutex> lock( m_priv->m_pathHandlerLock );
+RegistrationStatus Connection::register_object( std::shared_ptr<Object> object, ThreadForCalling calling, bool fallback ) {
+    if( !object ) { return RegistrationStatus::Failed_Invalid_Object; }
 
-    if( m_priv->m_path_handler.find( object->path() ) != m_priv->m_path_handler.end() ) {
-        return RegistrationStatus::Failed_Path_in_Use;
-    }
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Connection::register_object at path " << object->path()
+        << ( fallback ? " as fallback" : "" ) );
 
-    PathHandlingEntry entry;
+    priv::ObjectPathRegistry::Entry entry;
     entry.handler = object;
+    entry.handlingThread = thread_id_from_calling( calling );
+    entry.fallback = fallback;
 
-    if( calling == ThreadForCalling::DispatcherThread ) {
-        entry.handlingThread = m_priv->m_dispatchingThread;
-    } else {
-        entry.handlingThread = std::this_thread::get_id();
+    if( !m_priv->m_objects.add( object->path(), entry ) ) {
+        return RegistrationStatus::Failed_Path_in_Use;
     }
 
-    m_priv->m_path_handler[ object->path() ] = entry;
-
     object->set_connection( shared_from_this() );
 
     return RegistrationStatus::Success;
@@ -856,22 +1721,7 @@ RegistrationStatus Connection::register_object( std::shared_ptr<Object> object,
 
 bool Connection::change_object_calling_thread( std::shared_ptr<Object> object,
                                    ThreadForCalling calling ){
-    std::unique_lock lock( m_priv->m_pathHandlerLock );
-    std::map<std::string,PathHandlingEntry>::iterator it = m_priv->m_path_handler.find( object->path() );
-
-    if( it == m_priv->m_path_handler.end() ) {
-        return false;
-    }
-
-    PathHandlingEntry entry = it->second;
-    if( calling == ThreadForCalling::DispatcherThread ) {
-        entry.handlingThread = m_priv->m_dispatchingThread;
-    } else {
-        entry.handlingThread = std::this_thread::get_id();
-    }
-    m_priv->m_path_handler[ object->path() ] = entry;
-
-    return true;
+    return m_priv->m_objects.set_handling_thread( object->path(), thread_id_from_calling( calling ) );
 }
 
 std::shared_ptr<ObjectProxy> Connection::create_object_proxy( const std::string& path, ThreadForCalling calling ) {
@@ -887,16 +1737,7 @@ std::shared_ptr<ObjectProxy> Connection::create_object_proxy( const std::string&
 }
 
 bool Connection::unregister_object( const std::string& path ) {
-    std::unique_lock<std::mutex> lock( m_priv->m_pathHandlerLock );
-    std::map<std::string, PathHandlingEntry>::iterator it;
-    it = m_priv->m_path_handler.find( path );
-
-    if( it != m_priv->m_path_handler.end() ) {
-        m_priv->m_path_handler.erase( it );
-        return true;
-    }
-
-    return false;
+    return m_priv->m_objects.remove( path );
 }
 
 std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_ptr<SignalProxyBase> signal, ThreadForCalling calling ) {
@@ -908,7 +1749,9 @@ std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_
 
     FreeSignalThreadInfo signalThreadinfo;
     signalThreadinfo.handler = signal;
-    signalThreadinfo.handlingThread = thread_id_from_calling( calling );
+    // Signals are not handled on the thread pool, so that they stay in order
+    signalThreadinfo.handlingThread = thread_id_from_calling(
+        calling == ThreadForCalling::ThreadPool ? ThreadForCalling::DispatcherThread : calling ).value();
 
     {
         std::unique_lock<std::mutex> lock( m_priv->m_freeProxySignalsLock );
@@ -916,6 +1759,8 @@ std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_
         m_priv->m_freeProxySignals.push_back( signalThreadinfo );
     }
 
+    invalidate_signal_routes();
+
     if( signalThreadinfo.handlingThread != m_priv->m_dispatchingThread ) {
         // We need to give this signal to the appropriate ThreadDispatcher to handle
         std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
@@ -937,7 +1782,7 @@ std::shared_ptr<SignalProxyBase> Connection::add_free_signal_proxy( std::shared_
         thrDispatch->add_signal_proxy( signal );
     }
 
-    this->add_match( signal->match_rule() );
+    this->add_match_nonblocking( signal->match_rule() );
     signal->set_connection( shared_from_this() );
 
     return signal;
@@ -948,7 +1793,7 @@ bool Connection::remove_free_signal_proxy( std::shared_ptr<SignalProxyBase> sign
 
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "remove_signal_proxy with match rule " << signal->match_rule() );
 
-    this->remove_match( signal->match_rule() );
+    this->remove_match_nonblocking( signal->match_rule() );
 
     bool removed = false;
 
@@ -970,6 +1815,8 @@ bool Connection::remove_free_signal_proxy( std::shared_ptr<SignalProxyBase> sign
         }
     }
 
+    invalidate_signal_routes();
+
     {
         std::unique_lock<std::mutex> lock( m_priv->m_threadDispatcherLock );
 
@@ -1045,6 +1892,7 @@ std::string Connection::introspect( const std::string& destination, const std::s
 
 void Connection::set_dispatching_thread( std::thread::id tid ) {
     m_priv->m_dispatchingThread = tid;
+    invalidate_signal_routes();
 }
 
 void Connection::notify_dispatcher_or_dispatch() {
@@ -1081,17 +1929,7 @@ void Connection::remove_invalid_threaddispatchers_and_associated_objects() {
 
     if( invalidThreadIds.empty() ) { return; }
 
-    {
-        std::unique_lock<std::mutex> lock( m_priv->m_pathHandlerLock );
-
-        for( auto it = m_priv->m_path_handler.begin(); it != m_priv->m_path_handler.end(); ) {
-            if( std::find( invalidThreadIds.begin(), invalidThreadIds.end(), it->second.handlingThread ) != invalidThreadIds.end() ) {
-                it = m_priv->m_path_handler.erase( it );
-            } else {
-                it++;
-            }
-        }
-    }
+    m_priv->m_objects.remove_handled_by( invalidThreadIds );
 }
 
 bool Connection::change_object_proxy_calling_thread( std::shared_ptr<ObjectProxy> object,
@@ -1106,6 +1944,7 @@ bool Connection::change_object_proxy_calling_thread( std::shared_ptr<ObjectProxy
                 thrInfo.handlingThread = m_priv->m_dispatchingThread;
             }
 
+            invalidate_signal_routes();
             return true;
         }
     }
@@ -1118,16 +1957,42 @@ bool Connection::register_object_proxy( std::shared_ptr<ObjectProxy> obj, Thread
 
     ObjectProxyThreadInfo newInfo;
     newInfo.handler = obj;
-    newInfo.handlingThread = thread_id_from_calling( calling );
+    // Signals are not handled on the thread pool, so that they stay in order
+    newInfo.handlingThread = thread_id_from_calling(
+        calling == ThreadForCalling::ThreadPool ? ThreadForCalling::DispatcherThread : calling ).value();
 
     m_priv->m_objectProxies.push_back( newInfo );
+    invalidate_signal_routes();
 
     return true;
 }
 
-std::thread::id Connection::thread_id_from_calling( ThreadForCalling calling ){
+void Connection::set_direct_blocking_send( bool direct ) {
+    m_priv->m_directBlockingSend = direct;
+}
+
+bool Connection::direct_blocking_send() const {
+    return m_priv->m_directBlockingSend;
+}
+
+void Connection::set_thread_pool_size( unsigned int threads ) {
+    m_priv->m_threadPoolSize = threads;
+}
+
+void Connection::set_thread_pool_ordering( ThreadPoolOrdering ordering ) {
+    m_priv->m_threadPoolOrdering = ordering;
+}
+
+ThreadPoolOrdering Connection::thread_pool_ordering() const {
+    return m_priv->m_threadPoolOrdering;
+}
+
+std::optional<std::thread::id> Connection::thread_id_from_calling( ThreadForCalling calling ){
     if( calling == ThreadForCalling::CurrentThread ){
         return std::this_thread::get_id();
+    }else if( calling == ThreadForCalling::ThreadPool ){
+        // No thread in particular: this is a call for the thread pool
+        return std::nullopt;
     }else{
         return m_priv->m_dispatchingThread;
     }
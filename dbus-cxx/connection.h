@@ -13,9 +13,12 @@
 #include <dbus-cxx/threaddispatcher.h>
 #include <dbus-cxx/errormessage.h>
 #include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include "enums.h"
@@ -63,6 +66,56 @@ namespace priv {
 class Transport;
 }
 
+/**
+ * How well busy-polling has worked on a connection.
+ *
+ * @see Connection::set_busy_poll_window()
+ */
+struct BusyPollStats {
+    BusyPollStats() :
+        hits( 0 ),
+        misses( 0 )
+    {}
+
+    /** How many times a message came in while spinning */
+    uint64_t hits;
+    /** How many times nothing came in before the window ran out */
+    uint64_t misses;
+};
+
+/**
+ * The state of the queue of messages that a connection has read but not
+ * processed yet.
+ *
+ * @see Connection::set_incoming_queue_limits()
+ */
+struct IncomingQueueStats {
+    IncomingQueueStats() :
+        messages( 0 ),
+        bytes( 0 ),
+        peakMessages( 0 ),
+        droppedSignals( 0 ),
+        rejectedCalls( 0 ),
+        pausedReads( 0 ),
+        highWatermarkCrossings( 0 )
+    {}
+
+    /** How many messages are in the queue */
+    size_t messages;
+    /** About how many bytes the messages in the queue take up */
+    size_t bytes;
+    /** The most messages that have been in the queue at once */
+    size_t peakMessages;
+    /** How many signals were dropped because the queue was full */
+    uint64_t droppedSignals;
+    /** How many method calls were rejected because the queue was full */
+    uint64_t rejectedCalls;
+    /** How many times reading was skipped because the queue was full */
+    uint64_t pausedReads;
+    /** How many times the queue has filled up to the high watermark */
+    uint64_t highWatermarkCrossings;
+};
+
 /**
  * Connection point to the DBus
  *
@@ -161,12 +214,42 @@ public:
      */
     StartReply start_service( const std::string& name, uint32_t flags = 0 ) const;
 
+    /**
+     * Add a match rule, waiting for the bus to add it if this connection
+     * isn't already listening for it.
+     */
     bool add_match( const std::string& rule );
 
+    /**
+     * Add a match rule without waiting for the bus.  The change is queued
+     * up and sent with any other match rule changes the next time that the
+     * connection dispatches or sends a message, so it always gets to the bus
+     * before anything else that is sent after this.
+     *
+     * A rule that is added and removed again before the change is sent is
+     * never sent at all.  Errors are reported through signal_match_error().
+     */
     void add_match_nonblocking( const std::string& rule );
 
     bool remove_match( const std::string& rule );
 
+    /**
+     * Remove a match rule without waiting for the bus; see add_match_nonblocking().
+     */
+    void remove_match_nonblocking( const std::string& rule );
+
+    /**
+     * How many match rule changes are waiting to be sent to the bus.
+     */
+    size_t pending_match_changes() const;
+
+    /**
+     * Emitted from the dispatching thread when the bus fails to add or
+     * remove a match rule that was changed without blocking, with the rule
+     * and the name of the error.
+     */
+    sigc::signal<void(std::string, std::string)>& signal_match_error();
+
     bool is_connected() const;
 
     bool is_authenticated() const;
@@ -176,10 +259,11 @@ public:
     const char* server_id() const;
 
     /**
-     * Queues up the message to be sent on the bus.
+     * Queues up the message to be sent on the bus.  Invalid messages(such as
+     * replies to calls that do not expect a reply) are not sent.
      *
      * @param message The message to send
-     * @return The serial of the message
+     * @return The serial of the message, or 0 if the message was not sent
      */
     uint32_t send( const std::shared_ptr<const Message> message );
 
@@ -200,6 +284,84 @@ public:
      */
     std::shared_ptr<ReturnMessage> send_with_reply_blocking( std::shared_ptr<const CallMessage> msg, int timeout_milliseconds = -1 );
 
+    /**
+     * Send a CallMessage without waiting for the reply.  The returned
+     * PendingCall is completed from the dispatching thread once the reply
+     * comes in, or once the timeout expires.
+     *
+     * @param msg The message to send
+     * @param timeout_milliseconds How long to wait for the reply.  If -1, will wait the maximum time
+     * @return The PendingCall that will hold the reply
+     */
+    std::shared_ptr<PendingCall> send_with_reply_async( std::shared_ptr<const CallMessage> msg, int timeout_milliseconds = -1 );
+
+    /**
+     * Send a batch of CallMessages without waiting for the replies.  All of
+     * the messages are queued at once and written out together, so that the
+     * round trips overlap instead of happening one after the other.  Every
+     * call in the batch shares the same timeout.
+     *
+     * @param msgs The messages to send
+     * @param timeout_milliseconds How long to wait for all of the replies.  If -1, will wait the maximum time
+     * @return The PendingCalls for the messages, in the same order as the messages
+     */
+    std::vector<std::shared_ptr<PendingCall>> send_with_reply_batch_async( const std::vector<std::shared_ptr<const CallMessage>>& msgs, int timeout_milliseconds = -1 );
+
+    /**
+     * Send a batch of CallMessages, and wait until all of the replies have
+     * come back or the timeout expires.  Unlike send_with_reply_blocking(),
+     * this does not throw if one of the calls fails: every returned
+     * PendingCall is completed, and holds the reply, the error, or a timeout
+     * for its own call, which PendingCall::return_message() will return or throw.
+     *
+     * This may be called from the dispatching thread.
+     *
+     * @param msgs The messages to send
+     * @param timeout_milliseconds How long to wait for all of the replies.  If -1, will wait the maximum time
+     * @return The completed PendingCalls, in the same order as the messages
+     */
+    std::vector<std::shared_ptr<PendingCall>> send_with_reply_batch( const std::vector<std::shared_ptr<const CallMessage>>& msgs, int timeout_milliseconds = -1 );
+
+    /**
+     * The number of milliseconds until the next asynchronous call times out.
+     * A dispatcher should call dispatch() after at most this long so that
+     * the timeout can be processed.
+     *
+     * @return The number of milliseconds, or -1 if there are no calls outstanding
+     */
+    int next_timeout_milliseconds() const;
+
+    /**
+     * A file descriptor that becomes readable when the next asynchronous
+     * call times out.  A dispatcher that waits on this does not have to use
+     * next_timeout_milliseconds(); it should call dispatch() when it becomes
+     * readable.
+     *
+     * @return The file descriptor, or -1 if this is not supported on this platform
+     */
+    int timeout_fd() const;
+
+    /**
+     * Set how long to wait for a reply when a method call is sent with a
+     * timeout of -1.  The default is 20 seconds.
+     *
+     * @param timeout The timeout to use
+     */
+    void set_default_timeout( std::chrono::milliseconds timeout );
+
+    std::chrono::milliseconds default_timeout() const;
+
+    /**
+     * Call the given function from the dispatching thread once the delay
+     * has passed.  With no delay, it is called the next time that the
+     * connection dispatches.
+     *
+     * The function is called at the same time that asynchronous calls time
+     * out, so next_timeout_milliseconds() and timeout_fd() take it into account.
+     */
+    void run_on_dispatcher( std::function<void()> callback,
+                            std::chrono::milliseconds delay = std::chrono::milliseconds( 0 ) );
+
     /**
      * Flushes all data out to the bus.  This should generally
      * be called from the dispatching thread, but it should be
@@ -264,6 +426,20 @@ public:
     RegistrationStatus register_object( std::shared_ptr<Object> object,
         ThreadForCalling calling = ThreadForCalling::DispatcherThread );
 
+    /**
+     * Register an object with this connection as a fallback object.  A fallback
+     * object handles the calls to its own path, and also to every path below it
+     * that does not have an object of its own.  This allows a single object to
+     * serve a large number of dynamic paths; the path that was called is
+     * available from the CallMessage.
+     *
+     * @param object The object to export
+     * @param calling The thread in which this object's methods will be called in.  Defaults to being the dispatching thread.
+     * @return The status of registering an object to be exported.
+     */
+    RegistrationStatus register_fallback_object( std::shared_ptr<Object> object,
+        ThreadForCalling calling = ThreadForCalling::DispatcherThread );
+
     /**
      * Change the thread that the methods on this object will be called from.  Note that this
      * object must already be registered with register_object.
@@ -388,6 +564,155 @@ public:
      */
     void add_thread_dispatcher( std::weak_ptr<ThreadDispatcher> disp );
 
+    /**
+     * Set whether a blocking call made from a thread other than the
+     * dispatching thread writes its message out from that thread, instead of
+     * queueing it up for the dispatching thread to write.  This is only done
+     * when nothing else is queued up or being written at the time.  The
+     * reply is still read by the dispatching thread.
+     *
+     * This saves waking up the dispatching thread for every blocking call.
+     * It is off by default.
+     *
+     * @param direct True to write blocking calls from the calling thread
+     */
+    void set_direct_blocking_send( bool direct );
+
+    bool direct_blocking_send() const;
+
+    /**
+     * Set how long to spin waiting for a message before going to sleep.
+     *
+     * When this is set, the dispatcher keeps trying to read from the
+     * transport for up to this long before it falls back to waiting on the
+     * file descriptor, and a thread that is blocked in send_with_reply_blocking()
+     * spins for up to this long before it goes to sleep.  This uses more CPU,
+     * but saves the time that it takes to wake up when a message comes in
+     * quickly.
+     *
+     * @param window How long to spin for; 0(the default) to never spin
+     */
+    void set_busy_poll_window( std::chrono::microseconds window );
+
+    std::chrono::microseconds busy_poll_window() const;
+
+    /**
+     * Get the statistics on how often spinning found a message, so that
+     * the window can be tuned.
+     */
+    BusyPollStats busy_poll_stats() const;
+
+    /**
+     * For dispatchers: spin for the busy-poll window, waiting for a message
+     * to come in.  This must be called from the dispatching thread.
+     *
+     * @return True if there is now something to dispatch; false if the
+     * dispatcher should wait on the file descriptor
+     */
+    bool busy_poll();
+
+    /**
+     * Set how many threads the thread pool that calls methods on objects
+     * registered with ThreadForCalling::ThreadPool has.  The pool is started
+     * when the first such call comes in, so this must be called before then.
+     *
+     * @param threads The number of threads; 0(the default) means one per hardware thread
+     */
+    void set_thread_pool_size( unsigned int threads );
+
+    /**
+     * Set which method calls on the thread pool must be run in the order that
+     * they came in.  The default is ThreadPoolOrdering::None, so that calls
+     * to an object can run at the same time; objects that can't handle that
+     * should use ThreadPoolOrdering::PerObject.
+     *
+     * @param ordering The ordering to keep
+     */
+    void set_thread_pool_ordering( ThreadPoolOrdering ordering );
+
+    ThreadPoolOrdering thread_pool_ordering() const;
+
+    /**
+     * Limit how many messages can be waiting to be processed.  This is the
+     * high watermark; the low watermark is half of it.  When the queue fills
+     * up to the high watermark, the overflow policy applies until the queue
+     * drains back down to the low watermark.
+     *
+     * The size in bytes counts the bodies of the messages plus a small
+     * amount for each header.
+     *
+     * @param maxMessages The most messages to queue, or 0 for no limit(the default)
+     * @param maxBytes The most bytes to queue, or 0 for no limit(the default)
+     */
+    void set_incoming_queue_limits( size_t maxMessages, size_t maxBytes );
+
+    /**
+     * Set what to do when the incoming queue is full.  The default is
+     * IncomingOverflowPolicy::DropOldestSignals.
+     */
+    void set_incoming_overflow_policy( IncomingOverflowPolicy policy );
+
+    IncomingOverflowPolicy incoming_overflow_policy() const;
+
+    IncomingQueueStats incoming_queue_stats() const;
+
+    /**
+     * Emitted from the dispatching thread when the incoming queue fills up
+     * to the high watermark(with true), and when it drains back down to the
+     * low watermark(with false).
+     */
+    sigc::signal<void(bool)>& signal_incoming_queue_watermark();
+
+    /**
+     * Turn on fair scheduling of incoming method calls.
+     *
+     * Normally, messages are processed in the order that they come in, so
+     * one client that sends a lot of calls can hold up everybody else.  When
+     * this is on, method calls are queued up per sender and are processed
+     * with deficit round-robin: each sender gets to have up to the quantum
+     * of its calls processed before the next sender gets a turn.  Replies
+     * and signals still take turns with the calls as set by
+     * set_incoming_lane_weights().
+     *
+     * @param fair True to schedule calls fairly, false(the default) to process them in order
+     */
+    void set_fair_call_scheduling( bool fair );
+
+    bool fair_call_scheduling() const;
+
+    /**
+     * Set how many calls each sender may have processed in a row when fair
+     * call scheduling is on.  The default is 1.
+     */
+    void set_fair_call_quantum( unsigned int quantum );
+
+    unsigned int fair_call_quantum() const;
+
+    /**
+     * Set the weights of the lanes that incoming messages are sorted into.
+     *
+     * Replies and errors go in the first lane, method calls in the second,
+     * and signals in the last.  Each lane gets to have up to its weight of
+     * messages processed, in that order, before the lanes start over.  The
+     * defaults are 16 for replies, 4 for calls and 1 for signals.
+     *
+     * A reply that a thread is blocked waiting for does not wait in a lane
+     * at all; it is given to the thread as soon as it is read.
+     *
+     * @param replies The weight of replies and errors
+     * @param calls The weight of method calls
+     * @param signals The weight of signals
+     */
+    void set_incoming_lane_weights( unsigned int replies, unsigned int calls, unsigned int signals );
+
+    /**
+     * Get how many calls are waiting to be processed for each sender.  This
+     * is only filled in when fair call scheduling is on.
+     *
+     * @return A map of sender unique name to number of calls
+     */
+    std::map<std::string, size_t> sender_queue_depths() const;
+
 private:
     /**
      * Depending on what thread this is called from,
@@ -398,17 +723,123 @@ private:
 
     /**
      * Write a single message, return the serial of this message.
-     * This should me called with a lock on m_outgoingLock
+     * This should me called with a lock on m_writeLock
      *
      * @param msg
      * @return
      */
     uint32_t write_single_message( std::shared_ptr<const Message> msg );
 
+    /**
+     * Add a message that we have read to the incoming queue, rejecting it
+     * if the queue is full and the overflow policy says to.
+     */
+    void queue_incoming_message( std::shared_ptr<Message> msg );
+
+    /**
+     * Try to write a message out right now from the current thread.
+     *
+     * @return False if the message could not be written now, and must be
+     * queued instead
+     */
+    bool write_directly( std::shared_ptr<const Message> msg, uint32_t serial );
+
+    /**
+     * Give an error reply to whoever is waiting for a reply to the message
+     * with the given serial, which could not be sent.  This must not be
+     * called with a lock on m_writeLock.
+     */
+    void fail_unsent_message( uint32_t serial );
+
     void process_single_message();
 
+    /**
+     * Read the messages that are available from the transport onto the
+     * incoming queue, unless reading is paused.
+     *
+     * @param maxMessages The most messages to read
+     * @return How many messages were read
+     */
+    int read_incoming_messages( int maxMessages );
+
+    /**
+     * Keep trying to read a message for the busy-poll window.
+     *
+     * @param stopForOutgoing Stop early if there is a message to write
+     * @return The message, or an invalid pointer if nothing came in
+     */
+    std::shared_ptr<Message> busy_poll_read( bool stopForOutgoing );
+
+    /**
+     * Complete all asynchronous calls whose timeout has expired.
+     */
+    void process_pending_call_timeouts();
+
+    /**
+     * Remove the asynchronous call with the given serial from the calls that
+     * are waiting for a reply.
+     *
+     * @return The call, or an invalid pointer if there is no such call
+     */
+    std::shared_ptr<PendingCall> take_pending_call( uint32_t serial );
+
+    /**
+     * Queue up the given calls as asynchronous calls that time out at the
+     * given time, without notifying the dispatcher.
+     */
+    std::vector<std::shared_ptr<PendingCall>> queue_pending_calls( const std::vector<std::shared_ptr<const CallMessage>>& msgs,
+        std::chrono::steady_clock::time_point deadline );
+
+    /**
+     * Change the count of the given match rule, and record the change that
+     * needs to be made on the bus if the rule was added or removed.  Must be
+     * called with the match lock held.
+     *
+     * @return true if there is a change to make on the bus
+     */
+    bool change_match_count( const std::string& rule, int delta );
+
+    /**
+     * Take the queued change of the given rule out of the queue, so that
+     * the caller can send it itself.  Must be called with the match lock held.
+     *
+     * @return true if the queued change was the given one
+     */
+    bool take_match_change( const std::string& rule, int change );
+
+    /**
+     * Let the dispatcher know that there are match rule changes to send.
+     */
+    void request_match_flush();
+
+    /**
+     * Queue up all of the match rule changes that are waiting to be sent.
+     */
+    void queue_match_changes();
+
+    RegistrationStatus register_object( std::shared_ptr<Object> object, ThreadForCalling calling, bool fallback );
+
     void remove_invalid_threaddispatchers_and_associated_objects();
 
+    /**
+     * Rebuild the index of signal proxies that signals are routed with.
+     * This must be called from the dispatching thread.
+     */
+    void rebuild_signal_routes();
+
+    /**
+     * Mark the signal routes as out of date, so that they are rebuilt
+     * before the next signal is routed.  Called whenever a signal proxy of
+     * this connection is added, removed or changed.
+     */
+    void invalidate_signal_routes();
+
+    /**
+     * Give all of the signals that have been queued up for ThreadDispatchers
+     * to their ThreadDispatchers, one batch per thread.
+     */
+    void send_thread_signals();
+
     /**
      * Send an error back to the calling application based on HandlerResult.  No-op if the
      * result indicates that there is no error.
@@ -417,14 +848,56 @@ private:
     void send_error_on_handler_result( std::shared_ptr<const CallMessage> msg, HandlerResult result );
 
     void process_call_message( std::shared_ptr<const CallMessage> msg );
+
+    /**
+     * Give the given call to the thread pool, starting the pool if needed.
+     */
+    void submit_to_thread_pool( std::shared_ptr<Object> handler, std::shared_ptr<const CallMessage> msg );
+
+    /**
+     * Give the given task to the thread pool, ordered the same way as the
+     * given call to the given object would be.
+     */
+    void submit_to_thread_pool( std::shared_ptr<Object> handler,
+        std::shared_ptr<const CallMessage> msg,
+        std::function<void()> task );
+
+    /**
+     * Run the given function in the thread that calls to the object that the
+     * given call is for are handled in, the same as when the call first came
+     * in.  This may be called from any thread; the thread is picked from the
+     * dispatching thread.
+     *
+     * @param work The function to run
+     * @param unable Called instead if the object is gone, or its thread can't
+     * run the function
+     */
+    void run_in_handling_thread( std::shared_ptr<const CallMessage> callmsg,
+        std::function<void()> work,
+        std::function<void()> unable );
+
+    /**
+     * Start the thread pool if it has not been started yet.
+     */
+    void start_thread_pool();
     void process_signal_message( std::shared_ptr<const SignalMessage> msg );
 
-    std::thread::id thread_id_from_calling( ThreadForCalling calling );
+    /**
+     * The thread that calls or signals are handled on for the given
+     * ThreadForCalling; none for ThreadForCalling::ThreadPool.
+     */
+    std::optional<std::thread::id> thread_id_from_calling( ThreadForCalling calling );
 
 private:
     class priv_data;
 
     DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+
+    friend class PendingCall;
+    friend class Interface;
+    friend class ObjectProxy;
+    friend class InterfaceProxy;
+    friend class SignalBase;
 };
 
 inline
@@ -135,6 +135,51 @@ enum class ThreadForCalling {
     DispatcherThread,
     /** Always call methods for this object from the current thread */
     CurrentThread,
+    /**
+     * Call methods for this object from the connection's thread pool, so that
+     * calls can run at the same time.  Only applies to objects; signal proxies
+     * registered this way are handled on the dispatcher thread.
+     *
+     * @see Connection::set_thread_pool_ordering()
+     */
+    ThreadPool,
+};
+
+/**
+ * Which method calls must be run one at a time, in the order that they came
+ * in, when methods are called from the connection's thread pool.
+ */
+enum class ThreadPoolOrdering {
+    /** Calls may run in any order, even calls to the same object */
+    None,
+    /** Calls to the same object run in order */
+    PerObject,
+    /** Calls from the same sender run in order */
+    PerSender,
+};
+
+/**
+ * What a connection does when its queue of incoming messages is full.
+ *
+ * Replies to method calls are never dropped or rejected, since something is
+ * waiting for them.
+ *
+ * @see Connection::set_incoming_queue_limits()
+ */
+enum class IncomingOverflowPolicy {
+    /**
+     * Drop the oldest signals in the queue to make room for new messages.
+     * When there are no signals left to drop, new signals are dropped and
+     * new method calls are rejected as with RejectCalls.
+     */
+    DropOldestSignals,
+    /**
+     * Reply to new method calls with org.freedesktop.DBus.Error.LimitsExceeded,
+     * and drop new signals.
+     */
+    RejectCalls,
+    /** Stop reading from the bus until the queue drains to the low watermark */
+    PauseReading,
 };
 
 enum class MessageHeaderFields {
@@ -405,6 +405,11 @@ DBUSCXX_ERROR( ErrorInvalidReturn, "dbuscxx.Error.InvalidReturnValue" );
  */
 DBUSCXX_ERROR( ErrorUnexpectedResponse, "dbuscxx.Error.UnexpectedResponse" );
 
+/**
+ * This error is thrown when waiting on a call that has been canceled
+ */
+DBUSCXX_ERROR( ErrorCallCanceled, "dbuscxx.Error.CallCanceled" );
+
 class ErrorIncorrectDispatchThread : public Error {
 public:
     ErrorIncorrectDispatchThread( const char* message = nullptr )
@@ -22,6 +22,10 @@ ErrorMessage::ErrorMessage() {
 ErrorMessage::ErrorMessage( std::shared_ptr<const CallMessage> to_reply, const std::string& name, const std::string& message ) {
     if( to_reply ) {
         set_header_field( MessageHeaderFields::Reply_Serial, Variant( to_reply->serial() ) );
+
+        if( !to_reply->expects_reply() ) {
+            invalidate();
+        }
     }
 
     set_header_field( MessageHeaderFields::Error_Name, Variant( name ) );
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "fairscheduler.h"
+#include "message.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+using DBus::priv::FairScheduler;
+
+struct SenderQueue {
+    SenderQueue() :
+        deficit( 0 )
+    {}
+
+    std::deque<std::shared_ptr<DBus::Message>> calls;
+    unsigned int deficit;
+};
+
+class FairScheduler::priv_data {
+public:
+    priv_data() :
+        m_quantum( 1 ),
+        m_turnStarted( false ),
+        m_size( 0 )
+    {}
+
+    mutable std::mutex m_lock;
+    unsigned int m_quantum;
+    std::unordered_map<std::string, SenderQueue> m_senders;
+    /* The senders that have calls queued, in the order that they get a turn */
+    std::deque<std::string> m_active;
+    /* If the sender at the front of m_active has been given its quantum yet */
+    bool m_turnStarted;
+    size_t m_size;
+};
+
+FairScheduler::FairScheduler() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+FairScheduler::~FairScheduler() {
+}
+
+void FairScheduler::set_quantum( unsigned int quantum ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_quantum = quantum == 0 ? 1 : quantum;
+}
+
+unsigned int FairScheduler::quantum() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_quantum;
+}
+
+void FairScheduler::push( std::shared_ptr<Message> msg ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    std::string sender = msg->sender();
+    SenderQueue& queue = m_priv->m_senders[ sender ];
+
+    if( queue.calls.empty() ) {
+        m_priv->m_active.push_back( sender );
+    }
+
+    queue.calls.push_back( msg );
+    m_priv->m_size++;
+}
+
+std::shared_ptr<DBus::Message> FairScheduler::pop() {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    if( m_priv->m_active.empty() ) { return std::shared_ptr<Message>(); }
+
+    std::string sender = m_priv->m_active.front();
+    SenderQueue& queue = m_priv->m_senders[ sender ];
+
+    if( !m_priv->m_turnStarted ) {
+        queue.deficit += m_priv->m_quantum;
+        m_priv->m_turnStarted = true;
+    }
+
+    std::shared_ptr<Message> msg = queue.calls.front();
+    queue.calls.pop_front();
+    queue.deficit--;
+    m_priv->m_size--;
+
+    if( queue.calls.empty() ) {
+        // An idle sender doesn't get to save up its turn
+        m_priv->m_senders.erase( sender );
+        m_priv->m_active.pop_front();
+        m_priv->m_turnStarted = false;
+    } else if( queue.deficit == 0 ) {
+        m_priv->m_active.pop_front();
+        m_priv->m_active.push_back( sender );
+        m_priv->m_turnStarted = false;
+    }
+
+    return msg;
+}
+
+bool FairScheduler::empty() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_size == 0;
+}
+
+std::map<std::string, size_t> FairScheduler::depths() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    std::map<std::string, size_t> depths;
+
+    for( const std::pair<const std::string, SenderQueue>& sender : m_priv->m_senders ) {
+        depths[ sender.first ] = sender.second.calls.size();
+    }
+
+    return depths;
+}
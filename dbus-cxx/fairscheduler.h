@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_FAIRSCHEDULER_H
+#define DBUS_CXX_FAIRSCHEDULER_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace DBus {
+
+class Message;
+
+namespace priv {
+
+/**
+ * Queues up method calls per sender, and hands them out with deficit
+ * round-robin so that one sender with a lot of calls can't keep the calls
+ * from other senders waiting.
+ *
+ * Each call costs one unit.  Each time a sender comes up, it may have up to
+ * the quantum of its calls handed out before the next sender gets a turn.
+ *
+ * This class is thread-safe.
+ */
+class FairScheduler {
+public:
+    FairScheduler();
+
+    ~FairScheduler();
+
+    /**
+     * Set how many calls a sender may have handed out in a row.
+     */
+    void set_quantum( unsigned int quantum );
+
+    unsigned int quantum() const;
+
+    /**
+     * Add a call to the queue of its sender.
+     */
+    void push( std::shared_ptr<Message> msg );
+
+    /**
+     * Take the next call.
+     *
+     * @return The call, or an invalid pointer if there are none
+     */
+    std::shared_ptr<Message> pop();
+
+    bool empty() const;
+
+    /**
+     * Get how many calls are queued for each sender that has any.
+     */
+    std::map<std::string, size_t> depths() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_FAIRSCHEDULER_H */
@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "incomingqueue.h"
+#include "dbus-cxx-private.h"
+#include "fairscheduler.h"
+#include "message.h"
+
+#include <atomic>
+#include <deque>
+
+static const char* LOGGER_NAME = "DBus.IncomingQueue";
+
+using DBus::priv::IncomingQueue;
+
+/* Roughly how big the fixed part of a message header is */
+#define HEADER_SIZE 16
+
+/* The lanes, in the order that they are served in */
+#define REPLY_LANE 0
+#define CALL_LANE 1
+#define SIGNAL_LANE 2
+#define NUM_LANES 3
+
+class IncomingQueue::priv_data {
+public:
+    priv_data() :
+        m_maxMessages( 0 ),
+        m_maxBytes( 0 ),
+        m_policy( IncomingOverflowPolicy::DropOldestSignals ),
+        m_fair( false ),
+        m_full( false ),
+        m_size( 0 ),
+        m_bytes( 0 ),
+        m_peakSize( 0 ),
+        m_droppedSignals( 0 ),
+        m_rejectedCalls( 0 ),
+        m_pausedReads( 0 ),
+        m_highWatermarkCrossings( 0 ) {
+        m_weights[ REPLY_LANE ] = 16;
+        m_weights[ CALL_LANE ] = 4;
+        m_weights[ SIGNAL_LANE ] = 1;
+
+        for( int lane = 0; lane < NUM_LANES; lane++ ) {
+            m_credits[ lane ] = m_weights[ lane ];
+        }
+    }
+
+    static size_t message_bytes( const std::shared_ptr<Message>& msg ) {
+        return HEADER_SIZE + msg->body()->size();
+    }
+
+    /**
+     * Check to see if the queue would be over its limits with the given
+     * number of extra messages and bytes in it.
+     */
+    bool over_limit( size_t extraMessages, size_t extraBytes ) const {
+        size_t maxMessages = m_maxMessages;
+        size_t maxBytes = m_maxBytes;
+
+        return ( maxMessages != 0 && m_size + extraMessages > maxMessages ) ||
+            ( maxBytes != 0 && m_bytes + extraBytes > maxBytes );
+    }
+
+    bool at_high_watermark() const {
+        size_t maxMessages = m_maxMessages;
+        size_t maxBytes = m_maxBytes;
+
+        return ( maxMessages != 0 && m_size >= maxMessages ) ||
+            ( maxBytes != 0 && m_bytes >= maxBytes );
+    }
+
+    bool at_low_watermark() const {
+        size_t maxMessages = m_maxMessages;
+        size_t maxBytes = m_maxBytes;
+
+        return ( maxMessages == 0 || m_size <= maxMessages / 2 ) &&
+            ( maxBytes == 0 || m_bytes <= maxBytes / 2 );
+    }
+
+    static int lane_for( const std::shared_ptr<Message>& msg ) {
+        switch( msg->type() ) {
+        case MessageType::RETURN:
+        case MessageType::ERROR:
+            return REPLY_LANE;
+
+        case MessageType::SIGNAL:
+            return SIGNAL_LANE;
+
+        default:
+            return CALL_LANE;
+        }
+    }
+
+    bool lane_empty( int lane ) const {
+        if( lane == CALL_LANE ) {
+            return m_lanes[ CALL_LANE ].empty() && m_calls.empty();
+        }
+
+        return m_lanes[ lane ].empty();
+    }
+
+    std::shared_ptr<Message> take_from_lane( int lane ) {
+        std::shared_ptr<Message> msg;
+
+        // Calls that were queued before fair scheduling was turned on go first
+        if( lane == CALL_LANE && m_lanes[ CALL_LANE ].empty() ) {
+            return m_calls.pop();
+        }
+
+        msg = m_lanes[ lane ].front();
+        m_lanes[ lane ].pop_front();
+
+        return msg;
+    }
+
+    /**
+     * Remove the oldest signal from the queue.
+     *
+     * @return false if there are no signals in the queue
+     */
+    bool drop_oldest_signal() {
+        if( m_lanes[ SIGNAL_LANE ].empty() ) { return false; }
+
+        std::shared_ptr<Message> oldest = m_lanes[ SIGNAL_LANE ].front();
+        m_lanes[ SIGNAL_LANE ].pop_front();
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Dropping signal with serial " << oldest->serial() );
+        m_bytes -= message_bytes( oldest );
+        m_size--;
+        m_droppedSignals++;
+
+        return true;
+    }
+
+    void update_watermark() {
+        if( !m_full && at_high_watermark() ) {
+            m_full = true;
+            m_highWatermarkCrossings++;
+        } else if( m_full && at_low_watermark() ) {
+            m_full = false;
+        } else {
+            return;
+        }
+
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Incoming queue " << ( m_full ? "full" : "drained" )
+            << " at " << m_size << " messages, " << m_bytes << " bytes" );
+
+        if( m_callback ) {
+            m_callback( m_full );
+        }
+    }
+
+    std::atomic<size_t> m_maxMessages;
+    std::atomic<size_t> m_maxBytes;
+    std::atomic<IncomingOverflowPolicy> m_policy;
+    std::function<void( bool )> m_callback;
+    std::deque<std::shared_ptr<Message>> m_lanes[ NUM_LANES ];
+    std::atomic<unsigned int> m_weights[ NUM_LANES ];
+    /* How many more messages each lane may have taken in this round */
+    unsigned int m_credits[ NUM_LANES ];
+    std::atomic<bool> m_fair;
+    /* The calls, when fair scheduling is on */
+    FairScheduler m_calls;
+    bool m_full;
+    std::atomic<size_t> m_size;
+    std::atomic<size_t> m_bytes;
+    std::atomic<size_t> m_peakSize;
+    std::atomic<uint64_t> m_droppedSignals;
+    std::atomic<uint64_t> m_rejectedCalls;
+    std::atomic<uint64_t> m_pausedReads;
+    std::atomic<uint64_t> m_highWatermarkCrossings;
+};
+
+IncomingQueue::IncomingQueue() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+IncomingQueue::~IncomingQueue() {
+}
+
+void IncomingQueue::set_limits( size_t maxMessages, size_t maxBytes ) {
+    m_priv->m_maxMessages = maxMessages;
+    m_priv->m_maxBytes = maxBytes;
+}
+
+void IncomingQueue::set_policy( IncomingOverflowPolicy policy ) {
+    m_priv->m_policy = policy;
+}
+
+DBus::IncomingOverflowPolicy IncomingQueue::policy() const {
+    return m_priv->m_policy;
+}
+
+void IncomingQueue::set_fair_scheduling( bool fair ) {
+    m_priv->m_fair = fair;
+}
+
+bool IncomingQueue::fair_scheduling() const {
+    return m_priv->m_fair;
+}
+
+void IncomingQueue::set_fair_quantum( unsigned int quantum ) {
+    m_priv->m_calls.set_quantum( quantum );
+}
+
+unsigned int IncomingQueue::fair_quantum() const {
+    return m_priv->m_calls.quantum();
+}
+
+std::map<std::string, size_t> IncomingQueue::sender_depths() const {
+    return m_priv->m_calls.depths();
+}
+
+void IncomingQueue::set_lane_weights( unsigned int replies, unsigned int calls, unsigned int signals ) {
+    m_priv->m_weights[ REPLY_LANE ] = replies == 0 ? 1 : replies;
+    m_priv->m_weights[ CALL_LANE ] = calls == 0 ? 1 : calls;
+    m_priv->m_weights[ SIGNAL_LANE ] = signals == 0 ? 1 : signals;
+}
+
+void IncomingQueue::set_watermark_callback( std::function<void( bool )> callback ) {
+    m_priv->m_callback = callback;
+}
+
+IncomingQueue::PushResult IncomingQueue::push( std::shared_ptr<Message> msg ) {
+    size_t msgBytes = priv_data::message_bytes( msg );
+    MessageType type = msg->type();
+
+    if( ( type == MessageType::SIGNAL || type == MessageType::CALL ) &&
+        m_priv->over_limit( 1, msgBytes ) ) {
+        switch( m_priv->m_policy.load() ) {
+        case IncomingOverflowPolicy::DropOldestSignals:
+            while( m_priv->over_limit( 1, msgBytes ) && m_priv->drop_oldest_signal() ) {}
+
+            if( !m_priv->over_limit( 1, msgBytes ) ) {
+                break;
+            }
+
+            // Nothing older to drop, so turn this one away
+            if( type == MessageType::SIGNAL ) {
+                m_priv->m_droppedSignals++;
+                return PushResult::Dropped;
+            }
+
+            m_priv->m_rejectedCalls++;
+            return PushResult::Rejected;
+
+        case IncomingOverflowPolicy::RejectCalls:
+            if( type == MessageType::CALL ) {
+                m_priv->m_rejectedCalls++;
+                return PushResult::Rejected;
+            }
+
+            // The queued calls are left alone, so the new signal goes
+            m_priv->m_droppedSignals++;
+            return PushResult::Dropped;
+
+        case IncomingOverflowPolicy::PauseReading:
+            // Whatever has been read has to go somewhere; the connection
+            // stops reading until we drain
+            break;
+        }
+    }
+
+    if( type == MessageType::CALL && m_priv->m_fair ) {
+        m_priv->m_calls.push( msg );
+    } else {
+        m_priv->m_lanes[ priv_data::lane_for( msg ) ].push_back( msg );
+    }
+
+    m_priv->m_size++;
+    m_priv->m_bytes += msgBytes;
+
+    if( m_priv->m_size > m_priv->m_peakSize ) {
+        m_priv->m_peakSize = m_priv->m_size.load();
+    }
+
+    m_priv->update_watermark();
+
+    return PushResult::Queued;
+}
+
+std::shared_ptr<DBus::Message> IncomingQueue::pop() {
+    std::shared_ptr<Message> msg;
+
+    if( m_priv->m_size == 0 ) { return msg; }
+
+    // Weighted round-robin: each lane may have up to its weight of messages
+    // taken, highest priority first, before all of the lanes start over
+    for( int round = 0; round < 2 && !msg; round++ ) {
+        for( int lane = 0; lane < NUM_LANES; lane++ ) {
+            if( m_priv->m_credits[ lane ] == 0 || m_priv->lane_empty( lane ) ) { continue; }
+
+            m_priv->m_credits[ lane ]--;
+            msg = m_priv->take_from_lane( lane );
+            break;
+        }
+
+        if( !msg ) {
+            for( int lane = 0; lane < NUM_LANES; lane++ ) {
+                m_priv->m_credits[ lane ] = m_priv->m_weights[ lane ];
+            }
+        }
+    }
+
+    if( !msg ) { return msg; }
+
+    m_priv->m_size--;
+    m_priv->m_bytes -= priv_data::message_bytes( msg );
+    m_priv->update_watermark();
+
+    return msg;
+}
+
+bool IncomingQueue::empty() const {
+    return m_priv->m_size == 0;
+}
+
+bool IncomingQueue::reading_paused() const {
+    return m_priv->m_full && m_priv->m_policy == IncomingOverflowPolicy::PauseReading;
+}
+
+void IncomingQueue::count_paused_read() {
+    m_priv->m_pausedReads++;
+}
+
+size_t IncomingQueue::size() const {
+    return m_priv->m_size;
+}
+
+size_t IncomingQueue::bytes() const {
+    return m_priv->m_bytes;
+}
+
+size_t IncomingQueue::peak_size() const {
+    return m_priv->m_peakSize;
+}
+
+uint64_t IncomingQueue::dropped_signals() const {
+    return m_priv->m_droppedSignals;
+}
+
+uint64_t IncomingQueue::rejected_calls() const {
+    return m_priv->m_rejectedCalls;
+}
+
+uint64_t IncomingQueue::paused_reads() const {
+    return m_priv->m_pausedReads;
+}
+
+uint64_t IncomingQueue::high_watermark_crossings() const {
+    return m_priv->m_highWatermarkCrossings;
+}
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_INCOMINGQUEUE_H
+#define DBUS_CXX_INCOMINGQUEUE_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <dbus-cxx/enums.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+namespace DBus {
+
+class Message;
+
+namespace priv {
+
+/**
+ * The queue of messages that have been read from the bus but not processed
+ * yet, with optional limits on how big it may get.
+ *
+ * The high watermark is the limit itself, and the low watermark is half of
+ * the limit.  Once the queue gets to the high watermark it is considered
+ * full until it drains down to the low watermark.
+ *
+ * Messages are sorted into lanes as they come in: replies(and errors),
+ * method calls, and signals.  The lanes are served with weighted
+ * round-robin, highest priority first, so that a reply doesn't have to wait
+ * behind a flood of signals.
+ *
+ * When fair scheduling is on, method calls are queued up per sender in a
+ * FairScheduler.
+ *
+ * Only the dispatching thread may push and pop; the limits, the policy, the
+ * scheduling and the counters may be used from any thread.
+ */
+class IncomingQueue {
+public:
+    enum class PushResult {
+        /** The message was added to the queue */
+        Queued,
+        /** The message is a signal that was dropped */
+        Dropped,
+        /** The message is a method call that must be rejected */
+        Rejected,
+    };
+
+    IncomingQueue();
+
+    ~IncomingQueue();
+
+    /**
+     * Set the limits of the queue.  0 means no limit.
+     */
+    void set_limits( size_t maxMessages, size_t maxBytes );
+
+    void set_policy( IncomingOverflowPolicy policy );
+
+    IncomingOverflowPolicy policy() const;
+
+    /**
+     * Turn fair scheduling of method calls on or off.  Calls that are
+     * already queued stay where they are.
+     */
+    void set_fair_scheduling( bool fair );
+
+    bool fair_scheduling() const;
+
+    void set_fair_quantum( unsigned int quantum );
+
+    unsigned int fair_quantum() const;
+
+    /**
+     * How many calls are queued for each sender; only filled in when
+     * fair scheduling is on.
+     */
+    std::map<std::string, size_t> sender_depths() const;
+
+    /**
+     * Set how many messages each lane may have taken before the lanes after
+     * it get a turn.  A weight of 0 is taken to be 1.
+     */
+    void set_lane_weights( unsigned int replies, unsigned int calls, unsigned int signals );
+
+    /**
+     * Set the function to call when the queue crosses the high watermark
+     * (with true) or drains to the low watermark(with false).
+     */
+    void set_watermark_callback( std::function<void( bool )> callback );
+
+    /**
+     * Add a message to the end of the queue, applying the overflow policy
+     * if the queue is full.
+     */
+    PushResult push( std::shared_ptr<Message> msg );
+
+    /**
+     * Take the message at the front of the queue.
+     *
+     * @return The message, or an invalid pointer if the queue is empty
+     */
+    std::shared_ptr<Message> pop();
+
+    bool empty() const;
+
+    /**
+     * Check to see if the connection should not read any more messages
+     * right now.
+     */
+    bool reading_paused() const;
+
+    /**
+     * Count one time that reading was skipped because it was paused.
+     */
+    void count_paused_read();
+
+    size_t size() const;
+
+    size_t bytes() const;
+
+    size_t peak_size() const;
+
+    uint64_t dropped_signals() const;
+
+    uint64_t rejected_calls() const;
+
+    uint64_t paused_reads() const;
+
+    uint64_t high_watermark_crossings() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_INCOMINGQUEUE_H */
@@ -8,9 +8,13 @@
 #include "interface.h"
 #include <dbus-cxx/object.h>
 #include <map>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include "callmessage.h"
+#include "concurrencylimiter.h"
 #include "dbus-cxx-private.h"
+#include "errormessage.h"
 #include "methodbase.h"
 #include <sigc++/sigc++.h>
 #include "signalbase.h"
@@ -21,26 +25,113 @@ static const char* LOGGER_NAME = "DBus.Interface";
 namespace DBus {
 class Connection;
 
+/*
+ * Calls the given function when it goes out of scope, so that something is
+ * done however the scope is left.
+ */
+class ScopeExit {
+public:
+    ScopeExit( std::function<void()> func ) :
+        m_func( func ) {}
+
+    ~ScopeExit() {
+        m_func();
+    }
+
+    ScopeExit( const ScopeExit& ) = delete;
+    ScopeExit& operator=( const ScopeExit& ) = delete;
+
+private:
+    std::function<void()> m_func;
+};
+
+/*
+ * The property changes that have not been sent yet.  This is shared with
+ * the function that sends them later, so that it can tell if the interface
+ * has gone away in the meantime.
+ */
+struct PendingPropertyChanges {
+    PendingPropertyChanges( Interface* iface ) :
+        interface_ptr( iface ),
+        coalesce( false ),
+        window( 0 ),
+        batchDepth( 0 ),
+        sendScheduled( false )
+    {}
+
+    std::mutex lock;
+    Interface* interface_ptr;
+    bool coalesce;
+    std::chrono::milliseconds window;
+    int batchDepth;
+    bool sendScheduled;
+    std::map<std::string, Variant> changed;
+    std::set<std::string> invalidated;
+};
+
 class Interface::priv_data {
 public:
     priv_data( std::string name ):
-        m_name( name ) {}
+        m_name( name ),
+        m_propertyGeneration( 0 ) {}
+
+    void remove_arg_connection( std::shared_ptr<MethodBase> method ) {
+        std::map<std::shared_ptr<MethodBase>, sigc::connection>::iterator it = m_method_arg_connections.find( method );
+
+        if( it != m_method_arg_connections.end() ) {
+            it->second.disconnect();
+            m_method_arg_connections.erase( it );
+        }
+    }
+
+    void remove_arg_connection( std::shared_ptr<SignalBase> signal ) {
+        std::map<std::shared_ptr<SignalBase>, sigc::connection>::iterator it = m_signal_arg_connections.find( signal );
+
+        if( it != m_signal_arg_connections.end() ) {
+            it->second.disconnect();
+            m_signal_arg_connections.erase( it );
+        }
+    }
 
     const std::string m_name;
     std::string m_path;
     Methods m_methods;
+    /*
+     * The methods again, hashed by views of the keys of m_methods so that an
+     * incoming call can be routed without copying its member name.
+     */
+    std::unordered_map<std::string_view, std::shared_ptr<MethodBase>> m_method_dispatch;
     Signals m_signals;
+    /* Tell us when the argument names of a method or signal change */
+    std::map<std::shared_ptr<MethodBase>, sigc::connection> m_method_arg_connections;
+    std::map<std::shared_ptr<SignalBase>, sigc::connection> m_signal_arg_connections;
     std::set<std::shared_ptr<PropertyBase>> m_properties;
+    /* The properties again, by name */
+    std::unordered_map<std::string, std::shared_ptr<PropertyBase>> m_propertiesByName;
     mutable std::shared_mutex m_methods_rwlock;
     mutable std::shared_mutex m_signals_rwlock;
     mutable std::shared_mutex m_properties_rwlock;
     sigc::signal<void( std::shared_ptr<MethodBase> )> m_signal_method_added;
     sigc::signal<void( std::shared_ptr<MethodBase> )> m_signal_method_removed;
+    sigc::signal<void()> m_signal_introspection_changed;
     std::weak_ptr<DBus::Connection> m_connection;
+    /* Shared with the calls that are parked, which may outlive us */
+    std::shared_ptr<priv::ConcurrencyLimiter> m_limiter;
+    std::shared_ptr<PendingPropertyChanges> m_propertyChanges;
+    /*
+     * The reply to the last GetAll call, whose body is re-used until a
+     * property changes.  The generation goes up every time that a property
+     * changes, so that a reply built while a property was changing isn't kept.
+     */
+    std::mutex m_getAllLock;
+    std::shared_ptr<const ReturnMessage> m_getAllReply;
+    uint64_t m_propertyGeneration;
 };
 
 Interface::Interface( const std::string& name ) {
     m_priv = std::make_unique<priv_data>( name );
+    m_priv->m_limiter = std::make_shared<priv::ConcurrencyLimiter>();
+    m_priv->m_propertyChanges = std::make_shared<PendingPropertyChanges>( this );
 }
 
 std::shared_ptr<Interface> Interface::create( const std::string& name ) {
@@ -48,6 +139,16 @@ std::shared_ptr<Interface> Interface::create( const std::string& name ) {
 }
 
 Interface::~ Interface( ) {
+    for( std::pair<const std::shared_ptr<MethodBase>, sigc::connection>& conn : m_priv->m_method_arg_connections ) {
+        conn.second.disconnect();
+    }
+
+    for( std::pair<const std::shared_ptr<SignalBase>, sigc::connection>& conn : m_priv->m_signal_arg_connections ) {
+        conn.second.disconnect();
+    }
+
+    std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+    m_priv->m_propertyChanges->interface_ptr = nullptr;
 }
 
 
@@ -87,7 +188,11 @@ bool Interface::add_method( std::shared_ptr<MethodBase> method ) {
     {
         std::unique_lock lock( m_priv->m_methods_rwlock );
 
-        m_priv->m_methods.insert( std::make_pair( method->name(), method ) );
+        Methods::iterator inserted = m_priv->m_methods.insert( std::make_pair( method->name(), method ) ).first;
+        m_priv->m_method_dispatch[ inserted->first ] = inserted->second;
+        m_priv->m_method_arg_connections[ method ] = method->signal_introspection_changed().connect( [this]() {
+            m_priv->m_signal_introspection_changed.emit();
+        } );
     }
 
     m_priv->m_signal_method_added.emit( method );
@@ -106,7 +211,9 @@ bool Interface::remove_method( const std::string& name ) {
 
         if( iter != m_priv->m_methods.end() ) {
             method = iter->second;
+            m_priv->m_method_dispatch.erase( iter->first );
             m_priv->m_methods.erase( iter );
+            m_priv->remove_arg_connection( method );
         }
     }
 
@@ -132,7 +239,9 @@ bool Interface::remove_method( std::shared_ptr<MethodBase> torem ) {
         }
 
         if( method == torem ) {
+            m_priv->m_method_dispatch.erase( iter->first );
             m_priv->m_methods.erase( iter );
+            m_priv->remove_arg_connection( method );
         }
     }
 
@@ -172,10 +281,16 @@ bool Interface::add_signal( std::shared_ptr<SignalBase> sig ) {
         m_priv->m_signals.insert( sig );
         sig->set_path( this->path() );
         sig->set_interface( m_priv->m_name );
+        m_priv->m_signal_arg_connections[ sig ] = sig->signal_introspection_changed().connect( [this]() {
+            m_priv->m_signal_introspection_changed.emit();
+        } );
         result = true;
     }
 
     sig->set_connection( m_priv->m_connection );
+    lock.unlock();
+
+    if( result ) { m_priv->m_signal_introspection_changed.emit(); }
 
     return result;
 }
@@ -188,9 +303,14 @@ bool Interface::remove_signal( std::shared_ptr<SignalBase> signal ) {
 
     if( i != m_priv->m_signals.end() ) {
         m_priv->m_signals.erase( i );
+        m_priv->remove_arg_connection( signal );
         result = true;
     }
 
+    lock.unlock();
+
+    if( result ) { m_priv->m_signal_introspection_changed.emit(); }
+
     return result;
 }
 
@@ -203,12 +323,18 @@ bool Interface::remove_signal( const std::string& name ) {
     while( i != m_priv->m_signals.end() ) {
         if( ( *i )->name() == name ) {
             Signals::iterator temp = i++;
+            m_priv->remove_arg_connection( *temp );
             m_priv->m_signals.erase( temp );
+            result = true;
         } else {
             i++;
         }
     }
 
+    lock.unlock();
+
+    if( result ) { m_priv->m_signal_introspection_changed.emit(); }
+
     return result;
 }
 
@@ -253,6 +379,10 @@ std::shared_ptr<SignalBase> Interface::signal( const std::string& signal_name )
     return sig;
 }
 
+sigc::signal<void()> Interface::signal_introspection_changed() {
+    return m_priv->m_signal_introspection_changed;
+}
+
 sigc::signal< void( std::shared_ptr<MethodBase> )> Interface::signal_method_added() {
     return m_priv->m_signal_method_added;
 }
@@ -291,16 +421,133 @@ std::string Interface::introspect( int space_depth ) const {
 HandlerResult Interface::handle_call_message( std::shared_ptr<Connection> conn, std::shared_ptr<const CallMessage> message ) {
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "handle_call_message  interface=" << m_priv->m_name );
 
-    Methods::iterator method_it;
     std::shared_ptr<MethodBase> method;
 
-    method_it = m_priv->m_methods.find( message->member() );
+    {
+        std::shared_lock lock( m_priv->m_methods_rwlock );
+        std::unordered_map<std::string_view, std::shared_ptr<MethodBase>>::const_iterator method_it =
+            m_priv->m_method_dispatch.find( message->header_field_view( MessageHeaderFields::Member ) );
+
+        if( method_it == m_priv->m_method_dispatch.end() ) {
+            return HandlerResult::Invalid_Method;
+        }
+
+        method = method_it->second;
+    }
+
+    std::shared_ptr<priv::ConcurrencyLimiter> limiter = m_priv->m_limiter;
+    std::weak_ptr<Connection> weakConn = conn;
+
+    switch( limiter->acquire( [limiter, weakConn, method, message]() {
+            resubmit_call( weakConn, message,
+                [limiter, method, message]( std::shared_ptr<Connection> conn ) {
+                    return call_method( limiter, conn, method, message );
+                },
+                [limiter]() {
+                    limiter->release();
+                } );
+        } ) ) {
+    case priv::ConcurrencyLimiter::Admission::Run:
+        break;
+
+    case priv::ConcurrencyLimiter::Admission::Parked:
+        // It will be answered once it has had its turn
+        return HandlerResult::Handled;
+
+    case priv::ConcurrencyLimiter::Admission::Rejected:
+        return reject_call( conn, message );
+    }
+
+    return call_method( limiter, conn, method, message );
+}
+
+HandlerResult Interface::call_method( std::shared_ptr<priv::ConcurrencyLimiter> limiter,
+    std::shared_ptr<Connection> conn,
+    std::shared_ptr<MethodBase> method,
+    std::shared_ptr<const CallMessage> message ) {
+    std::weak_ptr<Connection> weakConn = conn;
+
+    std::function<void()> giveBack = [limiter, method]() {
+        method->finish_call();
+        limiter->release();
+    };
+
+    switch( method->admit_call( [limiter, weakConn, method, message, giveBack]() {
+            resubmit_call( weakConn, message,
+                [method, message, giveBack]( std::shared_ptr<Connection> conn ) {
+                    ScopeExit done( giveBack );
+
+                    return method->handle_call_message( conn, message );
+                },
+                giveBack );
+        } ) ) {
+    case priv::ConcurrencyLimiter::Admission::Run:
+        break;
+
+    case priv::ConcurrencyLimiter::Admission::Parked:
+        return HandlerResult::Handled;
+
+    case priv::ConcurrencyLimiter::Admission::Rejected:
+        limiter->release();
+        return reject_call( conn, message );
+    }
 
-    if( method_it == m_priv->m_methods.end() ) {
-        return HandlerResult::Invalid_Method;
+    // The method may throw, and the turns must be given back regardless
+    ScopeExit done( giveBack );
+
+    return method->handle_call_message( conn, message );
+}
+
+void Interface::resubmit_call( std::weak_ptr<Connection> weakConn,
+    std::shared_ptr<const CallMessage> message,
+    std::function<HandlerResult( std::shared_ptr<Connection> )> step,
+    std::function<void()> giveBack ) {
+    std::shared_ptr<Connection> conn = weakConn.lock();
+
+    if( !conn ) {
+        // Nobody is left to answer, but the turns still have to be given back
+        giveBack();
+        return;
     }
 
-    return method_it->second->handle_call_message( conn, message );
+    conn->run_in_handling_thread( message,
+        [weakConn, message, step, giveBack]() {
+            std::shared_ptr<Connection> conn = weakConn.lock();
+
+            if( !conn ) {
+                giveBack();
+                return;
+            }
+
+            HandlerResult result = step( conn );
+            conn->send_error_on_handler_result( message, result );
+        },
+        [weakConn, message, giveBack]() {
+            SIMPLELOGGER_WARN( LOGGER_NAME, "Unable to carry on with a parked call to "
+                << message->interface_name() << "." << message->member() << "; rejecting" );
+            giveBack();
+            reject_call( weakConn.lock(), message );
+        } );
+}
+
+HandlerResult Interface::reject_call( std::shared_ptr<Connection> conn, std::shared_ptr<const CallMessage> message ) {
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Too many calls to " << message->interface_name() << "." << message->member() << "; rejecting" );
+
+    if( !conn ) { return HandlerResult::Not_Handled; }
+
+    std::shared_ptr<ErrorMessage> errmsg = message->create_error_reply();
+    errmsg->set_name( DBUSCXX_ERROR_LIMITS_EXCEEDED );
+    errmsg->set_message( "Too many calls to " + message->member() + " are in progress" );
+    conn << errmsg;
+    return HandlerResult::Handled;
+}
+
+void Interface::set_concurrency_limit( unsigned int maxInFlight, unsigned int maxQueued ) {
+    m_priv->m_limiter->set_limits( maxInFlight, maxQueued );
+}
+
+uint64_t Interface::rejected_calls() const {
+    return m_priv->m_limiter->rejected();
 }
 
 HandlerResult Interface::handle_properties_message( std::shared_ptr<Connection> conn, std::shared_ptr<const CallMessage> message ){
@@ -311,25 +558,47 @@ HandlerResult Interface::handle_properties_message( std::shared_ptr<Connection>
     std::string errName = DBUSCXX_ERROR_UNKNOWN_PROPERTY;
 
     if( message->member() == "GetAll" ){
+        std::shared_ptr<const ReturnMessage> cached;
+        uint64_t generation;
+
+        {
+            std::unique_lock<std::mutex> getAllLock( m_priv->m_getAllLock );
+            cached = m_priv->m_getAllReply;
+            generation = m_priv->m_propertyGeneration;
+        }
+
+        if( cached && retmsg->copy_body( *cached ) ){
+            conn << retmsg;
+            return HandlerResult::Handled;
+        }
+
         std::map<std::string,DBus::Variant> retval;
 
-        for( std::shared_ptr<DBus::PropertyBase> prop : m_priv->m_properties ){
-            if( prop->variant_value().type() == DataType::INVALID ){
-                // The property has not been set, so we must assume that it does not exist
+        for( const std::shared_ptr<DBus::PropertyBase>& prop : m_priv->m_properties ){
+            if( prop->access_type() == DBus::PropertyAccess::WriteOnly ){
                 continue;
             }
 
-            switch( prop->access_type() ){
-            case DBus::PropertyAccess::ReadOnly:
-            case DBus::PropertyAccess::ReadWrite:
-                retval[ prop->name() ] = prop->variant_value();
-                break;
-            case DBus::PropertyAccess::WriteOnly:
+            DBus::Variant value = prop->variant_value();
+
+            if( value.type() == DataType::INVALID ){
+                // The property has not been set, so we must assume that it does not exist
                 continue;
             }
+
+            retval.emplace( prop->name(), value );
         }
 
         retmsg << retval;
+
+        {
+            std::unique_lock<std::mutex> getAllLock( m_priv->m_getAllLock );
+
+            if( generation == m_priv->m_propertyGeneration ){
+                m_priv->m_getAllReply = retmsg;
+            }
+        }
+
         conn << retmsg;
         return HandlerResult::Handled;
     } else if( message->member() == "Get" ){
@@ -338,18 +607,18 @@ HandlerResult Interface::handle_properties_message( std::shared_ptr<Connection>
 
         message >> interfaceName >> propertyName;
 
-        for( std::shared_ptr<DBus::PropertyBase> prop : m_priv->m_properties ){
-            if( prop->variant_value().type() == DataType::INVALID ){
-                // The property has not been set, so we must assume that it does not exist
-                continue;
-            }
+        std::unordered_map<std::string, std::shared_ptr<PropertyBase>>::const_iterator it =
+            m_priv->m_propertiesByName.find( propertyName );
 
-            if( prop->name() == propertyName ){
-                if( prop->access_type() != DBus::PropertyAccess::WriteOnly ){
-                    retmsg << prop->variant_value();
-                    conn << retmsg;
-                    return HandlerResult::Handled;
-                }
+        if( it != m_priv->m_propertiesByName.end() &&
+            it->second->access_type() != DBus::PropertyAccess::WriteOnly ){
+            DBus::Variant value = it->second->variant_value();
+
+            // If the property has not been set, we must assume that it does not exist
+            if( value.type() != DataType::INVALID ){
+                retmsg << value;
+                conn << retmsg;
+                return HandlerResult::Handled;
             }
         }
 
@@ -362,22 +631,20 @@ HandlerResult Interface::handle_properties_message( std::shared_ptr<Connection>
         message >> interfaceName >> propertyName >> variantValue;
         errMsg = "Unable to find property " + propertyName + " on interface " + interfaceName;
 
-        for( std::shared_ptr<DBus::PropertyBase> prop : m_priv->m_properties ){
-            if( prop->variant_value().type() == DataType::INVALID ){
-                // The property has not been set, so we must assume that it does not exist
-                continue;
-            }
+        std::unordered_map<std::string, std::shared_ptr<PropertyBase>>::const_iterator it =
+            m_priv->m_propertiesByName.find( propertyName );
 
-            if( prop->name() == propertyName ){
-                if( prop->access_type() != DBus::PropertyAccess::ReadOnly ){
-                    prop->set_value( variantValue );
-                    conn << retmsg;
-                    return HandlerResult::Handled;
-                }
-                errName = DBUSCXX_ERROR_PROPERTY_READ_ONLY;
-                errMsg = "Property " + propertyName + " on interface " + interfaceName + " is read-only";
-                break;
+        // If the property has not been set, we must assume that it does not exist
+        if( it != m_priv->m_propertiesByName.end() &&
+            it->second->variant_value().type() != DataType::INVALID ){
+            if( it->second->access_type() != DBus::PropertyAccess::ReadOnly ){
+                it->second->set_value( variantValue );
+                conn << retmsg;
+                return HandlerResult::Handled;
             }
+
+            errName = DBUSCXX_ERROR_PROPERTY_READ_ONLY;
+            errMsg = "Property " + propertyName + " on interface " + interfaceName + " is read-only";
         }
     }
 
@@ -407,41 +674,121 @@ bool Interface::add_property( std::shared_ptr<PropertyBase> prop ) {
         std::unique_lock lock( m_priv->m_properties_rwlock );
 
         m_priv->m_properties.insert( prop );
+        m_priv->m_propertiesByName[ prop->name() ] = prop;
     }
 
-    //m_priv->m_signal_method_added.emit( method );
+    property_values_changed();
+
     prop->setInterface( this );
+    m_priv->m_signal_introspection_changed.emit();
 
     return result;
 }
 
 bool Interface::has_property( const std::string& name ) const {
-    bool result = false;
     std::shared_lock lock( m_priv->m_properties_rwlock );
 
-    for( std::set<std::shared_ptr<PropertyBase>>::iterator i = m_priv->m_properties.begin();
-         i != m_priv->m_properties.end();
-         i++ ) {
-        if( ( *i )->name() == name ) {
-            result = true;
+    return m_priv->m_propertiesByName.find( name ) != m_priv->m_propertiesByName.end();
+}
+
+void Interface::property_values_changed(){
+    std::unique_lock<std::mutex> lock( m_priv->m_getAllLock );
+
+    m_priv->m_getAllReply.reset();
+    m_priv->m_propertyGeneration++;
+}
+
+void Interface::property_updated( DBus::PropertyBase* prop ){
+    property_values_changed();
+
+    std::shared_ptr<PendingPropertyChanges> changes = m_priv->m_propertyChanges;
+    std::shared_ptr<SignalMessage> sigChanged;
+
+    {
+        std::unique_lock<std::mutex> lock( changes->lock );
+
+        switch( prop->update_type() ){
+        case PropertyUpdateType::Updates:
+            changes->changed[ prop->name() ] = prop->variant_value();
+            changes->invalidated.erase( prop->name() );
+            break;
+        case PropertyUpdateType::Invalidates:
+            changes->invalidated.insert( prop->name() );
+            changes->changed.erase( prop->name() );
             break;
+        default:
+            // These properties don't say that they have changed
+            return;
+        }
+
+        if( changes->batchDepth > 0 ){
+            return;
+        }
+
+        std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+        if( !changes->coalesce || !conn ){
+            sigChanged = take_property_changes();
+        }else if( !changes->sendScheduled ){
+            std::weak_ptr<PendingPropertyChanges> weakChanges = changes;
+            changes->sendScheduled = true;
+            conn->run_on_dispatcher( [weakChanges](){
+                std::shared_ptr<PendingPropertyChanges> changes = weakChanges.lock();
+                if( !changes ){
+                    return;
+                }
+
+                std::shared_ptr<Connection> conn;
+                std::shared_ptr<SignalMessage> sigChanged;
+
+                {
+                    std::unique_lock<std::mutex> lock( changes->lock );
+                    changes->sendScheduled = false;
+
+                    if( !changes->interface_ptr || changes->batchDepth > 0 ){
+                        return;
+                    }
+
+                    conn = changes->interface_ptr->m_priv->m_connection.lock();
+                    sigChanged = changes->interface_ptr->take_property_changes();
+                }
+
+                if( conn && sigChanged ){
+                    conn << sigChanged;
+                }
+            }, changes->window );
         }
     }
 
-    return result;
+    send_property_changes( sigChanged );
 }
 
-void Interface::property_updated( DBus::PropertyBase* prop ){
+std::shared_ptr<SignalMessage> Interface::take_property_changes(){
+    std::shared_ptr<PendingPropertyChanges> changes = m_priv->m_propertyChanges;
+    std::map<std::string,DBus::Variant> changed;
+    std::vector<std::string> invalidated;
+
+    if( changes->changed.empty() && changes->invalidated.empty() ){
+        return std::shared_ptr<SignalMessage>();
+    }
+
+    changed.swap( changes->changed );
+    invalidated.assign( changes->invalidated.begin(), changes->invalidated.end() );
+    changes->invalidated.clear();
+
     std::shared_ptr<SignalMessage> sigChanged = SignalMessage::create( m_priv->m_path,
                                                                        DBUS_CXX_PROPERTIES_INTERFACE,
                                                                        "PropertiesChanged" );
 
-    std::map<std::string,DBus::Variant> changed;
-    std::vector<std::string> invalidated;
+    sigChanged << m_priv->m_name << changed << invalidated;
 
-    changed[ prop->name() ] = prop->variant_value();
+    return sigChanged;
+}
 
-    sigChanged << m_priv->m_name << changed << invalidated;
+void Interface::send_property_changes( std::shared_ptr<SignalMessage> sigChanged ){
+    if( !sigChanged ){
+        return;
+    }
 
     std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
     if( !conn ){
@@ -451,6 +798,65 @@ void Interface::property_updated( DBus::PropertyBase* prop ){
     conn << sigChanged;
 }
 
+void Interface::set_property_coalescing( bool coalesce, std::chrono::milliseconds window ){
+    bool sendNow;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+        m_priv->m_propertyChanges->coalesce = coalesce;
+        m_priv->m_propertyChanges->window = window;
+        sendNow = !coalesce;
+    }
+
+    // Don't leave anything that was gathered up waiting around
+    if( sendNow ){
+        flush_property_changes();
+    }
+}
+
+bool Interface::property_coalescing() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+
+    return m_priv->m_propertyChanges->coalesce;
+}
+
+void Interface::begin_property_changes(){
+    std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+
+    m_priv->m_propertyChanges->batchDepth++;
+}
+
+void Interface::end_property_changes(){
+    std::shared_ptr<SignalMessage> sigChanged;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+
+        if( m_priv->m_propertyChanges->batchDepth == 0 ){
+            return;
+        }
+
+        m_priv->m_propertyChanges->batchDepth--;
+
+        if( m_priv->m_propertyChanges->batchDepth == 0 ){
+            sigChanged = take_property_changes();
+        }
+    }
+
+    send_property_changes( sigChanged );
+}
+
+void Interface::flush_property_changes(){
+    std::shared_ptr<SignalMessage> sigChanged;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_propertyChanges->lock );
+        sigChanged = take_property_changes();
+    }
+
+    send_property_changes( sigChanged );
+}
+
 void Interface::set_connection( std::weak_ptr<Connection> conn ){
     m_priv->m_connection = conn;
 
@@ -12,6 +12,8 @@
 #include <dbus-cxx/dbus-cxx-config.h>
 #include <dbus-cxx/property.h>
 #include <sigc++/sigc++.h>
+#include <chrono>
+#include <functional>
 #include <set>
 #include <map>
 #include <mutex>
@@ -25,6 +27,11 @@ class CallMessage;
 class Connection;
 class Object;
 class SignalBase;
+class SignalMessage;
+
+namespace priv {
+class ConcurrencyLimiter;
+}
 
 /**
  * An Interface represents a local copy of a DBus interface.  A DBus interface is
@@ -235,12 +242,123 @@ public:
     /** Signal emitted when a method of the given name is removed */
     sigc::signal<void( std::shared_ptr<MethodBase> )> signal_method_removed();
 
+    /**
+     * Signal emitted when a signal or a property is added or removed.
+     * Together with the method signals, this tells when the result of
+     * introspect() changes.
+     */
+    sigc::signal<void()> signal_introspection_changed();
+
     /** Returns a DBus XML description of this interface */
     std::string introspect( int space_depth = 0 ) const;
 
+    /**
+     * Limit how many calls to the methods of this interface can run at once.
+     * When that many calls are running, up to maxQueued more calls wait for
+     * one of them to finish, without holding up a thread while they wait,
+     * and then run in the thread that the object is called in; any calls
+     * past that get an org.freedesktop.DBus.Error.LimitsExceeded error right
+     * away, without their arguments being looked at.
+     *
+     * This applies on top of the limits of the methods themselves.  Calls
+     * can only run at the same time when the object is called from the
+     * thread pool.
+     *
+     * @param maxInFlight How many calls can run at once, or 0 for no limit(the default)
+     * @param maxQueued How many calls can wait for a turn to run
+     */
+    void set_concurrency_limit( unsigned int maxInFlight, unsigned int maxQueued = 0 );
+
+    /** How many calls have been rejected because of the concurrency limit */
+    uint64_t rejected_calls() const;
+
+    /**
+     * Gather up property changes and send them together in one
+     * PropertiesChanged signal, instead of sending a signal every time that
+     * a property is set.
+     *
+     * The signal is sent once the window has passed after the first change;
+     * with a window of 0, it is sent the next time that the connection
+     * dispatches.
+     *
+     * @param coalesce True to gather up changes, false to send them right away(the default)
+     * @param window How long to gather changes for
+     */
+    void set_property_coalescing( bool coalesce,
+                                  std::chrono::milliseconds window = std::chrono::milliseconds( 0 ) );
+
+    bool property_coalescing() const;
+
+    /**
+     * Start a batch of property changes.  Until the matching call to
+     * end_property_changes(), changes are only gathered up.  Batches may
+     * be nested.
+     */
+    void begin_property_changes();
+
+    /**
+     * End a batch of property changes, sending everything that was gathered
+     * up once the outermost batch ends.
+     */
+    void end_property_changes();
+
+    /**
+     * Send the property changes that have been gathered up right now.
+     */
+    void flush_property_changes();
+
 private:
+    /**
+     * Reply to a call that is over the concurrency limit.
+     */
+    static HandlerResult reject_call( std::shared_ptr<Connection> conn, std::shared_ptr<const CallMessage> message );
+
+    /**
+     * Run a call that has its turn from the interface's limiter: get a turn
+     * from the method's limiter as well, call the method, and give both
+     * turns back.
+     */
+    static HandlerResult call_method( std::shared_ptr<priv::ConcurrencyLimiter> limiter,
+        std::shared_ptr<Connection> conn,
+        std::shared_ptr<MethodBase> method,
+        std::shared_ptr<const CallMessage> message );
+
+    /**
+     * Carry on with a call that was parked and now has its turn, in the
+     * thread that the call would have been handled in to begin with.
+     *
+     * @param step The rest of the call; its result is sent back as an error
+     * if the call was not handled
+     * @param giveBack Gives back the turns of the call, if the call can't
+     * carry on after all
+     */
+    static void resubmit_call( std::weak_ptr<Connection> conn,
+        std::shared_ptr<const CallMessage> message,
+        std::function<HandlerResult( std::shared_ptr<Connection> )> step,
+        std::function<void()> giveBack );
+
     void set_path( const std::string& new_path );
     void property_updated( DBus::PropertyBase* prop );
+
+    /**
+     * Forget the cached GetAll reply, as a property has changed.
+     */
+    void property_values_changed();
+
+    /**
+     * Take the changes that have been gathered up and build the
+     * PropertiesChanged signal for them.  The lock on the changes must be held.
+     *
+     * @return The signal, or an invalid pointer if nothing has changed
+     */
+    std::shared_ptr<SignalMessage> take_property_changes();
+
+    /**
+     * Send a PropertiesChanged signal from take_property_changes().  The lock
+     * on the changes must not be held, as sending may dispatch and come back
+     * around to change another property.
+     */
+    void send_property_changes( std::shared_ptr<SignalMessage> sigChanged );
     void set_connection( std::weak_ptr<Connection> conn );
 
 private:
@@ -252,6 +370,29 @@ private:
     friend class PropertyBase;
 };
 
+/**
+ * Gathers up the property changes of an interface for as long as it exists,
+ * and sends them in one PropertiesChanged signal when it goes away.
+ */
+class PropertyChangeBatch {
+public:
+    PropertyChangeBatch( std::shared_ptr<Interface> iface ) :
+        m_interface( iface ) {
+        if( m_interface ) { m_interface->begin_property_changes(); }
+    }
+
+    ~PropertyChangeBatch() {
+        if( m_interface ) { m_interface->end_property_changes(); }
+    }
+
+    PropertyChangeBatch( const PropertyChangeBatch& ) = delete;
+
+    PropertyChangeBatch& operator=( const PropertyChangeBatch& ) = delete;
+
+private:
+    std::shared_ptr<Interface> m_interface;
+};
+
 } /* namespace DBus */
 
 #endif /* DBUS_CXX_INTERFACE_H */
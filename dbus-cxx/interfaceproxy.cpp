@@ -6,6 +6,7 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include "interfaceproxy.h"
+#include <atomic>
 #include <map>
 #include <utility>
 #include "connection.h"
@@ -27,7 +28,10 @@ class InterfaceProxy::priv_data {
 public:
     priv_data( const std::string& name ):
         m_object( nullptr ),
-        m_name( name ) {}
+        m_name( name ),
+        m_prefetch( false ),
+        m_prefetched( false ),
+        m_targetGeneration( 0 ) {}
 
     ObjectProxy* m_object;
     const std::string m_name;
@@ -36,7 +40,11 @@ public:
     mutable std::shared_mutex m_methods_rwlock;
     mutable std::shared_mutex m_properties_rwlock;
     std::map<std::string,std::shared_ptr<PropertyProxyBase>> m_properties;
-    std::shared_ptr<DBus::SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> m_updated_proxy;
+    std::atomic<bool> m_prefetch;
+    /* If the properties have been fetched with GetAll yet */
+    std::atomic<bool> m_prefetched;
+    /* Bumped whenever the object, or its path or destination, changes */
+    std::atomic<uint64_t> m_targetGeneration;
 };
 
 InterfaceProxy::InterfaceProxy( const std::string& name ) {
@@ -48,14 +56,6 @@ std::shared_ptr<InterfaceProxy> InterfaceProxy::create( const std::string& name
 }
 
 InterfaceProxy::~ InterfaceProxy( ) {
-    if( m_priv->m_object ){
-        std::shared_ptr<Connection> conn = m_priv->m_object->connection().lock();
-        if( !conn ){
-            return;
-        }
-
-        conn->remove_free_signal_proxy( m_priv->m_updated_proxy );
-    }
 }
 
 ObjectProxy* InterfaceProxy::object() const {
@@ -64,34 +64,28 @@ ObjectProxy* InterfaceProxy::object() const {
 
 void InterfaceProxy::set_object( ObjectProxy* obj ) {
     m_priv->m_object = obj;
+    m_priv->m_targetGeneration++;
 
     std::shared_ptr<Connection> conn = connection().lock();
     if( conn ){
-        m_priv->m_updated_proxy =
-            conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
-                DBus::MatchRuleBuilder::create()
-                .set_path( path() )
-                .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
-                .set_member( "PropertiesChanged" )
-                .as_signal_match()
-                );
-
-        m_priv->m_updated_proxy->connect( sigc::mem_fun( *this, &InterfaceProxy::property_updated ) );
-
         for( std::shared_ptr<SignalProxyBase> sig : m_priv->m_signals ){
             // If we have created SignalProxies before the set_object call
             // (by, for example, creating them in the constructor)
             // the path will have not been set.  To fix this, remove any matches
             // that we may have added already, set the new path to use, and update
             // the match rule on the signal so we can re-add it.
-            conn->remove_match( sig->match_rule() );
+            conn->remove_match_nonblocking( sig->match_rule() );
             sig->set_path( path() );
             sig->update_match_rule();
-            conn->add_match( sig->match_rule() );
+            conn->add_match_nonblocking( sig->match_rule() );
         }
     }
 }
 
+uint64_t InterfaceProxy::target_generation() const {
+    return m_priv->m_targetGeneration;
+}
+
 Path InterfaceProxy::path() const {
     if( m_priv->m_object ) { return m_priv->m_object->path(); }
 
@@ -224,11 +218,11 @@ std::shared_ptr<const ReturnMessage> InterfaceProxy::call( std::shared_ptr<const
     return m_priv->m_object->call( call_message, timeout_milliseconds );
 }
 
-//  std::shared_ptr<PendingCall> InterfaceProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds ) const
-//  {
-//    if ( not m_priv->m_object ) return std::shared_ptr<PendingCall>();
-//    return m_priv->m_object->call_async( call_message, timeout_milliseconds );
-//  }
+std::shared_ptr<PendingCall> InterfaceProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds ) const {
+    if( !m_priv->m_object ) { return std::shared_ptr<PendingCall>(); }
+
+    return m_priv->m_object->call_async( call_message, timeout_milliseconds );
+}
 
 const InterfaceProxy::Signals& InterfaceProxy::signals() const {
     return m_priv->m_signals;
@@ -255,10 +249,11 @@ bool InterfaceProxy::add_signal( std::shared_ptr<SignalProxyBase> sig ) {
 
     // add it to the signal set
     m_priv->m_signals.insert( sig );
+    invalidate_signal_routes();
 
     std::shared_ptr<Connection> conn = connection().lock();
     if( conn ){
-        conn->add_match( sig->match_rule() );
+        conn->add_match_nonblocking( sig->match_rule() );
     }
 
     return true;
@@ -274,6 +269,7 @@ bool InterfaceProxy::remove_signal( std::shared_ptr<SignalProxyBase> sig ) {
     if( !this->has_signal( sig ) ) { return false; }
 
     m_priv->m_signals.erase( sig );
+    invalidate_signal_routes();
     return true;
 }
 
@@ -290,9 +286,23 @@ bool InterfaceProxy::has_signal( std::shared_ptr<SignalProxyBase> sig ) const {
 }
 
 void InterfaceProxy::on_object_set_path( const std::string& path ) {
+    m_priv->m_targetGeneration++;
+
     for( Signals::iterator i = m_priv->m_signals.begin(); i != m_priv->m_signals.end(); i++ ) {
         ( *i )->set_path( path );
     }
+
+    invalidate_signal_routes();
+}
+
+void InterfaceProxy::invalidate_signal_routes() {
+    std::shared_ptr<Connection> conn = connection().lock();
+
+    if( conn ) { conn->invalidate_signal_routes(); }
+}
+
+void InterfaceProxy::on_object_set_destination() {
+    m_priv->m_targetGeneration++;
 }
 
 const std::map<std::string,std::shared_ptr<PropertyProxyBase>>& InterfaceProxy::properties() const {
@@ -326,9 +336,18 @@ bool InterfaceProxy::add_property( std::shared_ptr<PropertyProxyBase> property )
         property->set_interface( this );
     }
 
+    // The object only listens for changes once there is a property to update
+    if( m_priv->m_object ) { m_priv->m_object->update_properties_subscription(); }
+
     return result;
 }
 
+bool InterfaceProxy::has_properties() const {
+    std::shared_lock lock( m_priv->m_properties_rwlock );
+
+    return !m_priv->m_properties.empty();
+}
+
 bool InterfaceProxy::has_property( const std::string& name ) const {
     std::map<std::string,std::shared_ptr<PropertyProxyBase>>::const_iterator iter;
     std::shared_lock lock( m_priv->m_properties_rwlock );
@@ -376,7 +395,12 @@ void InterfaceProxy::remove_property( const std::string& name ) {
             m_priv->m_properties.erase( iter );
         }
     }
+
+    if( !property ) { return; }
+
     property->set_interface( nullptr );
+
+    if( m_priv->m_object ) { m_priv->m_object->update_properties_subscription(); }
 }
 
 void InterfaceProxy::remove_property( std::shared_ptr<PropertyProxyBase> property ) {
@@ -386,7 +410,7 @@ void InterfaceProxy::remove_property( std::shared_ptr<PropertyProxyBase> propert
     if( !property ) { return; }
 
     {
-        std::unique_lock lock( m_priv->m_methods_rwlock );
+        std::unique_lock lock( m_priv->m_properties_rwlock );
 
         location = m_priv->m_properties.find( property->name() );
 
@@ -397,16 +421,104 @@ void InterfaceProxy::remove_property( std::shared_ptr<PropertyProxyBase> propert
     }
 
     property->set_interface( nullptr );
+
+    if( erased && m_priv->m_object ) { m_priv->m_object->update_properties_subscription(); }
 }
 
 void InterfaceProxy::cache_properties(){
+    refresh_properties();
+}
+
+void InterfaceProxy::set_property_prefetch( bool prefetch ){
+    m_priv->m_prefetch = prefetch;
+}
+
+bool InterfaceProxy::property_prefetch() const {
+    return m_priv->m_prefetch;
+}
+
+void InterfaceProxy::refresh_properties(){
+    if( !m_priv->m_object ) { return; }
+
+    std::shared_ptr<CallMessage> msg =
+            CallMessage::create( m_priv->m_object->destination(), m_priv->m_object->path(), DBUS_CXX_PROPERTIES_INTERFACE, "GetAll" );
+    msg << m_priv->m_name;
+
+    update_all_properties( call( msg ) );
+    m_priv->m_prefetched = true;
+}
+
+void InterfaceProxy::refresh_properties( const std::vector<std::string>& names ){
+    std::shared_ptr<Connection> conn = connection().lock();
+    std::vector<std::shared_ptr<const CallMessage>> msgs;
+
+    if( !conn || !m_priv->m_object ) { return; }
+
+    std::vector<std::shared_ptr<PropertyProxyBase>> props = create_get_calls( names, &msgs );
+
+    if( msgs.empty() ) { return; }
+
+    std::vector<std::shared_ptr<PendingCall>> pending = conn->send_with_reply_batch( msgs );
+
+    for( size_t x = 0; x < pending.size(); x++ ){
+        std::shared_ptr<const Message> reply = pending[ x ]->reply();
+
+        if( !reply || reply->type() != MessageType::RETURN ){
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to get property " << props[ x ]->name() );
+            continue;
+        }
+
+        Variant var;
+        MessageIterator iter = reply->begin();
+        iter >> var;
+        props[ x ]->updated_value( var );
+    }
+}
+
+std::shared_ptr<PendingCall> InterfaceProxy::refresh_properties_async(){
+    if( !m_priv->m_object ) { return std::shared_ptr<PendingCall>(); }
+
     std::shared_ptr<CallMessage> msg =
-            CallMessage::create( m_priv->m_object->destination(), m_priv->m_object->path(), "org.freedesktop.DBus.Properties", "GetAll" );
+            CallMessage::create( m_priv->m_object->destination(), m_priv->m_object->path(), DBUS_CXX_PROPERTIES_INTERFACE, "GetAll" );
     msg << m_priv->m_name;
-    std::shared_ptr<const ReturnMessage> ret =
-            call( msg );
 
-    MessageIterator iter = ret->begin();
+    std::shared_ptr<PendingCall> pending = call_async( msg );
+
+    if( !pending ) { return pending; }
+
+    // Hold on to the properties, and not to ourselves, as we may be gone
+    // by the time that the reply comes in
+    std::map<std::string,std::shared_ptr<PropertyProxyBase>> props;
+
+    {
+        std::shared_lock lock( m_priv->m_properties_rwlock );
+        props = m_priv->m_properties;
+    }
+
+    m_priv->m_prefetched = true;
+    pending->set_notify( [props]( std::shared_ptr<PendingCall> call ){
+        std::shared_ptr<const Message> reply = call->reply();
+
+        if( !reply || reply->type() != MessageType::RETURN ) { return; }
+
+        std::map<std::string,DBus::Variant> allValues;
+        MessageIterator iter = reply->begin();
+        iter >> allValues;
+
+        for( std::pair<const std::string,DBus::Variant>& value : allValues ){
+            std::map<std::string,std::shared_ptr<PropertyProxyBase>>::const_iterator it = props.find( value.first );
+
+            if( it != props.end() ) { it->second->updated_value( value.second ); }
+        }
+    } );
+
+    return pending;
+}
+
+void InterfaceProxy::update_all_properties( std::shared_ptr<const ReturnMessage> reply ){
+    if( !reply ) { return; }
+
+    MessageIterator iter = reply->begin();
     std::map<std::string,DBus::Variant> allValues;
 
     iter >> allValues;
@@ -414,12 +526,79 @@ void InterfaceProxy::cache_properties(){
     for( std::map<std::string,DBus::Variant>::const_iterator it = allValues.cbegin();
          it != allValues.cend();
          it++ ){
-        SIMPLELOGGER_TRACE( LOGGER_NAME, "Caching property " << it->first << "=" << it->second );
         std::shared_ptr<DBus::PropertyProxyBase> prop = property( it->first );
+
+        if( !prop ){
+            // We don't know about this one
+            continue;
+        }
+
+        SIMPLELOGGER_TRACE( LOGGER_NAME, "Caching property " << it->first << "=" << it->second );
         prop->updated_value( it->second );
     }
 }
 
+std::vector<std::shared_ptr<PropertyProxyBase>> InterfaceProxy::create_get_calls( const std::vector<std::string>& names,
+                                                                                std::vector<std::shared_ptr<const CallMessage>>* msgs ){
+    std::vector<std::shared_ptr<PropertyProxyBase>> props;
+
+    for( const std::string& name : names ){
+        std::shared_ptr<PropertyProxyBase> prop = property( name );
+
+        if( !prop ) { continue; }
+
+        std::shared_ptr<CallMessage> msg =
+                CallMessage::create( m_priv->m_object->destination(), m_priv->m_object->path(), DBUS_CXX_PROPERTIES_INTERFACE, "Get" );
+        msg << m_priv->m_name << name;
+        msgs->push_back( msg );
+        props.push_back( prop );
+    }
+
+    return props;
+}
+
+void InterfaceProxy::prefetch_properties(){
+    if( !m_priv->m_prefetch ) { return; }
+
+    if( m_priv->m_prefetched.exchange( true ) ) { return; }
+
+    try{
+        refresh_properties();
+    }catch( const std::exception& ex ){
+        // Leave it up to the individual properties to get their values
+        SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to prefetch properties: " << ex.what() );
+    }
+}
+
+void InterfaceProxy::refetch_properties( const std::vector<std::string>& names ){
+    std::shared_ptr<Connection> conn = connection().lock();
+    std::vector<std::shared_ptr<const CallMessage>> msgs;
+
+    if( !conn || !m_priv->m_object ) { return; }
+
+    std::vector<std::shared_ptr<PropertyProxyBase>> props = create_get_calls( names, &msgs );
+
+    if( msgs.empty() ) { return; }
+
+    std::vector<std::shared_ptr<PendingCall>> pending = conn->send_with_reply_batch_async( msgs );
+
+    for( size_t x = 0; x < pending.size(); x++ ){
+        std::shared_ptr<PropertyProxyBase> prop = props[ x ];
+
+        pending[ x ]->set_notify( [prop]( std::shared_ptr<PendingCall> call ){
+            std::shared_ptr<const Message> reply = call->reply();
+
+            // If we can't get it, it gets fetched again when it is read
+            if( !reply || reply->type() != MessageType::RETURN ) { return; }
+
+            Variant var;
+            MessageIterator iter = reply->begin();
+            iter >> var;
+            prop->updated_value( var );
+        } );
+    }
+}
+
 void InterfaceProxy::property_updated( std::string iface,
                                   std::map<std::string,DBus::Variant> changed,
                                   std::vector<std::string> invalidated ){
@@ -428,7 +607,6 @@ void InterfaceProxy::property_updated( std::string iface,
         return;
     }
 
-    std::shared_lock lock( m_priv->m_properties_rwlock );
     for( std::pair<std::string,DBus::Variant> entry : changed ){
         std::shared_ptr<PropertyProxyBase> prop = property( entry.first );
 
@@ -441,7 +619,23 @@ void InterfaceProxy::property_updated( std::string iface,
             prop->updated_value( entry.second );
         }
     }
-}
 
+    for( const std::string& name : invalidated ){
+        std::shared_ptr<PropertyProxyBase> prop = property( name );
+
+        if( prop ){
+            SIMPLELOGGER_TRACE( LOGGER_NAME, "Invalidating property '"
+                                << name
+                                << "' on interface '"
+                                << m_priv->m_name << "'" );
+            prop->invalidate();
+        }
+    }
+
+    // Keep the cache full if we are caching everything
+    if( m_priv->m_prefetch && m_priv->m_prefetched && !invalidated.empty() ){
+        refetch_properties( invalidated );
+    }
 }
 
+}
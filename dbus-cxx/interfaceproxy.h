@@ -13,6 +13,7 @@
 #include <set>
 #include <shared_mutex>
 #include <string>
+#include <vector>
 #include "path.h"
 #include <sigc++/sigc++.h>
 #include <dbus-cxx/propertyproxy.h>
@@ -110,6 +111,9 @@ public:
     /** True if the interface has the specified property */
     bool has_property( std::shared_ptr<PropertyProxyBase> property ) const;
 
+    /** True if the interface has any properties */
+    bool has_properties() const;
+
     /** Removes the property with the given name */
     void remove_property( const std::string& name );
 
@@ -143,11 +147,41 @@ public:
      */
     void cache_properties();
 
+    /**
+     * Fetch all of the properties with one GetAll call the first time that
+     * any of them is read, instead of with one Get call per property.
+     *
+     * Once the properties are cached, they are kept up to date from the
+     * PropertiesChanged signal; properties that the remote object
+     * invalidates are fetched again right away.
+     */
+    void set_property_prefetch( bool prefetch );
+
+    bool property_prefetch() const;
+
+    /**
+     * Fetch all of the properties with one GetAll call, waiting for the reply.
+     */
+    void refresh_properties();
+
+    /**
+     * Fetch the given properties, sending all of the Get calls at once and
+     * then waiting for the replies.
+     */
+    void refresh_properties( const std::vector<std::string>& names );
+
+    /**
+     * Fetch all of the properties with one GetAll call without waiting for
+     * the reply; the properties are updated when it comes in.  This can be
+     * used to fill in the cache when the proxy is created.
+     */
+    std::shared_ptr<PendingCall> refresh_properties_async();
+
     std::shared_ptr<CallMessage> create_call_message( const std::string& method_name ) const;
 
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
-    //      std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds=-1 ) const;
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
     template <class T_arg>
     std::shared_ptr<SignalProxy<T_arg >> create_signal( const std::string& sig_name ) {
@@ -179,16 +213,56 @@ public:
 private:
     void on_object_set_path( const std::string& path );
 
+    void on_object_set_destination();
+
+    /**
+     * Let our connection know that our signal proxies have changed.
+     */
+    void invalidate_signal_routes();
+
     void set_object( ObjectProxy* obj );
 
+    /**
+     * Goes up every time the object, or the path or destination of the
+     * object, changes.  Method proxies use this to tell when the header
+     * fields that they have marshaled are out of date.
+     */
+    uint64_t target_generation() const;
+
     void property_updated( std::string,std::map<std::string,DBus::Variant>,std::vector<std::string> );
 
+    /**
+     * Update the properties from the reply to a GetAll call.
+     */
+    void update_all_properties( std::shared_ptr<const ReturnMessage> reply );
+
+    /**
+     * Fetch the properties with one GetAll call if prefetching is on and
+     * it hasn't been done yet.
+     */
+    void prefetch_properties();
+
+    /**
+     * Create a Get call for each of the given properties that we know about.
+     *
+     * @return The properties that the calls are for, in the same order
+     */
+    std::vector<std::shared_ptr<PropertyProxyBase>> create_get_calls( const std::vector<std::string>& names,
+                                                                      std::vector<std::shared_ptr<const CallMessage>>* msgs );
+
+    /**
+     * Fetch the given properties again without waiting for the replies.
+     */
+    void refetch_properties( const std::vector<std::string>& names );
+
 private:
     class priv_data;
 
     DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
 
     friend class ObjectProxy;
+    friend class PropertyProxyBase;
+    friend class MethodProxyBase;
 };
 
 }
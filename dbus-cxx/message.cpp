@@ -42,6 +42,7 @@ public:
     uint8_t m_flags;
     std::vector<int> m_filedescriptors;
     uint32_t m_serial;
+    std::shared_ptr<const MessageHeaderTemplate> m_headerTemplate;
 };
 
 Message::Message() {
@@ -228,12 +229,35 @@ bool Message::serialize_to_vector( std::vector<uint8_t>* vec, uint32_t serial )
     // Marshal our header array
     marshal.marshal( static_cast<uint32_t>( 0 ) ); // The size of the header array; we update this later
 
-    for( const std::pair<const MessageHeaderFields, Variant>& entry : m_priv->m_headerMap ) {
-        if( entry.second.type() == DataType::INVALID ) { continue; }
+    const std::shared_ptr<const MessageHeaderTemplate>& headerTemplate = m_priv->m_headerTemplate;
+    bool useTemplate = headerTemplate &&
+        ( m_priv->m_headerMap.empty() ||
+          m_priv->m_headerMap.begin()->first > headerTemplate->last_field() );
 
-        marshal.align( 8 );
-        marshal.marshal( header_field_to_int( entry.first ) );
-        marshal.marshal( entry.second );
+    if( useTemplate ) {
+        // All of our fields come after the template fields, so copy the
+        // pre-marshaled data and then add our own fields(signature, fds)
+        const std::vector<uint8_t>& templateData = headerTemplate->marshaled();
+        vec->insert( vec->end(), templateData.begin(), templateData.end() );
+    }
+
+    if( useTemplate || !headerTemplate ) {
+        for( const std::pair<const MessageHeaderFields, Variant>& entry : m_priv->m_headerMap ) {
+            if( entry.second.type() == DataType::INVALID ) { continue; }
+
+            marshal.align( 8 );
+            marshal.marshal( header_field_to_int( entry.first ) );
+            marshal.marshal( entry.second );
+        }
+    } else {
+        // Some of the template fields have been overridden; marshal everything
+        for( const std::pair<const MessageHeaderFields, Variant>& entry : all_header_fields() ) {
+            if( entry.second.type() == DataType::INVALID ) { continue; }
+
+            marshal.align( 8 );
+            marshal.marshal( header_field_to_int( entry.first ) );
+            marshal.marshal( entry.second );
+        }
     }
 
     // The size of the header array is always at offset 12
@@ -378,9 +402,84 @@ Variant Message::header_field( MessageHeaderFields field ) const {
         return location->second;
     }
 
+    if( m_priv->m_headerTemplate ) {
+        location = m_priv->m_headerTemplate->fields().find( field );
+
+        if( location != m_priv->m_headerTemplate->fields().end() ) {
+            return location->second;
+        }
+    }
+
     return DBus::Variant();
 }
 
+std::string_view Message::header_field_view( MessageHeaderFields field ) const {
+    const Variant* value = nullptr;
+    std::map<MessageHeaderFields, Variant>::const_iterator location =
+        m_priv->m_headerMap.find( field );
+
+    if( location != m_priv->m_headerMap.end() ) {
+        value = &location->second;
+    } else if( m_priv->m_headerTemplate ) {
+        location = m_priv->m_headerTemplate->fields().find( field );
+
+        if( location != m_priv->m_headerTemplate->fields().end() ) {
+            value = &location->second;
+        }
+    }
+
+    if( !value ) { return std::string_view(); }
+
+    // Variants are always marshaled big-endian: strings and object paths
+    // have a 4-byte length, signatures a 1-byte length.
+    const std::vector<uint8_t>* data = value->marshaled();
+    size_t offset;
+    size_t length;
+
+    switch( value->type() ) {
+    case DataType::STRING:
+    case DataType::OBJECT_PATH:
+        if( data->size() < 4 ) { return std::string_view(); }
+
+        length = ( static_cast<uint32_t>( ( *data )[ 0 ] ) << 24 ) |
+            ( static_cast<uint32_t>( ( *data )[ 1 ] ) << 16 ) |
+            ( static_cast<uint32_t>( ( *data )[ 2 ] ) << 8 ) |
+            static_cast<uint32_t>( ( *data )[ 3 ] );
+        offset = 4;
+        break;
+
+    case DataType::SIGNATURE:
+        if( data->empty() ) { return std::string_view(); }
+
+        length = ( *data )[ 0 ];
+        offset = 1;
+        break;
+
+    default:
+        return std::string_view();
+    }
+
+    if( offset + length > data->size() ) { return std::string_view(); }
+
+    return std::string_view( reinterpret_cast<const char*>( data->data() + offset ), length );
+}
+
+std::map<MessageHeaderFields, Variant> Message::all_header_fields() const {
+    if( !m_priv->m_headerTemplate ) {
+        return m_priv->m_headerMap;
+    }
+
+    std::map<MessageHeaderFields, Variant> allFields = m_priv->m_headerMap;
+    allFields.insert( m_priv->m_headerTemplate->fields().begin(),
+        m_priv->m_headerTemplate->fields().end() );
+
+    return allFields;
+}
+
+void Message::set_header_template( std::shared_ptr<const MessageHeaderTemplate> header_template ) {
+    m_priv->m_headerTemplate = header_template;
+}
+
 void Message::clear_sig_and_data() {
     std::map<MessageHeaderFields, Variant>::const_iterator location =
         m_priv->m_headerMap.find( MessageHeaderFields::Signature );
@@ -392,6 +491,25 @@ void Message::clear_sig_and_data() {
     m_priv->m_body.clear();
 }
 
+bool Message::copy_body( const Message& other ) {
+    if( !other.m_priv->m_filedescriptors.empty() ||
+        other.endianess() != endianess() ) {
+        return false;
+    }
+
+    clear_sig_and_data();
+
+    Variant sig = other.header_field( MessageHeaderFields::Signature );
+
+    if( sig.type() == DataType::SIGNATURE ) {
+        m_priv->m_headerMap[ MessageHeaderFields::Signature ] = sig;
+    }
+
+    m_priv->m_body = other.m_priv->m_body;
+
+    return true;
+}
+
 uint8_t Message::flags() const {
     return m_priv->m_flags;
 }
@@ -475,7 +593,7 @@ std::ostream& operator <<( std::ostream& os, const DBus::Message* msg ) {
     os << "  Serial: " << msg->m_priv->m_serial << std::endl;
     os << "  Headers:" << std::endl;
 
-    for( const std::pair<const MessageHeaderFields, DBus::Variant>& set : msg->m_priv->m_headerMap ) {
+    for( const std::pair<const MessageHeaderFields, DBus::Variant>& set : msg->all_header_fields() ) {
         os << "    ";
 
         switch( set.first ) {
@@ -528,4 +646,46 @@ std::ostream& operator <<( std::ostream& os, const DBus::Message* msg ) {
     return os;
 }
 
+MessageHeaderTemplate::MessageHeaderTemplate( const std::map<MessageHeaderFields, Variant>& fields ) :
+    m_lastField( MessageHeaderFields::Invalid ) {
+    // Marshal the fields as if they were at offset 16 of a message, so that
+    // the alignment of the data is correct when it is copied into a message
+    std::vector<uint8_t> data( 16, 0 );
+    Marshaling marshal( &data, Endianess::Big );
+
+    for( const std::pair<const MessageHeaderFields, Variant>& entry : fields ) {
+        if( entry.second.type() == DataType::INVALID ) { continue; }
+
+        if( entry.first == MessageHeaderFields::Signature ||
+            entry.first == MessageHeaderFields::Unix_FDs ) {
+            continue;
+        }
+
+        marshal.align( 8 );
+        marshal.marshal( header_field_to_int( entry.first ) );
+        marshal.marshal( entry.second );
+
+        m_fields[ entry.first ] = entry.second;
+        m_lastField = entry.first;
+    }
+
+    m_marshaled.assign( data.begin() + 16, data.end() );
+}
+
+std::shared_ptr<const MessageHeaderTemplate> MessageHeaderTemplate::create( const Message& msg ) {
+    return std::shared_ptr<const MessageHeaderTemplate>( new MessageHeaderTemplate( msg.all_header_fields() ) );
+}
+
+const std::map<MessageHeaderFields, Variant>& MessageHeaderTemplate::fields() const {
+    return m_fields;
+}
+
+const std::vector<uint8_t>& MessageHeaderTemplate::marshaled() const {
+    return m_marshaled;
+}
+
+MessageHeaderFields MessageHeaderTemplate::last_field() const {
+    return m_lastField;
+}
+
 }
@@ -9,8 +9,11 @@
 #include <dbus-cxx/error.h>
 #include <dbus-cxx/messageappenditerator.h>
 #include <dbus-cxx/messageiterator.h>
+#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "enums.h"
 
 #include <dbus-cxx/variant.h>
@@ -23,6 +26,11 @@
 
 namespace DBus {
 class ReturnMessage;
+class MessageHeaderTemplate;
+
+namespace priv {
+class IncomingQueue;
+}
 
 /**
  * @defgroup message DBus Messages
@@ -127,6 +135,16 @@ public:
      */
     Variant header_field( MessageHeaderFields field ) const;
 
+    /**
+     * Returns the given string-like header field(a string, object path or
+     * signature) without making a copy of it.  The view is only valid while
+     * this message exists and the field is not changed.
+     *
+     * @param field The field number to get
+     * @return The value of the field, or an empty view if it does not exist
+     */
+    std::string_view header_field_view( MessageHeaderFields field ) const;
+
     /**
      * The message flags, as the marshaled byte
      * @return
@@ -142,6 +160,17 @@ public:
      */
     Variant set_header_field( MessageHeaderFields field, Variant value );
 
+    /**
+     * Replace the body and the signature of this message with a copy of the
+     * ones from the given message, so that a body that is sent over and over
+     * only has to be marshaled once.
+     *
+     * @param other The message to copy the body from
+     * @return False if the body can't be copied, because the other message
+     * has file descriptors or a different endianess
+     */
+    bool copy_body( const Message& other );
+
     Endianess endianess() const;
 
     const std::vector<int>& filedescriptors() const;
@@ -159,7 +188,22 @@ protected:
 
     void set_flags( uint8_t flags );
 
+    /**
+     * Use the given pre-marshaled header fields for this message.  The fields
+     * in the template are visible through header_field(), and are copied as-is
+     * when this message is serialized.
+     *
+     * @param header_template The template to use
+     */
+    void set_header_template( std::shared_ptr<const MessageHeaderTemplate> header_template );
+
 private:
+    /**
+     * All of the header fields on this message, including the fields that
+     * come from the header template.
+     */
+    std::map<MessageHeaderFields, Variant> all_header_fields() const;
+
     std::vector<uint8_t>* body();
     const std::vector<uint8_t>* body() const;
     void add_filedescriptor( int fd );
@@ -173,10 +217,59 @@ private:
 
     friend class MessageAppendIterator;
     friend class MessageIterator;
+    friend class MessageHeaderTemplate;
+    friend class priv::IncomingQueue;
     friend std::ostream& operator<<( std::ostream& os, const DBus::Message* msg );
 
 };
 
+/**
+ * A set of header fields that have been marshaled once and can be shared between
+ * many messages.  Method proxies and signals send messages whose path, interface,
+ * member and destination never change, so these fields are marshaled only once;
+ * when a message created from a template is serialized, only the serial, the
+ * signature and the body length need to be filled in.
+ *
+ * @ingroup message
+ */
+class MessageHeaderTemplate {
+private:
+    MessageHeaderTemplate( const std::map<MessageHeaderFields, Variant>& fields );
+
+public:
+    /**
+     * Create a new template from the header fields that are currently
+     * set on the given message.  The signature and unix fds are never part of
+     * the template, since they depend upon the data in the message.
+     *
+     * @param msg The message to take the header fields from
+     * @return The new template
+     */
+    static std::shared_ptr<const MessageHeaderTemplate> create( const Message& msg );
+
+    /**
+     * The header fields in this template.
+     */
+    const std::map<MessageHeaderFields, Variant>& fields() const;
+
+    /**
+     * The marshaled header fields.  The data starts at offset 16 of a message,
+     * directly after the length of the header field array.
+     */
+    const std::vector<uint8_t>& marshaled() const;
+
+    /**
+     * The field with the highest number in this template.  Any field with a
+     * number higher than this may be marshaled directly after the template data.
+     */
+    MessageHeaderFields last_field() const;
+
+private:
+    std::map<MessageHeaderFields, Variant> m_fields;
+    std::vector<uint8_t> m_marshaled;
+    MessageHeaderFields m_lastField;
+};
+
 
 template <typename T>
 inline
@@ -53,6 +53,9 @@ MessageIterator::MessageIterator( DataType d,
     if( d == DataType::ARRAY ) {
         m_priv->m_subiterInfo.m_subiterDataType = d;
         uint32_t array_len = m_priv->m_demarshal->demarshal_uint32_t();
+        // The padding up to the first element is not part of the length, and
+        // is there even when the array is empty
+        m_priv->m_demarshal->align( TypeInfo( sig.type() ).alignment() );
         m_priv->m_subiterInfo.m_arrayLastPosition = m_priv->m_demarshal->current_offset() + array_len;
         SIMPLELOGGER_TRACE_STDSTR( LOGGER_NAME,
                                    "Extracting array.  new position: " << m_priv->m_demarshal->current_offset()
@@ -6,6 +6,7 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include "methodbase.h"
+#include "concurrencylimiter.h"
 #include "dbus-cxx-private.h"
 #include "dbus-cxx/connection.h"
 
@@ -19,6 +20,8 @@ public:
 
     const std::string m_name;
     std::vector<std::string> m_arg_names;
+    priv::ConcurrencyLimiter m_limiter;
+    sigc::signal<void()> m_signal_introspection_changed;
 };
 
 MethodBase::MethodBase( const std::string& name ):
@@ -38,6 +41,7 @@ void MethodBase::set_arg_name( size_t i, const std::string& name ) {
     }
 
     m_priv->m_arg_names[i] = name;
+    m_priv->m_signal_introspection_changed.emit();
 }
 
 std::string MethodBase::arg_name( size_t i ) const {
@@ -57,5 +61,25 @@ const std::vector<std::string>& MethodBase::arg_names() const {
     return m_priv->m_arg_names;
 }
 
+sigc::signal<void()> MethodBase::signal_introspection_changed() {
+    return m_priv->m_signal_introspection_changed;
+}
+
+void MethodBase::set_concurrency_limit( unsigned int maxInFlight, unsigned int maxQueued ) {
+    m_priv->m_limiter.set_limits( maxInFlight, maxQueued );
+}
+
+uint64_t MethodBase::rejected_calls() const {
+    return m_priv->m_limiter.rejected();
+}
+
+priv::ConcurrencyLimiter::Admission MethodBase::admit_call( std::function<void()> resume ) {
+    return m_priv->m_limiter.acquire( resume );
+}
+
+void MethodBase::finish_call() {
+    m_priv->m_limiter.release();
+}
+
 }
 
@@ -11,6 +11,7 @@
 #include <exception>
 #include <stdint.h>
 #include <dbus-cxx/callmessage.h>
+#include <dbus-cxx/concurrencylimiter.h>
 #include <dbus-cxx/dbus-cxx-config.h>
 #include <dbus-cxx/errormessage.h>
 #include <dbus-cxx/headerlog.h>
@@ -69,10 +70,48 @@ public:
 
     const std::vector<std::string>& arg_names() const;
 
+    /**
+     * Signal emitted when the name of an argument changes, so that the
+     * introspection of the interface that we are on changes too.
+     */
+    sigc::signal<void()> signal_introspection_changed();
+
+    /**
+     * Limit how many calls to this method can run at once.  When that many
+     * calls are running, up to maxQueued more calls wait for one of them to
+     * finish, without holding up a thread while they wait, and then run in
+     * the thread that the object is called in; any calls past that get an
+     * org.freedesktop.DBus.Error.LimitsExceeded error right away, without
+     * their arguments being looked at.
+     *
+     * Calls can only run at the same time when the object is called from
+     * the thread pool.
+     *
+     * @param maxInFlight How many calls can run at once, or 0 for no limit(the default)
+     * @param maxQueued How many calls can wait for a turn to run
+     */
+    void set_concurrency_limit( unsigned int maxInFlight, unsigned int maxQueued = 0 );
+
+    /** How many calls have been rejected because of the concurrency limit */
+    uint64_t rejected_calls() const;
+
+private:
+    /**
+     * Check the concurrency limit before calling this method.
+     *
+     * @param resume Called once a call that was parked has its turn
+     */
+    priv::ConcurrencyLimiter::Admission admit_call( std::function<void()> resume );
+
+    /** Finish a call that has its turn */
+    void finish_call();
+
 private:
     class priv_data;
 
     DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+
+    friend class Interface;
 };
 
 template <typename T_type>
@@ -112,6 +151,10 @@ public:
 
         if( !connection || !message ) { return HandlerResult::Not_Handled; }
 
+        // If the caller does not want a reply, we still call the method but
+        // nothing(including any error) is sent back.
+        const bool expects_reply = message->expects_reply();
+
         try {
             std::shared_ptr<ReturnMessage> retmsg = message->create_reply();
 
@@ -119,20 +162,26 @@ public:
 
             method_sig_gen.extractAndCall( message, retmsg, m_slot );
 
-            sendMessage( connection, retmsg );
+            if( expects_reply ) { sendMessage( connection, retmsg ); }
         } catch( ErrorInvalidTypecast& e ) {
+            if( !expects_reply ) { return HandlerResult::Handled; }
+
             std::shared_ptr<ErrorMessage> errmsg = ErrorMessage::create( message, DBUSCXX_ERROR_INVALID_SIGNATURE, e.what() );
 
             if( !errmsg ) { return HandlerResult::Not_Handled; }
 
             sendMessage( connection, errmsg );
         } catch( const std::exception& e ) {
+            if( !expects_reply ) { return HandlerResult::Handled; }
+
             std::shared_ptr<ErrorMessage> errmsg = ErrorMessage::create( message, DBUSCXX_ERROR_FAILED, e.what() );
 
             if( !errmsg ) { return HandlerResult::Not_Handled; }
 
             sendMessage( connection, errmsg );
         } catch( ... ) {
+            if( !expects_reply ) { return HandlerResult::Handled; }
+
             std::ostringstream stream;
             stream << "DBus-cxx " << DBUS_CXX_PACKAGE_MAJOR_VERSION << "."
                 << DBUS_CXX_PACKAGE_MINOR_VERSION << "."
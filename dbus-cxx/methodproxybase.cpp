@@ -8,20 +8,29 @@
 #include "methodproxybase.h"
 #include "callmessage.h"
 #include "interfaceproxy.h"
+#include "connection.h"
+#include <atomic>
+#include <mutex>
 
 namespace DBus {
 
-class PendingCall;
 class ReturnMessage;
 
 class MethodProxyBase::priv_data {
 public:
     priv_data( const std::string& name ) :
         m_interface( nullptr ),
-        m_name( name ) {}
+        m_name( name ),
+        m_noReply( false ),
+        m_headerGeneration( 0 ) {}
 
     InterfaceProxy* m_interface;
     const std::string m_name;
+    std::atomic<bool> m_noReply;
+    mutable std::mutex m_headerTemplateLock;
+    mutable std::shared_ptr<const MessageHeaderTemplate> m_headerTemplate;
+    /* The target generation of the interface that the template was made with */
+    mutable uint64_t m_headerGeneration;
 };
 
 
@@ -32,6 +41,7 @@ MethodProxyBase::MethodProxyBase( const std::string& name ):
 MethodProxyBase::MethodProxyBase( const MethodProxyBase& other ) :
     m_priv( std::make_unique<priv_data>( other.m_priv->m_name ) ) {
     m_priv->m_interface = other.m_priv->m_interface;
+    m_priv->m_noReply = other.m_priv->m_noReply.load();
 }
 
 std::shared_ptr<MethodProxyBase> MethodProxyBase::create( const std::string& name ) {
@@ -52,7 +62,30 @@ const std::string& MethodProxyBase::name() const {
 std::shared_ptr<CallMessage> DBus::MethodProxyBase::create_call_message() const {
     if( !m_priv->m_interface ) { return std::shared_ptr<CallMessage>(); }
 
-    std::shared_ptr<CallMessage> cm = m_priv->m_interface->create_call_message( m_priv->m_name );
+    std::shared_ptr<const MessageHeaderTemplate> headerTemplate;
+    uint64_t generation = m_priv->m_interface->target_generation();
+    {
+        std::scoped_lock lock( m_priv->m_headerTemplateLock );
+
+        if( m_priv->m_headerGeneration == generation ) { headerTemplate = m_priv->m_headerTemplate; }
+    }
+
+    std::shared_ptr<CallMessage> cm;
+
+    if( headerTemplate ) {
+        cm = CallMessage::create( headerTemplate );
+    } else {
+        // The header fields for this method only change when the proxy is
+        // pointed somewhere else, so marshal them once and re-use them for
+        // all subsequent calls until then.
+        cm = m_priv->m_interface->create_call_message( m_priv->m_name );
+        headerTemplate = MessageHeaderTemplate::create( *cm );
+
+        std::scoped_lock lock( m_priv->m_headerTemplateLock );
+        m_priv->m_headerTemplate = headerTemplate;
+        m_priv->m_headerGeneration = generation;
+    }
+
     cm->set_no_reply( false );
     return cm;
 }
@@ -63,14 +96,34 @@ std::shared_ptr<const ReturnMessage> DBus::MethodProxyBase::call( std::shared_pt
     return m_priv->m_interface->call( call_message, timeout_milliseconds );
 }
 
-//  std::shared_ptr<PendingCall> DBus::MethodProxyBase::call_async(std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds) const
-//  {
-//    if ( not m_priv->m_interface ) return std::shared_ptr<PendingCall>();
-//    return m_priv->m_interface->call_async(call_message, timeout_milliseconds);
-//  }
+void DBus::MethodProxyBase::send_no_reply( std::shared_ptr<const CallMessage> call_message ) const {
+    if( !m_priv->m_interface ) { return; }
+
+    std::shared_ptr<Connection> conn = m_priv->m_interface->connection().lock();
+
+    if( !conn ) { return; }
+
+    conn->send( call_message );
+}
+
+void MethodProxyBase::set_no_reply( bool no_reply ) {
+    m_priv->m_noReply = no_reply;
+}
+
+bool MethodProxyBase::no_reply() const {
+    return m_priv->m_noReply;
+}
+
+std::shared_ptr<PendingCall> DBus::MethodProxyBase::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds ) const {
+    if( !m_priv->m_interface ) { return std::shared_ptr<PendingCall>(); }
+
+    return m_priv->m_interface->call_async( call_message, timeout_milliseconds );
+}
 
 void MethodProxyBase::set_interface( InterfaceProxy* proxy ) {
+    std::scoped_lock lock( m_priv->m_headerTemplateLock );
     m_priv->m_interface = proxy;
+    m_priv->m_headerTemplate.reset();
 }
 
 }
@@ -9,6 +9,8 @@
  ***************************************************************************/
 #include <dbus-cxx/callmessage.h>
 #include <dbus-cxx/headerlog.h>
+#include <dbus-cxx/awaitable.h>
+#include <dbus-cxx/pendingcall.h>
 #include <dbus-cxx/utility.h>
 #include <memory>
 #include <mutex>
@@ -58,7 +60,37 @@ public:
 
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
-    //      std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds=-1 ) const;
+    /**
+     * Send the given message without waiting for a reply.  This returns as
+     * soon as the message has been queued for sending.  The message should have
+     * the NO_REPLY_EXPECTED flag set, so that the remote side does not send
+     * a reply either.
+     *
+     * @param call_message The message to send
+     */
+    void send_no_reply( std::shared_ptr<const CallMessage> call_message ) const;
+
+    /**
+     * Set this method to be a one-way method.  When set, calling a method that
+     * returns void will send the call with NO_REPLY_EXPECTED set and return
+     * immediately instead of waiting for the reply.  Has no effect on methods
+     * that return a value.
+     *
+     * @param no_reply True to not wait for replies
+     */
+    void set_no_reply( bool no_reply = true );
+
+    bool no_reply() const;
+
+    /**
+     * Send the given message without blocking.  The returned PendingCall is
+     * completed from the dispatching thread when the reply comes in.
+     *
+     * @param call_message The message to send
+     * @param timeout_milliseconds How long to wait for the reply
+     * @return The PendingCall, or an invalid pointer if we are not connected
+     */
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds = -1 ) const;
 
 private:
     void set_interface( InterfaceProxy* proxy );
@@ -95,11 +127,42 @@ public:
         debug_str << name();
         DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
 
+        if( no_reply() ) {
+            call_no_reply( args... );
+            return;
+        }
+
         std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
         ( *_callmsg << ... << args );
         std::shared_ptr<const ReturnMessage> retmsg = this->call( _callmsg, -1 );
     }
 
+    /**
+     * Call this method without waiting for a reply.  The call is sent with the
+     * NO_REPLY_EXPECTED flag set, and this returns as soon as the call has been
+     * queued.  Any error from the remote side will not be seen.
+     */
+    void call_no_reply( T_arg... args ) {
+        std::ostringstream debug_str;
+        DBus::priv::dbus_function_traits<std::function<void( T_arg... )>> method_sig_gen;
+
+        debug_str << "DBus::MethodProxy<";
+        debug_str << method_sig_gen.debug_string();
+        debug_str << "> calling no reply method=";
+        debug_str << name();
+        DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
+
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        _callmsg->set_no_reply( true );
+        ( *_callmsg << ... << args );
+        this->send_no_reply( _callmsg );
+    }
+
+    /**
+     * Call this method without blocking.  No thread is created for the call;
+     * the returned future is completed from the dispatching thread when the
+     * reply comes in, so it must not be waited upon from the dispatching thread.
+     */
     std::future<void> call_async( T_arg... args ) {
         std::ostringstream debug_str;
         DBus::priv::dbus_function_traits<std::function<void( T_arg... )>> method_sig_gen;
@@ -110,7 +173,44 @@ public:
         debug_str << name();
         DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
 
-        return std::async( std::launch::async, *this, args... );
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        ( *_callmsg << ... << args );
+
+        std::shared_ptr<std::promise<void>> _promise = std::make_shared<std::promise<void>>();
+        std::future<void> _future = _promise->get_future();
+        std::shared_ptr<PendingCall> _pending = MethodProxyBase::call_async( _callmsg, -1 );
+
+        if( !_pending ) {
+            _promise->set_exception( std::make_exception_ptr( ErrorDisconnected() ) );
+            return _future;
+        }
+
+        _pending->set_notify( [_promise]( std::shared_ptr<PendingCall> call ) {
+            try {
+                call->return_message();
+                _promise->set_value();
+            } catch( ... ) {
+                _promise->set_exception( std::current_exception() );
+            }
+        } );
+
+        return _future;
+    }
+
+    using MethodProxyBase::call_async;
+
+    /**
+     * Call this method asynchronously, returning an object that can be
+     * awaited from a C++20 coroutine:
+     *
+     * @code
+     * co_await method->async( args... );
+     * @endcode
+     */
+    MethodCallAwaitable<void> async( T_arg... args ) {
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        ( *_callmsg << ... << args );
+        return MethodCallAwaitable<void>( MethodProxyBase::call_async( _callmsg, -1 ) );
     }
 
     static std::shared_ptr<MethodProxy> create( const std::string& name ) {
@@ -150,6 +250,11 @@ public:
         return _retval;
     }
 
+    /**
+     * Call this method without blocking.  No thread is created for the call;
+     * the returned future is completed from the dispatching thread when the
+     * reply comes in, so it must not be waited upon from the dispatching thread.
+     */
     std::future<T_return> call_async( T_arg... args ) {
         std::ostringstream debug_str;
         DBus::priv::dbus_function_traits<std::function<void( T_arg... )>> method_sig_gen;
@@ -160,7 +265,48 @@ public:
         debug_str << name();
         DBUSCXX_DEBUG_STDSTR( "DBus.MethodProxy", debug_str.str() );
 
-        return std::async( std::launch::async, *this, args... );
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        MessageAppendIterator iter = _callmsg->append();
+        ( void )( iter << ... << args );
+
+        std::shared_ptr<std::promise<T_return>> _promise = std::make_shared<std::promise<T_return>>();
+        std::future<T_return> _future = _promise->get_future();
+        std::shared_ptr<PendingCall> _pending = MethodProxyBase::call_async( _callmsg, -1 );
+
+        if( !_pending ) {
+            _promise->set_exception( std::make_exception_ptr( ErrorDisconnected() ) );
+            return _future;
+        }
+
+        _pending->set_notify( [_promise]( std::shared_ptr<PendingCall> call ) {
+            try {
+                std::shared_ptr<const ReturnMessage> retmsg = call->return_message();
+                T_return _retval;
+                retmsg >> _retval;
+                _promise->set_value( _retval );
+            } catch( ... ) {
+                _promise->set_exception( std::current_exception() );
+            }
+        } );
+
+        return _future;
+    }
+
+    using MethodProxyBase::call_async;
+
+    /**
+     * Call this method asynchronously, returning an object that can be
+     * awaited from a C++20 coroutine:
+     *
+     * @code
+     * T_return value = co_await method->async( args... );
+     * @endcode
+     */
+    MethodCallAwaitable<T_return> async( T_arg... args ) {
+        std::shared_ptr<CallMessage> _callmsg = this->create_call_message();
+        MessageAppendIterator iter = _callmsg->append();
+        ( void )( iter << ... << args );
+        return MethodCallAwaitable<T_return>( MethodProxyBase::call_async( _callmsg, -1 ) );
     }
 
     static std::shared_ptr<MethodProxy> create( const std::string& name ) {
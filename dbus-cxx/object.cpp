@@ -8,14 +8,19 @@
 #include "object.h"
 #include <cstring>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
 #include <fstream>
+#include <mutex>
 #include <utility>
+#include <vector>
 #include "callmessage.h"
 #include "connection.h"
 #include "dbus-cxx-private.h"
 #include "interface.h"
 #include "message.h"
 #include "path.h"
+#include "returnmessage.h"
 #include <sigc++/sigc++.h>
 #include "utility.h"
 
@@ -26,15 +31,68 @@ class ErrorInvalidMessageType;
 class ReturnMessage;
 
 typedef std::map<std::shared_ptr<Interface>, sigc::connection> InterfaceSignalNameConnections;
+typedef std::map<std::shared_ptr<Interface>, std::vector<sigc::connection>> InterfaceIntrospectionConnections;
+
+/**
+ * Where a call to a particular interface name goes: one of the standard
+ * interfaces that the object implements itself, or a user interface.
+ */
+struct InterfaceRoute {
+    enum class Kind {
+        Introspectable,
+        Peer,
+        Properties,
+        User
+    };
+
+    Kind kind;
+    std::shared_ptr<Interface> interface_ptr;
+};
+
+typedef std::unordered_map<std::string_view, InterfaceRoute> InterfaceRoutes;
 
 class Object::priv_data {
 public:
-    priv_data() {}
+    priv_data() :
+        m_introspection_generation( 0 ) {
+        rebuild_routes();
+    }
+
+    /**
+     * Throw away the cached introspection data.  The generation is bumped so
+     * that data that was being built at the same time doesn't get cached.
+     */
+    void invalidate_introspection() {
+        std::unique_lock<std::mutex> lock( m_introspection_lock );
+        m_introspection.clear();
+        m_introspection_reply.reset();
+        m_introspection_generation++;
+    }
+
+    /**
+     * Rebuild the routes from the current interfaces.  The keys are views of
+     * the keys of m_interfaces, so this must be called with the interfaces
+     * write-locked whenever they change.
+     */
+    void rebuild_routes() {
+        m_routes.clear();
+        m_routes.reserve( m_interfaces.size() + 3 );
+
+        // The standard interfaces take precedence over user interfaces
+        m_routes.emplace( DBUS_CXX_INTROSPECTABLE_INTERFACE, InterfaceRoute{ InterfaceRoute::Kind::Introspectable, nullptr } );
+        m_routes.emplace( DBUS_CXX_PEER_INTERFACE, InterfaceRoute{ InterfaceRoute::Kind::Peer, nullptr } );
+        m_routes.emplace( DBUS_CXX_PROPERTIES_INTERFACE, InterfaceRoute{ InterfaceRoute::Kind::Properties, nullptr } );
+
+        for( const std::pair<const std::string, std::shared_ptr<Interface>>& iface : m_interfaces ) {
+            m_routes.emplace( iface.first, InterfaceRoute{ InterfaceRoute::Kind::User, iface.second } );
+        }
+    }
 
     Children m_children;
     mutable std::shared_mutex m_interfaces_rwlock;
     std::mutex m_name_mutex;
     Interfaces m_interfaces;
+    InterfaceRoutes m_routes;
     std::shared_ptr<Interface>  m_default_interface;
     sigc::signal<void( std::shared_ptr<Interface>, std::shared_ptr<Interface> ) > m_signal_default_interface_changed;
     sigc::signal<void( std::shared_ptr<Interface> ) > m_signal_interface_added;
@@ -44,11 +102,25 @@ public:
     Path m_path;
     sigc::signal<void( std::shared_ptr<Connection> ) > m_signal_registered;
     sigc::signal<void( std::shared_ptr<Connection> ) > m_signal_unregistered;
+    InterfaceIntrospectionConnections m_introspection_connections;
+    /* The introspection data with no indent, and a reply with it already
+     * marshaled; both are empty until they are needed */
+    mutable std::mutex m_introspection_lock;
+    mutable std::string m_introspection;
+    mutable std::shared_ptr<const ReturnMessage> m_introspection_reply;
+    uint64_t m_introspection_generation;
 };
 
 Object::Object( const std::string& path ):
     m_priv( std::make_unique<priv_data>() ) {
     m_priv->m_path = path;
+
+    m_priv->m_signal_interface_added.connect( [this]( std::shared_ptr<Interface> ) {
+        m_priv->invalidate_introspection();
+    } );
+    m_priv->m_signal_interface_removed.connect( [this]( std::shared_ptr<Interface> ) {
+        m_priv->invalidate_introspection();
+    } );
 }
 
 std::shared_ptr<Object> Object::create( const std::string& path ) {
@@ -56,6 +128,9 @@ std::shared_ptr<Object> Object::create( const std::string& path ) {
 }
 
 Object::~ Object( ) {
+    for( std::pair<const std::shared_ptr<Interface>, std::vector<sigc::connection>>& conns : m_priv->m_introspection_connections ) {
+        for( sigc::connection& c : conns.second ) { c.disconnect(); }
+    }
 }
 
 const Path& Object::path() const {
@@ -131,9 +206,23 @@ bool Object::add_interface( std::shared_ptr<Interface> interface_ptr ) {
 
         if( i == m_priv->m_interface_signal_name_connections.end() ) {
             m_priv->m_interfaces.insert( std::make_pair( interface_ptr->name(), interface_ptr ) );
+            m_priv->rebuild_routes();
 
             interface_ptr->set_path( path() );
             interface_ptr->set_connection( connection() );
+
+            if( m_priv->m_introspection_connections.find( interface_ptr ) == m_priv->m_introspection_connections.end() ) {
+                std::vector<sigc::connection>& conns = m_priv->m_introspection_connections[ interface_ptr ];
+                conns.push_back( interface_ptr->signal_method_added().connect( [this]( std::shared_ptr<MethodBase> ) {
+                    m_priv->invalidate_introspection();
+                } ) );
+                conns.push_back( interface_ptr->signal_method_removed().connect( [this]( std::shared_ptr<MethodBase> ) {
+                    m_priv->invalidate_introspection();
+                } ) );
+                conns.push_back( interface_ptr->signal_introspection_changed().connect( [this]() {
+                    m_priv->invalidate_introspection();
+                } ) );
+            }
         } else {
             result = false;
         }
@@ -171,6 +260,7 @@ void Object::remove_interface( const std::string& name ) {
         if( iter != m_priv->m_interfaces.end() ) {
             interface_ptr = iter->second;
             m_priv->m_interfaces.erase( iter );
+            m_priv->rebuild_routes();
         }
 
         if( interface_ptr ) {
@@ -180,6 +270,15 @@ void Object::remove_interface( const std::string& name ) {
                 i->second.disconnect();
                 m_priv->m_interface_signal_name_connections.erase( i );
             }
+
+            InterfaceIntrospectionConnections::iterator conns =
+                m_priv->m_introspection_connections.find( interface_ptr );
+
+            if( conns != m_priv->m_introspection_connections.end() ) {
+                for( sigc::connection& c : conns->second ) { c.disconnect(); }
+
+                m_priv->m_introspection_connections.erase( conns );
+            }
         }
     }
 
@@ -258,6 +357,7 @@ bool Object::add_child( const std::string& name, std::shared_ptr<Object> child,
     if( conn ) {
         m_priv->m_children[name] = child;
         child->set_connection( conn );
+        m_priv->invalidate_introspection();
         return true;
     }
 
@@ -270,6 +370,7 @@ bool Object::remove_child( const std::string& name ) {
     if( i == m_priv->m_children.end() ) { return false; }
 
     m_priv->m_children.erase( i );
+    m_priv->invalidate_introspection();
     return true;
 }
 
@@ -278,6 +379,16 @@ bool Object::has_child( const std::string& name ) const {
 }
 
 std::string Object::introspect( int space_depth ) const {
+    uint64_t generation = 0;
+
+    if( space_depth == 0 ) {
+        std::unique_lock<std::mutex> lock( m_priv->m_introspection_lock );
+
+        if( !m_priv->m_introspection.empty() ) { return m_priv->m_introspection; }
+
+        generation = m_priv->m_introspection_generation;
+    }
+
     std::ostringstream sout;
     std::string spaces;
     Interfaces::const_iterator i;
@@ -328,6 +439,13 @@ std::string Object::introspect( int space_depth ) const {
     }
 
     sout << spaces << "</node>\n";
+
+    if( space_depth == 0 ) {
+        std::unique_lock<std::mutex> lock( m_priv->m_introspection_lock );
+
+        if( generation == m_priv->m_introspection_generation ) { m_priv->m_introspection = sout.str(); }
+    }
+
     return sout.str();
 }
 
@@ -359,21 +477,51 @@ HandlerResult Object::handle_message( std::shared_ptr<const Message> message ) {
 
     msg = std::static_pointer_cast<const CallMessage>( message );
 
-    if( msg->interface_name() == DBUS_CXX_INTROSPECTABLE_INTERFACE ) {
+    InterfaceRoute route{ InterfaceRoute::Kind::User, nullptr };
+    bool found;
+
+    {
+        std::shared_lock lock( m_priv->m_interfaces_rwlock );
+        InterfaceRoutes::const_iterator route_iter =
+            m_priv->m_routes.find( msg->header_field_view( MessageHeaderFields::Interface ) );
+
+        found = route_iter != m_priv->m_routes.end();
+
+        if( found ) { route = route_iter->second; }
+    }
+
+    if( route.kind == InterfaceRoute::Kind::Introspectable ) {
         SIMPLELOGGER_DEBUG( LOGGER_NAME, "Object::handle_call_message: introspection interface called" );
         std::shared_ptr<ReturnMessage> return_message = msg->create_reply();
-        std::string introspection = DBUSCXX_INTROSPECT_1_0_XML_DOCTYPE_DECL_NODE;
-        introspection += this->introspect();
-        *return_message << introspection;
+        std::shared_ptr<const ReturnMessage> cached;
+        uint64_t generation;
+
+        {
+            std::unique_lock<std::mutex> lock( m_priv->m_introspection_lock );
+            cached = m_priv->m_introspection_reply;
+            generation = m_priv->m_introspection_generation;
+        }
+
+        if( !cached || !return_message->copy_body( *cached ) ) {
+            std::string introspection = DBUSCXX_INTROSPECT_1_0_XML_DOCTYPE_DECL_NODE;
+            introspection += this->introspect();
+            *return_message << introspection;
+
+            std::unique_lock<std::mutex> lock( m_priv->m_introspection_lock );
+
+            if( generation == m_priv->m_introspection_generation ) { m_priv->m_introspection_reply = return_message; }
+        }
+
         conn << return_message;
         return HandlerResult::Handled;
-    } else if( msg->interface_name() == DBUS_CXX_PEER_INTERFACE ) {
+    } else if( route.kind == InterfaceRoute::Kind::Peer ) {
         SIMPLELOGGER_DEBUG( LOGGER_NAME, "Object::handle_call_message: peer interface called" );
+        std::string_view member = msg->header_field_view( MessageHeaderFields::Member );
 
-        if( msg->member() == "Ping" ) {
+        if( member == "Ping" ) {
             conn << msg->create_reply();
             return HandlerResult::Handled;
-        } else if( msg->member() == "GetMachineId" ) {
+        } else if( member == "GetMachineId" ) {
             std::ifstream inputFile( "/var/lib/dbus/machine-id" );
             std::string line;
             std::getline( inputFile, line );
@@ -394,35 +542,34 @@ HandlerResult Object::handle_message( std::shared_ptr<const Message> message ) {
         }
 
         return HandlerResult::Invalid_Method;
-    } else if( msg->interface_name() == DBUS_CXX_PROPERTIES_INTERFACE ){
+    } else if( route.kind == InterfaceRoute::Kind::Properties ){
         SIMPLELOGGER_DEBUG( LOGGER_NAME, "Object::handle_call_message: properties interface called" );
         std::string requestedInterfaceName;
         msg >> requestedInterfaceName;
 
-        std::shared_lock lock( m_priv->m_interfaces_rwlock );
-        Interfaces::iterator iface_iter = m_priv->m_interfaces.find( requestedInterfaceName);
         std::shared_ptr<Interface> interface_ptr;
-        if( iface_iter == m_priv->m_interfaces.end() ) {
-            // Unable to find an interface to use, try to use the default
-            if( m_priv->m_default_interface ) {
-                return m_priv->m_default_interface->handle_properties_message( conn, msg );
+
+        {
+            std::shared_lock lock( m_priv->m_interfaces_rwlock );
+            Interfaces::iterator iface_iter = m_priv->m_interfaces.find( requestedInterfaceName );
+
+            if( iface_iter != m_priv->m_interfaces.end() ) {
+                interface_ptr = iface_iter->second;
+            } else {
+                // Unable to find an interface to use, try to use the default
+                interface_ptr = m_priv->m_default_interface;
             }
+        }
 
-            return  HandlerResult::Invalid_Interface;
-        } else {
-            interface_ptr = iface_iter->second;
-            return interface_ptr->handle_properties_message( conn, msg );
+        if( !interface_ptr ) {
+            return HandlerResult::Invalid_Interface;
         }
-    }
 
-    std::shared_lock lock( m_priv->m_interfaces_rwlock );
-    Interfaces::iterator iface_iter;
-    std::shared_ptr<Interface> interface_ptr;
+        return interface_ptr->handle_properties_message( conn, msg );
+    }
 
     SIMPLELOGGER_DEBUG( LOGGER_NAME, "Object::handle_message: message is good (it's a call message) for interface '" << msg->interface_name() << "'" );
 
-    iface_iter = m_priv->m_interfaces.find( msg->interface_name() );
-
     /*
      * DBus Specification:
      *
@@ -431,17 +578,18 @@ HandlerResult Object::handle_message( std::shared_ptr<const Message> message ) {
      * invoked. Implementations may choose to either return an error, or deliver the message
      * as though it had an arbitrary one of those interfaces.
      */
-    if( iface_iter == m_priv->m_interfaces.end() ) {
+    if( !found ) {
         // Unable to find an interface to use, try to use the default
-        if( m_priv->m_default_interface ) {
-            return m_priv->m_default_interface->handle_call_message( conn, msg );
+        std::shared_ptr<Interface> default_interface = m_priv->m_default_interface;
+
+        if( default_interface ) {
+            return default_interface->handle_call_message( conn, msg );
         }
 
         return  HandlerResult::Invalid_Interface;
-    } else {
-        interface_ptr = iface_iter->second;
-        return interface_ptr->handle_call_message( conn, msg );
     }
+
+    return route.interface_ptr->handle_call_message( conn, msg );
 }
 
 
@@ -320,7 +320,12 @@ public:
      */
     bool has_child( const std::string& name ) const;
 
-    /** Returns a DBus XML description of this interface */
+    /**
+     * Returns a DBus XML description of this object.
+     *
+     * The description with no indent is cached until an interface, method,
+     * signal, property or child is added or removed.
+     */
     std::string introspect( int space_depth = 0 ) const;
 
     /**
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "objectpathregistry.h"
+#include "object.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+using DBus::priv::ObjectPathRegistry;
+
+struct PathNode {
+    // std::less<> lets us look up children by string_view without a copy
+    std::map<std::string, std::unique_ptr<PathNode>, std::less<>> children;
+    ObjectPathRegistry::Entry entry;
+};
+
+/**
+ * Call the function with each element of the path, stopping early if it
+ * returns false.
+ */
+template <typename T_func>
+static void for_each_element( std::string_view path, T_func func ) {
+    size_t pos = 0;
+
+    while( pos < path.size() ) {
+        size_t next = path.find( '/', pos );
+
+        if( next == std::string_view::npos ) { next = path.size(); }
+
+        if( next > pos && !func( path.substr( pos, next - pos ) ) ) {
+            return;
+        }
+
+        pos = next + 1;
+    }
+}
+
+class ObjectPathRegistry::priv_data {
+public:
+    priv_data() {}
+
+    /**
+     * Find the node for the given path, optionally creating it.
+     * Must be called with the lock held.
+     */
+    PathNode* find_node( std::string_view path, bool create ) {
+        PathNode* node = &m_root;
+
+        for_each_element( path, [&node, create]( std::string_view element ) {
+            std::map<std::string, std::unique_ptr<PathNode>, std::less<>>::iterator it =
+                node->children.find( element );
+
+            if( it == node->children.end() ) {
+                if( !create ) {
+                    node = nullptr;
+                    return false;
+                }
+
+                it = node->children.emplace( std::string( element ), std::make_unique<PathNode>() ).first;
+            }
+
+            node = it->second.get();
+            return true;
+        } );
+
+        return node;
+    }
+
+    /**
+     * Remove nodes below the given node that have neither an entry nor
+     * any children.
+     *
+     * @return True if this node is now empty
+     */
+    static bool prune( PathNode* node, std::function<bool( const ObjectPathRegistry::Entry& )> should_remove ) {
+        if( node->entry.handler && should_remove( node->entry ) ) {
+            node->entry = ObjectPathRegistry::Entry();
+        }
+
+        for( auto it = node->children.begin(); it != node->children.end(); ) {
+            if( prune( it->second.get(), should_remove ) ) {
+                it = node->children.erase( it );
+            } else {
+                it++;
+            }
+        }
+
+        return !node->entry.handler && node->children.empty();
+    }
+
+    mutable std::shared_mutex m_lock;
+    PathNode m_root;
+};
+
+ObjectPathRegistry::ObjectPathRegistry() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+ObjectPathRegistry::~ObjectPathRegistry() {
+}
+
+bool ObjectPathRegistry::add( const std::string& path, const Entry& entry ) {
+    std::unique_lock lock( m_priv->m_lock );
+    PathNode* node = m_priv->find_node( path, true );
+
+    if( node->entry.handler ) { return false; }
+
+    node->entry = entry;
+
+    return true;
+}
+
+bool ObjectPathRegistry::remove( const std::string& path ) {
+    std::unique_lock lock( m_priv->m_lock );
+    std::vector<std::pair<PathNode*, std::string_view>> parents;
+    PathNode* node = &m_priv->m_root;
+
+    for_each_element( path, [&node, &parents]( std::string_view element ) {
+        std::map<std::string, std::unique_ptr<PathNode>, std::less<>>::iterator it =
+            node->children.find( element );
+
+        if( it == node->children.end() ) {
+            node = nullptr;
+            return false;
+        }
+
+        parents.push_back( std::make_pair( node, element ) );
+        node = it->second.get();
+        return true;
+    } );
+
+    if( !node || !node->entry.handler ) { return false; }
+
+    node->entry = Entry();
+
+    // Get rid of the nodes that were only there to lead to this one
+    while( !parents.empty() && !node->entry.handler && node->children.empty() ) {
+        node = parents.back().first;
+        node->children.erase( node->children.find( parents.back().second ) );
+        parents.pop_back();
+    }
+
+    return true;
+}
+
+bool ObjectPathRegistry::set_handling_thread( const std::string& path, std::optional<std::thread::id> thread ) {
+    std::unique_lock lock( m_priv->m_lock );
+    PathNode* node = m_priv->find_node( path, false );
+
+    if( !node || !node->entry.handler ) { return false; }
+
+    node->entry.handlingThread = thread;
+
+    return true;
+}
+
+void ObjectPathRegistry::remove_handled_by( const std::vector<std::thread::id>& threads ) {
+    std::unique_lock lock( m_priv->m_lock );
+
+    m_priv->prune( &m_priv->m_root, [&threads]( const Entry& entry ) {
+        return entry.handlingThread &&
+            std::find( threads.begin(), threads.end(), *entry.handlingThread ) != threads.end();
+    } );
+}
+
+ObjectPathRegistry::Entry ObjectPathRegistry::lookup( std::string_view path ) const {
+    std::shared_lock lock( m_priv->m_lock );
+    const PathNode* node = &m_priv->m_root;
+    const PathNode* fallback = nullptr;
+    bool found = true;
+
+    if( node->entry.handler && node->entry.fallback ) { fallback = node; }
+
+    for_each_element( path, [&node, &fallback, &found]( std::string_view element ) {
+        std::map<std::string, std::unique_ptr<PathNode>, std::less<>>::const_iterator it =
+            node->children.find( element );
+
+        if( it == node->children.end() ) {
+            found = false;
+            return false;
+        }
+
+        node = it->second.get();
+
+        if( node->entry.handler && node->entry.fallback ) { fallback = node; }
+
+        return true;
+    } );
+
+    if( found && node->entry.handler ) { return node->entry; }
+
+    if( fallback ) { return fallback->entry; }
+
+    return Entry();
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_OBJECTPATHREGISTRY_H
+#define DBUS_CXX_OBJECTPATHREGISTRY_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace DBus {
+
+class Object;
+
+namespace priv {
+
+/**
+ * Keeps track of the objects that are exported on a connection, in a trie
+ * indexed by the elements of the object path.
+ *
+ * An object may be registered as a fallback, in which case it also handles
+ * all of the paths below it that don't have an object of their own.
+ *
+ * All methods may be called from any thread.
+ */
+class ObjectPathRegistry {
+public:
+    struct Entry {
+        Entry() :
+            fallback( false )
+        {}
+
+        std::shared_ptr<Object> handler;
+        /** The thread that calls are handled on, or none for the thread pool */
+        std::optional<std::thread::id> handlingThread;
+        bool fallback;
+    };
+
+    ObjectPathRegistry();
+
+    ~ObjectPathRegistry();
+
+    /**
+     * Add an entry at the given path.
+     *
+     * @return False if there is already an entry at this path
+     */
+    bool add( const std::string& path, const Entry& entry );
+
+    /**
+     * Remove the entry at the given path.
+     *
+     * @return True if there was an entry to remove
+     */
+    bool remove( const std::string& path );
+
+    /**
+     * Change the thread that the entry at the given path is handled on.
+     *
+     * @return True if there is an entry at this path
+     */
+    bool set_handling_thread( const std::string& path, std::optional<std::thread::id> thread );
+
+    /**
+     * Remove all of the entries that are handled by one of the given threads.
+     */
+    void remove_handled_by( const std::vector<std::thread::id>& threads );
+
+    /**
+     * Find the entry that handles the given path: the entry at that exact
+     * path, or else the closest fallback entry above it.
+     *
+     * @return The entry; the handler is invalid if nothing handles this path
+     */
+    Entry lookup( std::string_view path ) const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_OBJECTPATHREGISTRY_H */
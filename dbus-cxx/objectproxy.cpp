@@ -42,6 +42,8 @@ public:
     std::shared_ptr<PeerInterfaceProxy> m_peerInterface;
     std::shared_ptr<IntrospectableInterfaceProxy> m_introspectableInterface;
     std::shared_ptr<PropertiesInterfaceProxy> m_propertiesInterface;
+    std::mutex m_propertiesChangedLock;
+    std::shared_ptr<SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> m_propertiesChanged;
 };
 
 ObjectProxy::ObjectProxy( std::shared_ptr<Connection> conn, const std::string& destination, const std::string& path ):
@@ -68,6 +70,11 @@ std::shared_ptr<ObjectProxy> ObjectProxy::create( std::shared_ptr<Connection> co
 }
 
 ObjectProxy::~ ObjectProxy( ) {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( conn && m_priv->m_propertiesChanged ) {
+        conn->remove_free_signal_proxy( m_priv->m_propertiesChanged );
+    }
 }
 
 std::weak_ptr<Connection> ObjectProxy::connection() const {
@@ -76,6 +83,8 @@ std::weak_ptr<Connection> ObjectProxy::connection() const {
 
 void ObjectProxy::set_connection( std::shared_ptr<Connection> conn ) {
     m_priv->m_connection = conn;
+
+    update_properties_subscription();
 }
 
 const std::string& ObjectProxy::destination() const {
@@ -84,6 +93,15 @@ const std::string& ObjectProxy::destination() const {
 
 void ObjectProxy::set_destination( const std::string& destination ) {
     m_priv->m_destination = destination;
+
+    {
+        std::shared_lock lock( m_priv->m_interfaces_rwlock );
+        for( Interfaces::iterator i = m_priv->m_interfaces.begin(); i != m_priv->m_interfaces.end(); i++ ) {
+            i->second->on_object_set_destination();
+        }
+    }
+
+    update_properties_subscription();
 }
 
 const Path& ObjectProxy::path() const {
@@ -96,6 +114,8 @@ void ObjectProxy::set_path( const std::string& path ) {
     for( Interfaces::iterator i = m_priv->m_interfaces.begin(); i != m_priv->m_interfaces.end(); i++ ) {
         i->second->on_object_set_path( path );
     }
+
+    update_properties_subscription();
 }
 
 const ObjectProxy::Interfaces& ObjectProxy::interfaces() const {
@@ -131,6 +151,8 @@ bool ObjectProxy::add_interface( std::shared_ptr<InterfaceProxy> interface_ptr )
 
     }
 
+    invalidate_signal_routes();
+    update_properties_subscription();
     m_priv->m_signal_interface_added.emit( interface_ptr );
 
     return result;
@@ -163,7 +185,11 @@ void ObjectProxy::remove_interface( const std::string& name ) {
 
     }
 
-    if( interface_ptr ) { m_priv->m_signal_interface_removed.emit( interface_ptr ); }
+    if( interface_ptr ) {
+        invalidate_signal_routes();
+        update_properties_subscription();
+        m_priv->m_signal_interface_removed.emit( interface_ptr );
+    }
 }
 
 void ObjectProxy::remove_interface( std::shared_ptr<InterfaceProxy> interface_ptr ) {
@@ -186,7 +212,11 @@ void ObjectProxy::remove_interface( std::shared_ptr<InterfaceProxy> interface_pt
 
     }
 
-    if( interface_removed ) { m_priv->m_signal_interface_removed.emit( interface_ptr ); }
+    if( interface_removed ) {
+        invalidate_signal_routes();
+        update_properties_subscription();
+        m_priv->m_signal_interface_removed.emit( interface_ptr );
+    }
 }
 
 bool ObjectProxy::has_interface( const std::string& name ) const {
@@ -263,6 +293,14 @@ std::shared_ptr<const ReturnMessage> ObjectProxy::call( std::shared_ptr<const Ca
     return conn->send_with_reply_blocking( call_message, timeout_milliseconds );
 }
 
+std::shared_ptr<PendingCall> ObjectProxy::call_async( std::shared_ptr<const CallMessage> call_message, int timeout_milliseconds ) const {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( !conn ) { return std::shared_ptr<PendingCall>(); }
+
+    return conn->send_with_reply_async( call_message, timeout_milliseconds );
+}
+
 sigc::signal< void( std::shared_ptr<InterfaceProxy> )> ObjectProxy::signal_interface_added() {
     return m_priv->m_signal_interface_added;
 }
@@ -283,5 +321,63 @@ std::shared_ptr<PropertiesInterfaceProxy> ObjectProxy::getPropertiesInterface(){
     return m_priv->m_propertiesInterface;
 }
 
+void ObjectProxy::invalidate_signal_routes() {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( conn ) { conn->invalidate_signal_routes(); }
+}
+
+void ObjectProxy::update_properties_subscription() {
+    bool hasProperties = false;
+
+    {
+        std::shared_lock lock( m_priv->m_interfaces_rwlock );
+
+        for( Interfaces::value_type& iface : m_priv->m_interfaces ) {
+            if( iface.second->has_properties() ) {
+                hasProperties = true;
+                break;
+            }
+        }
+    }
+
+    // Only the object that we are a proxy for can change our properties
+    DBus::SignalMatchRule matchRule = DBus::MatchRuleBuilder::create()
+        .set_sender( destination() )
+        .set_path( path() )
+        .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
+        .set_member( "PropertiesChanged" )
+        .as_signal_match();
+
+    std::unique_lock lock( m_priv->m_propertiesChangedLock );
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    // Drop a subscription that isn't needed anymore, or that is for where
+    // we used to point
+    if( m_priv->m_propertiesChanged &&
+        ( !hasProperties || m_priv->m_propertiesChanged->match_rule() != matchRule.match_rule() ) ) {
+        if( conn ) { conn->remove_free_signal_proxy( m_priv->m_propertiesChanged ); }
+
+        m_priv->m_propertiesChanged.reset();
+    }
+
+    if( hasProperties && !m_priv->m_propertiesChanged && conn ) {
+        m_priv->m_propertiesChanged =
+            conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
+                matchRule );
+
+        m_priv->m_propertiesChanged->connect( sigc::mem_fun( *this, &ObjectProxy::properties_changed ) );
+    }
 }
 
+void ObjectProxy::properties_changed( std::string iface,
+                                      std::map<std::string,DBus::Variant> changed,
+                                      std::vector<std::string> invalidated ) {
+    std::shared_ptr<InterfaceProxy> interface_ptr = interface_by_name( iface );
+
+    if( interface_ptr ) {
+        interface_ptr->property_updated( iface, changed, invalidated );
+    }
+}
+
+}
@@ -125,6 +125,15 @@ public:
      */
     std::shared_ptr<const ReturnMessage> call( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
 
+    /**
+     * Forwards this CallMessage to the Connection that this ObjectProxy is on without
+     * waiting for the response.
+     *
+     * @param timeout_milliseconds
+     * @return The PendingCall that will be completed when the response comes in
+     */
+    std::shared_ptr<PendingCall> call_async( std::shared_ptr<const CallMessage>, int timeout_milliseconds = -1 ) const;
+
     /**
      * Creates a proxy method with a signature based on the template parameters and adds it to the named interface
      * @return A smart pointer to the newly created method proxy
@@ -192,10 +201,28 @@ public:
 
     std::shared_ptr<PropertiesInterfaceProxy> getPropertiesInterface();
 
+private:
+    /**
+     * Subscribe to PropertiesChanged from our destination if any of our
+     * interfaces has a property, or unsubscribe if none of them do.  All of
+     * the interfaces share the one subscription, which follows the object
+     * when its destination or path changes.
+     */
+    void update_properties_subscription();
+
+    void properties_changed( std::string, std::map<std::string,DBus::Variant>, std::vector<std::string> );
+
+    /**
+     * Let our connection know that our signal proxies have changed.
+     */
+    void invalidate_signal_routes();
+
 private:
     class priv_data;
 
     DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+
+    friend class InterfaceProxy;
 };
 
 }
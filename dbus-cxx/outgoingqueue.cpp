@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "outgoingqueue.h"
+#include "message.h"
+
+#include <atomic>
+
+using DBus::priv::OutgoingQueue;
+
+struct QueueNode {
+    QueueNode() :
+        serial( 0 ),
+        next( nullptr )
+    {}
+
+    std::shared_ptr<const DBus::Message> msg;
+    uint32_t serial;
+    std::atomic<QueueNode*> next;
+};
+
+/*
+ * A linked list of nodes, with producers adding to the head and the consumer
+ * taking from the tail.  A producer only has to swap the head pointer and
+ * then link the old head to its node, so producers never wait for each other
+ * or for the consumer.
+ *
+ * The stub node is always somewhere in the list so that it is never empty;
+ * the consumer moves it to the end of the list whenever it comes across it.
+ */
+class OutgoingQueue::priv_data {
+public:
+    priv_data() :
+        m_head( &m_stub ),
+        m_tail( &m_stub ),
+        m_size( 0 )
+    {}
+
+    void push_node( QueueNode* node ) {
+        node->next.store( nullptr, std::memory_order_relaxed );
+        QueueNode* prev = m_head.exchange( node, std::memory_order_acq_rel );
+        prev->next.store( node, std::memory_order_release );
+    }
+
+    /**
+     * Take the node at the end of the list, or nullptr if there isn't one
+     * that is completely linked in yet.
+     */
+    QueueNode* pop_node() {
+        QueueNode* tail = m_tail;
+        QueueNode* next = tail->next.load( std::memory_order_acquire );
+
+        if( tail == &m_stub ) {
+            if( !next ) { return nullptr; }
+
+            m_tail = next;
+            tail = next;
+            next = next->next.load( std::memory_order_acquire );
+        }
+
+        if( next ) {
+            m_tail = next;
+            return tail;
+        }
+
+        if( tail != m_head.load( std::memory_order_acquire ) ) {
+            // A producer has swapped the head but not linked it in yet
+            return nullptr;
+        }
+
+        push_node( &m_stub );
+        next = tail->next.load( std::memory_order_acquire );
+
+        if( next ) {
+            m_tail = next;
+            return tail;
+        }
+
+        return nullptr;
+    }
+
+    QueueNode m_stub;
+    std::atomic<QueueNode*> m_head;
+    QueueNode* m_tail;
+    std::atomic<size_t> m_size;
+};
+
+OutgoingQueue::OutgoingQueue() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+OutgoingQueue::~OutgoingQueue() {
+    QueueNode* node;
+
+    while( ( node = m_priv->pop_node() ) != nullptr ) {
+        delete node;
+    }
+}
+
+void OutgoingQueue::push( std::shared_ptr<const Message> msg, uint32_t serial ) {
+    QueueNode* node = new QueueNode();
+
+    node->msg = msg;
+    node->serial = serial;
+    m_priv->m_size.fetch_add( 1, std::memory_order_acq_rel );
+    m_priv->push_node( node );
+}
+
+size_t OutgoingQueue::pop_all( std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>>* messages ) {
+    QueueNode* node;
+    size_t taken = 0;
+
+    while( ( node = m_priv->pop_node() ) != nullptr ) {
+        messages->push_back( std::make_pair( std::move( node->msg ), node->serial ) );
+        delete node;
+        taken++;
+    }
+
+    m_priv->m_size.fetch_sub( taken, std::memory_order_acq_rel );
+
+    return taken;
+}
+
+bool OutgoingQueue::empty() const {
+    return m_priv->m_size.load( std::memory_order_acquire ) == 0;
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_OUTGOINGQUEUE_H
+#define DBUS_CXX_OUTGOINGQUEUE_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace DBus {
+
+class Message;
+
+namespace priv {
+
+/**
+ * The queue of messages that are waiting to be written out.
+ *
+ * Any number of threads may push onto this queue at the same time without
+ * blocking each other.  Only one thread at a time may take messages off of
+ * the queue; the caller is responsible for making sure of that.
+ */
+class OutgoingQueue {
+public:
+    OutgoingQueue();
+
+    ~OutgoingQueue();
+
+    /**
+     * Add a message to the end of the queue.  May be called from any thread.
+     */
+    void push( std::shared_ptr<const Message> msg, uint32_t serial );
+
+    /**
+     * Take all of the messages that are currently in the queue off of it,
+     * adding them to the end of the given vector.
+     *
+     * A message that is in the middle of being pushed may not be taken yet;
+     * it will be taken by the next call.
+     *
+     * @return The number of messages taken
+     */
+    size_t pop_all( std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>>* messages );
+
+    /**
+     * Check to see if there is anything in the queue.  This may be out of
+     * date by the time it returns if other threads are pushing messages.
+     */
+    bool empty() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_OUTGOINGQUEUE_H */
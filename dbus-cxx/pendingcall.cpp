@@ -6,57 +6,180 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include "pendingcall.h"
+#include "connection.h"
 #include "error.h"
+#include "errormessage.h"
 #include "message.h"
+#include "returnmessage.h"
 #include <sigc++/sigc++.h>
+#include <condition_variable>
+#include <mutex>
 
 namespace DBus {
 
+class PendingCall::priv_data {
+public:
+    priv_data( uint32_t serial ) :
+        m_serial( serial ),
+        m_canceled( false ),
+        m_completed( false )
+    {}
 
-//  PendingCall::PendingCall() :
-//      m_canceled( false )
-//  {
-//  }
-
-//  std::shared_ptr<PendingCall> PendingCall::create()
-//  {
-//    return std::shared_ptr<PendingCall>( new PendingCall() );
-//  }
-
-//  PendingCall::~PendingCall()
-//  {
-//  }
-
-//  void PendingCall::cancel()
-//  {
-//      m_canceled = true;
-//  }
-
-//  bool PendingCall::completed() const
-//  {
-//    return m_reply->is_valid();
-//  }
-
-//  std::shared_ptr<Message> PendingCall::reply() const
-//  {
-//    return m_reply;
-//  }
-
-//  void PendingCall::block() const
-//  {
-//      if( m_canceled ){
-//          return;
-//      }
-//  }
-
-//  sigc::signal<void()> PendingCall::signal_notify() const
-//  {
-//    return m_signal_notify;
-//  }
-
-//  void PendingCall::set_reply( std::shared_ptr<Message> msg ){
-//      m_reply = msg;
-//      m_signal_notify.emit();
-//  }
+    const uint32_t m_serial;
+    mutable std::mutex m_lock;
+    mutable std::condition_variable m_cv;
+    bool m_canceled;
+    bool m_completed;
+    std::shared_ptr<Message> m_reply;
+    sigc::slot<void( std::shared_ptr<PendingCall> )> m_notify;
+    std::weak_ptr<Connection> m_connection;
+};
+
+PendingCall::PendingCall( uint32_t serial ) :
+    m_priv( std::make_unique<priv_data>( serial ) ) {
+}
+
+std::shared_ptr<PendingCall> PendingCall::create( uint32_t serial ) {
+    return std::shared_ptr<PendingCall>( new PendingCall( serial ) );
+}
+
+PendingCall::~PendingCall() {
+}
+
+uint32_t PendingCall::serial() const {
+    return m_priv->m_serial;
+}
+
+void PendingCall::cancel() {
+    std::shared_ptr<Connection> conn;
+    sigc::slot<void( std::shared_ptr<PendingCall> )> notify;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+        if( m_priv->m_canceled ) { return; }
+
+        m_priv->m_canceled = true;
+        notify = m_priv->m_notify;
+        m_priv->m_notify = sigc::slot<void( std::shared_ptr<PendingCall> )>();
+        conn = m_priv->m_connection.lock();
+    }
+
+    m_priv->m_cv.notify_all();
+
+    // Whoever is waiting on the slot still needs to know that we are done
+    if( notify ) { notify( shared_from_this() ); }
+
+    // Nobody wants the reply anymore, so stop waiting for it
+    if( conn ) { conn->take_pending_call( m_priv->m_serial ); }
+}
+
+bool PendingCall::is_canceled() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_canceled;
+}
+
+bool PendingCall::completed() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_completed;
+}
+
+bool PendingCall::is_timeout() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_completed && !m_priv->m_reply;
+}
+
+std::shared_ptr<const Message> PendingCall::reply() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    return m_priv->m_reply;
+}
+
+std::shared_ptr<const ReturnMessage> PendingCall::return_message() const {
+    std::shared_ptr<Message> reply;
+    bool completed;
+    bool canceled;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+        reply = m_priv->m_reply;
+        completed = m_priv->m_completed;
+        canceled = m_priv->m_canceled;
+    }
+
+    if( !completed && canceled ) {
+        throw ErrorCallCanceled( "The call was canceled" );
+    }
+
+    if( !completed ) { return std::shared_ptr<const ReturnMessage>(); }
+
+    if( !reply ) {
+        throw ErrorNoReply( "Did not receive a response in the alotted time" );
+    }
+
+    if( reply->type() == MessageType::ERROR ) {
+        std::static_pointer_cast<ErrorMessage>( reply )->throw_error();
+    }
+
+    return std::static_pointer_cast<const ReturnMessage>( reply );
+}
+
+void PendingCall::block() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    m_priv->m_cv.wait( lock, [this] {
+        return m_priv->m_completed || m_priv->m_canceled;
+    } );
+}
+
+bool PendingCall::block_until( std::chrono::steady_clock::time_point deadline ) const {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+    return m_priv->m_cv.wait_until( lock, deadline, [this] {
+        return m_priv->m_completed || m_priv->m_canceled;
+    } );
+}
+
+void PendingCall::set_notify( sigc::slot<void( std::shared_ptr<PendingCall> )> slot ) {
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+        if( !m_priv->m_completed && !m_priv->m_canceled ) {
+            m_priv->m_notify = slot;
+            return;
+        }
+    }
+
+    slot( shared_from_this() );
+}
+
+void PendingCall::set_reply( std::shared_ptr<Message> msg ) {
+    sigc::slot<void( std::shared_ptr<PendingCall> )> notify;
+
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_lock );
+
+        if( m_priv->m_completed ) { return; }
+
+        m_priv->m_reply = msg;
+        m_priv->m_completed = true;
+
+        // Release the slot, as it may hold a reference to us
+        notify = m_priv->m_notify;
+        m_priv->m_notify = sigc::slot<void( std::shared_ptr<PendingCall> )>();
+
+        if( m_priv->m_canceled ) {
+            notify = sigc::slot<void( std::shared_ptr<PendingCall> )>();
+        }
+    }
+
+    m_priv->m_cv.notify_all();
+
+    if( notify ) { notify( shared_from_this() ); }
+}
+
+void PendingCall::set_connection( std::weak_ptr<Connection> conn ) {
+    std::unique_lock<std::mutex> lock( m_priv->m_lock );
+    m_priv->m_connection = conn;
+}
 
 }
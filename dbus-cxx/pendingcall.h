@@ -6,73 +6,127 @@
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
 #include <sigc++/sigc++.h>
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
 #include <memory>
+#include <stdint.h>
 
 #ifndef DBUSCXX_PENDING_CALL_H
 #define DBUSCXX_PENDING_CALL_H
 
 namespace DBus {
+class Connection;
 class Message;
+class ReturnMessage;
 
 /**
- * Monitors an asynchronous call, emitting a signal when a response is received
+ * Monitors an asynchronous call, notifying when a response is received.
+ *
+ * A PendingCall is created by Connection::send_with_reply_async().  The
+ * connection keeps track of the call by its serial, and completes it from
+ * the dispatching thread when the reply(or error) comes in, or when the call
+ * times out.  No thread is used to wait for the reply.
  *
  * @ingroup message
  *
  * @author Rick L Vinyard Jr <rvinyard@cs.nmsu.edu>
  */
-//  class PendingCall: public sigc::trackable
-//  {
-//    protected:
-
-//      PendingCall( );
-
-//    public:
-//      static std::shared_ptr<PendingCall> create( );
-
-//      virtual ~PendingCall();
-
-//      /**
-//       * Cancel the pending call; that is, signal_notify() will not
-//       * be emitted if and when the reply eventually comes back.
-//       */
-//      void cancel();
-
-//      /**
-//       * Check to see if the reply has actually come back.
-//       */
-//      bool completed() const;
-
-//      /**
-//       * Check to see if the
-//       * @return
-//       */
-////      bool is_timeout() const;
-
-//      /**
-//       * Get the reply that this pending call represents.  If
-//       * completed() is not true, or this call has been canceled,
-//       * returns an invalid pointer.
-//       *
-//       * @return
-//       */
-//      std::shared_ptr<Message> reply() const;
-
-//      void block() const;
-
-//      sigc::signal<void()> signal_notify() const;
-
-//      void set_reply( std::shared_ptr<Message> msg );
-
-//    private:
-
-//      sigc::signal<void()> m_signal_notify;
-
-//      std::shared_ptr<Message> m_reply;
-
-//      bool m_canceled;
-
-//  };
+class PendingCall : public std::enable_shared_from_this<PendingCall> {
+private:
+    PendingCall( uint32_t serial );
+
+public:
+    static std::shared_ptr<PendingCall> create( uint32_t serial );
+
+    ~PendingCall();
+
+    /**
+     * The serial of the call message that this is waiting for a reply to.
+     */
+    uint32_t serial() const;
+
+    /**
+     * Cancel the pending call; that is, the reply will be ignored if and when
+     * it eventually comes back.  Anybody waiting in block() or block_until()
+     * is woken up, the notify slot is called(from the current thread) and the
+     * connection stops waiting for the reply.
+     */
+    void cancel();
+
+    bool is_canceled() const;
+
+    /**
+     * Check to see if the reply has actually come back, or the call has
+     * timed out.
+     */
+    bool completed() const;
+
+    /**
+     * Check to see if the call timed out before a reply came back.
+     */
+    bool is_timeout() const;
+
+    /**
+     * Get the reply that this pending call represents.  This is either a
+     * ReturnMessage or an ErrorMessage.  If completed() is not true, or the call
+     * timed out, returns an invalid pointer.
+     */
+    std::shared_ptr<const Message> reply() const;
+
+    /**
+     * Get the return message of this call.  If the remote side replied with
+     * an error, the error is thrown; if the call timed out, ErrorNoReply is thrown,
+     * and if it was canceled before the reply came in, ErrorCallCanceled is thrown.
+     *
+     * @return The ReturnMessage, or an invalid pointer if not completed
+     */
+    std::shared_ptr<const ReturnMessage> return_message() const;
+
+    /**
+     * Block the calling thread until this call has completed.
+     *
+     * This must not be called from the dispatching thread of the connection,
+     * as the reply can never be processed in that case.
+     */
+    void block() const;
+
+    /**
+     * Block the calling thread until this call has completed, or until the
+     * given time has passed.  The same restrictions as block() apply.
+     *
+     * @param deadline The time to stop waiting at
+     * @return True if the call has completed(or was canceled)
+     */
+    bool block_until( std::chrono::steady_clock::time_point deadline ) const;
+
+    /**
+     * Set the slot to call when this call completes or is canceled.  The slot
+     * is called from the dispatching thread; if the call has already completed
+     * or been canceled, it is called immediately from the current thread.
+     *
+     * @param slot The slot to call
+     */
+    void set_notify( sigc::slot<void( std::shared_ptr<PendingCall> )> slot );
+
+private:
+    /**
+     * Complete this call.  A null message indicates that the call timed out.
+     */
+    void set_reply( std::shared_ptr<Message> msg );
+
+    /**
+     * Set the connection that is waiting for the reply, so that it can be
+     * told when the call is canceled.
+     */
+    void set_connection( std::weak_ptr<Connection> conn );
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+
+    friend class Connection;
+};
 
 }
 
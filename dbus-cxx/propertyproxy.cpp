@@ -10,6 +10,7 @@
 #include <dbus-cxx/interfaceproxy.h>
 #include <dbus-cxx/objectproxy.h>
 #include "property.h"
+#include <mutex>
 
 using DBus::PropertyProxyBase;
 
@@ -26,6 +27,8 @@ public:
     PropertyUpdateType m_propertyUpdate;
     sigc::signal<void(DBus::Variant)> m_propertyChangedSignal;
     InterfaceProxy* m_interface;
+    /* Locks m_value and m_valueSet */
+    mutable std::mutex m_valueLock;
     Variant m_value;
     bool m_valueSet;
 };
@@ -42,7 +45,12 @@ std::string PropertyProxyBase::name() const {
 }
 
 DBus::Variant PropertyProxyBase::variant_value() {
-    if( !m_priv->m_valueSet && m_priv->m_interface ){
+    if( m_priv->m_interface && !value_set() ){
+        // Get everything at once if the interface is caching everything
+        m_priv->m_interface->prefetch_properties();
+    }
+
+    if( m_priv->m_interface && !value_set() ){
         std::shared_ptr<CallMessage> msg =
                 CallMessage::create( m_priv->m_interface->object()->destination(),
                                      m_priv->m_interface->path(),
@@ -60,6 +68,7 @@ DBus::Variant PropertyProxyBase::variant_value() {
         updated_value( var );
     }
 
+    std::unique_lock<std::mutex> lock( m_priv->m_valueLock );
     return m_priv->m_value;
 }
 
@@ -90,6 +99,7 @@ void PropertyProxyBase::set_value( DBus::Variant value ) {
 
     // This is probably not needed, as the remote object will likely emit a signal with the new value,
     // but this shouldn't cause an issue.
+    std::unique_lock<std::mutex> lock( m_priv->m_valueLock );
     m_priv->m_value = value;
 }
 
@@ -102,12 +112,21 @@ DBus::InterfaceProxy* PropertyProxyBase::interface_name() const {
 }
 
 void PropertyProxyBase::updated_value(Variant value){
-    m_priv->m_value = value;
-    m_priv->m_valueSet = true;
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_valueLock );
+        m_priv->m_value = value;
+        m_priv->m_valueSet = true;
+    }
 
-    m_priv->m_propertyChangedSignal.emit( m_priv->m_value );
+    m_priv->m_propertyChangedSignal.emit( value );
 }
 
 void PropertyProxyBase::invalidate(){
+    std::unique_lock<std::mutex> lock( m_priv->m_valueLock );
     m_priv->m_valueSet = false;
 }
+
+bool PropertyProxyBase::value_set() const {
+    std::unique_lock<std::mutex> lock( m_priv->m_valueLock );
+    return m_priv->m_valueSet;
+}
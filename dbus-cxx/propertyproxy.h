@@ -74,6 +74,8 @@ private:
     void set_interface( InterfaceProxy* proxy );
     void updated_value( Variant value );
     void invalidate();
+    /** True if the value is cached */
+    bool value_set() const;
 
 private:
     class priv_data;
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "replywaitertable.h"
+#include "message.h"
+
+#include <atomic>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+using DBus::priv::ReplyWaiterTable;
+
+/* Must be a power of two */
+#define SLOTS_PER_SEGMENT 256
+/* How many slots from the home slot of a serial it may be stored in */
+#define MAX_PROBE 16
+
+enum class SlotState : uint32_t {
+    Free = 0,
+    Waiting = 1,
+    Completing = 2,
+    Done = 3
+};
+
+static uint64_t make_key( uint32_t serial, SlotState state ) {
+    return ( static_cast<uint64_t>( serial ) << 32 ) | static_cast<uint32_t>( state );
+}
+
+static uint32_t key_serial( uint64_t key ) {
+    return static_cast<uint32_t>( key >> 32 );
+}
+
+/*
+ * The key holds both the serial and the state of the slot, so that it can be
+ * atomically checked that a slot is still waiting for the same serial when
+ * it is being completed.
+ */
+class ReplyWaiterTable::Slot {
+public:
+    Slot() :
+        key( 0 ),
+        ready( 0 )
+    {}
+
+    std::atomic<uint64_t> key;
+    std::atomic<uint32_t> ready;
+    std::shared_ptr<Message> reply;
+#ifndef __linux__
+    std::mutex lock;
+    std::condition_variable cv;
+#endif
+
+    void wake() {
+#ifdef __linux__
+        ready.store( 1, std::memory_order_release );
+        syscall( SYS_futex, reinterpret_cast<uint32_t*>( &ready ), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+#else
+        {
+            std::unique_lock<std::mutex> lk( lock );
+            ready.store( 1, std::memory_order_release );
+        }
+        cv.notify_one();
+#endif
+    }
+
+    /**
+     * Wait until wake() has been called, or the deadline passes.
+     * Waits forever if the deadline is time_point::max().
+     */
+    bool wait_until( std::chrono::steady_clock::time_point deadline ) {
+#ifdef __linux__
+        while( ready.load( std::memory_order_acquire ) == 0 ) {
+            struct timespec timeout;
+            struct timespec* timeoutPtr = nullptr;
+
+            if( deadline != std::chrono::steady_clock::time_point::max() ) {
+                std::chrono::steady_clock::duration remaining = deadline - std::chrono::steady_clock::now();
+
+                if( remaining.count() <= 0 ) { return false; }
+
+                std::chrono::seconds secs = std::chrono::duration_cast<std::chrono::seconds>( remaining );
+                timeout.tv_sec = secs.count();
+                timeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>( remaining - secs ).count();
+                timeoutPtr = &timeout;
+            }
+
+            syscall( SYS_futex, reinterpret_cast<uint32_t*>( &ready ), FUTEX_WAIT_PRIVATE, 0, timeoutPtr, nullptr, 0 );
+        }
+
+        return true;
+#else
+        std::unique_lock<std::mutex> lk( lock );
+        auto isReady = [this] { return ready.load( std::memory_order_acquire ) != 0; };
+
+        if( deadline == std::chrono::steady_clock::time_point::max() ) {
+            cv.wait( lk, isReady );
+            return true;
+        }
+
+        return cv.wait_until( lk, deadline, isReady );
+#endif
+    }
+};
+
+struct Segment {
+    Segment() :
+        next( nullptr )
+    {}
+
+    ReplyWaiterTable::Slot slots[ SLOTS_PER_SEGMENT ];
+    std::atomic<Segment*> next;
+};
+
+class ReplyWaiterTable::priv_data {
+public:
+    priv_data() :
+        m_numWaiters( 0 )
+    {}
+
+    ~priv_data() {
+        Segment* segment = m_first.next.load();
+
+        while( segment ) {
+            Segment* next = segment->next.load();
+            delete segment;
+            segment = next;
+        }
+    }
+
+    Segment m_first;
+    std::atomic<int> m_numWaiters;
+};
+
+ReplyWaiterTable::ReplyWaiterTable() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+ReplyWaiterTable::~ReplyWaiterTable() {
+}
+
+ReplyWaiterTable::Slot* ReplyWaiterTable::add_waiter( uint32_t serial ) {
+    // Serials are handed out sequentially, so they spread out evenly
+    uint32_t home = serial & ( SLOTS_PER_SEGMENT - 1 );
+    Segment* segment = &m_priv->m_first;
+
+    m_priv->m_numWaiters.fetch_add( 1, std::memory_order_acq_rel );
+
+    while( true ) {
+        for( uint32_t x = 0; x < MAX_PROBE; x++ ) {
+            Slot* slot = &segment->slots[ ( home + x ) & ( SLOTS_PER_SEGMENT - 1 ) ];
+            uint64_t expected = 0;
+
+            if( slot->key.load( std::memory_order_relaxed ) != 0 ) { continue; }
+
+            if( slot->key.compare_exchange_strong( expected,
+                    make_key( serial, SlotState::Waiting ),
+                    std::memory_order_acq_rel ) ) {
+                return slot;
+            }
+        }
+
+        Segment* next = segment->next.load( std::memory_order_acquire );
+
+        if( !next ) {
+            Segment* newSegment = new Segment();
+
+            if( segment->next.compare_exchange_strong( next, newSegment, std::memory_order_acq_rel ) ) {
+                next = newSegment;
+            } else {
+                // Somebody else added a segment first; use that one
+                delete newSegment;
+            }
+        }
+
+        segment = next;
+    }
+}
+
+bool ReplyWaiterTable::spin_for_reply( Slot* slot, std::chrono::microseconds window ) {
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + window;
+
+    do {
+        if( slot->ready.load( std::memory_order_acquire ) != 0 ) { return true; }
+    } while( std::chrono::steady_clock::now() < end );
+
+    return slot->ready.load( std::memory_order_acquire ) != 0;
+}
+
+std::shared_ptr<DBus::Message> ReplyWaiterTable::wait_for_reply( Slot* slot, std::chrono::steady_clock::time_point deadline ) {
+    std::shared_ptr<Message> reply;
+
+    if( !slot->wait_until( deadline ) ) {
+        uint64_t expected = make_key( key_serial( slot->key.load( std::memory_order_acquire ) ), SlotState::Waiting );
+
+        if( slot->key.compare_exchange_strong( expected, 0, std::memory_order_acq_rel ) ) {
+            // Timed out; nobody is going to touch this slot anymore
+            m_priv->m_numWaiters.fetch_sub( 1, std::memory_order_acq_rel );
+            return reply;
+        }
+
+        // The reply is being stored right now; wait for it to finish
+        slot->wait_until( std::chrono::steady_clock::time_point::max() );
+    }
+
+    reply = std::move( slot->reply );
+    slot->reply.reset();
+    slot->ready.store( 0, std::memory_order_relaxed );
+    slot->key.store( 0, std::memory_order_release );
+    m_priv->m_numWaiters.fetch_sub( 1, std::memory_order_acq_rel );
+
+    return reply;
+}
+
+bool ReplyWaiterTable::complete( uint32_t reply_serial, std::shared_ptr<Message> reply ) {
+    uint32_t home = reply_serial & ( SLOTS_PER_SEGMENT - 1 );
+    uint64_t waitingKey = make_key( reply_serial, SlotState::Waiting );
+    Segment* segment = &m_priv->m_first;
+
+    if( m_priv->m_numWaiters.load( std::memory_order_acquire ) == 0 ) { return false; }
+
+    while( segment ) {
+        for( uint32_t x = 0; x < MAX_PROBE; x++ ) {
+            Slot* slot = &segment->slots[ ( home + x ) & ( SLOTS_PER_SEGMENT - 1 ) ];
+            uint64_t expected = waitingKey;
+
+            if( slot->key.load( std::memory_order_relaxed ) != waitingKey ) { continue; }
+
+            if( slot->key.compare_exchange_strong( expected,
+                    make_key( reply_serial, SlotState::Completing ),
+                    std::memory_order_acq_rel ) ) {
+                slot->reply = reply;
+                slot->key.store( make_key( reply_serial, SlotState::Done ), std::memory_order_release );
+                slot->wake();
+                return true;
+            }
+        }
+
+        segment = segment->next.load( std::memory_order_acquire );
+    }
+
+    return false;
+}
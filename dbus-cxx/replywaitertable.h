@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_REPLYWAITERTABLE_H
+#define DBUS_CXX_REPLYWAITERTABLE_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+
+namespace DBus {
+
+class Message;
+
+namespace priv {
+
+/**
+ * Keeps track of the threads that are blocked waiting for a reply to a
+ * method call, indexed by the serial of the call.
+ *
+ * The table is open-addressed and lock-free: adding a waiter, completing
+ * it and removing it only use atomic operations on the slot for that
+ * serial, so concurrent callers do not contend with each other.  Each
+ * waiter sleeps on its own slot(using a futex where available) until the
+ * reply has been stored.
+ *
+ * The table grows by adding segments when there are too many waiters at
+ * once; segments are not freed until the table is destroyed.
+ */
+class ReplyWaiterTable {
+public:
+    class Slot;
+
+    ReplyWaiterTable();
+
+    ~ReplyWaiterTable();
+
+    /**
+     * Add a waiter for the reply with the given serial.  This must be
+     * done before the call is sent, so that the reply can't come back
+     * before we know about it.
+     *
+     * @param serial The serial of the call that is being sent
+     * @return The slot to wait on with wait_for_reply()
+     */
+    Slot* add_waiter( uint32_t serial );
+
+    /**
+     * Spin for up to the given amount of time, waiting for the reply to be
+     * given to the slot, without going to sleep.  The slot must still be
+     * waited on with wait_for_reply() afterwards.
+     *
+     * @return True if the reply came in while spinning
+     */
+    bool spin_for_reply( Slot* slot, std::chrono::microseconds window );
+
+    /**
+     * Wait for the reply to be given to the slot, and then release the slot.
+     * Every slot returned from add_waiter() must be waited on exactly once.
+     *
+     * @param slot The slot from add_waiter()
+     * @param deadline When to stop waiting
+     * @return The reply, or an invalid pointer if the deadline passed first
+     */
+    std::shared_ptr<Message> wait_for_reply( Slot* slot, std::chrono::steady_clock::time_point deadline );
+
+    /**
+     * Give the reply to the thread that is waiting for it.
+     *
+     * @param reply_serial The serial that the message is a reply to
+     * @param reply The reply message
+     * @return True if a thread was waiting for this reply
+     */
+    bool complete( uint32_t reply_serial, std::shared_ptr<Message> reply );
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_REPLYWAITERTABLE_H */
@@ -15,9 +15,14 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <chrono>
 
 #include <sys/socket.h>
 #include <sys/types.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#endif
 
 using DBus::priv::SendmsgTransport;
 
@@ -26,6 +31,8 @@ static const char* LOGGER_NAME = "DBus.priv.SendmsgTransport";
 #define RECEIVE_BUFFER_SIZE 1024
 #define SEND_BUFFER_SIZE    2048
 #define CONTROL_BUFFER_SIZE 512
+#define MAX_BATCH_MESSAGES  64
+#define SEND_TIMEOUT_MS     25000
 
 #ifdef _WIN32
 class SendmsgTransport::priv_data {
@@ -171,6 +178,9 @@ public:
     void* tx_control_data;
     int tx_control_capacity;
 
+    std::vector<std::vector<uint8_t>> tx_batch_buffers;
+    std::vector<struct iovec> tx_batch_iov;
+
     void init() {
         // Setup the RX data msghdr
         rx_msg.msg_iov = &rx_buf;
@@ -214,6 +224,79 @@ public:
         return sendmsg( m_fd, &tx_msg, 0 );
     }
 
+    /**
+     * Send the first num_buffers batch buffers with as few calls to sendmsg()
+     * as possible.  Since the socket is non-blocking, wait for it to become
+     * writable again if the kernel only takes part of the data, for up to
+     * SEND_TIMEOUT_MS for the whole batch.  Once part of a message has been
+     * sent the rest of it can't be put off until later, so if the other side
+     * doesn't read it in time this fails with ETIMEDOUT.
+     */
+    ssize_t send_batch( size_t num_buffers ) {
+        struct msghdr batch_msg;
+        ssize_t total = 0;
+        size_t first = 0;
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds( SEND_TIMEOUT_MS );
+
+        tx_batch_iov.resize( num_buffers );
+
+        for( size_t x = 0; x < num_buffers; x++ ) {
+            tx_batch_iov[ x ].iov_base = tx_batch_buffers[ x ].data();
+            tx_batch_iov[ x ].iov_len = tx_batch_buffers[ x ].size();
+        }
+
+        ::memset( &batch_msg, 0, sizeof( struct msghdr ) );
+
+        while( first < num_buffers ) {
+            batch_msg.msg_iov = tx_batch_iov.data() + first;
+            batch_msg.msg_iovlen = num_buffers - first;
+
+            ssize_t ret = sendmsg( m_fd, &batch_msg, 0 );
+
+            if( ret < 0 ) {
+                if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+                    std::chrono::milliseconds remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now() );
+                    struct pollfd pfd;
+                    pfd.fd = m_fd;
+                    pfd.events = POLLOUT;
+                    pfd.revents = 0;
+
+                    if( remaining.count() <= 0 ) {
+                        errno = ETIMEDOUT;
+                        return -1;
+                    }
+
+                    if( ::poll( &pfd, 1, remaining.count() ) < 0 && errno != EINTR ) {
+                        return -1;
+                    }
+
+                    continue;
+                }
+
+                if( errno == EINTR ) { continue; }
+
+                return -1;
+            }
+
+            total += ret;
+
+            // Skip over everything that was sent
+            while( first < num_buffers && static_cast<size_t>( ret ) >= tx_batch_iov[ first ].iov_len ) {
+                ret -= tx_batch_iov[ first ].iov_len;
+                first++;
+            }
+
+            if( first < num_buffers ) {
+                tx_batch_iov[ first ].iov_base = static_cast<uint8_t*>( tx_batch_iov[ first ].iov_base ) + ret;
+                tx_batch_iov[ first ].iov_len -= ret;
+            }
+        }
+
+        return total;
+    }
+
     int receive( ssize_t size, ssize_t control_size, ssize_t name_size, int flags ) {
         rx_msg.msg_iov[0].iov_len = size;
         rx_msg.msg_controllen = control_size;
@@ -341,6 +424,86 @@ ssize_t SendmsgTransport::writeMessage( std::shared_ptr<const DBus::Message> mes
     return ret;
 }
 
+ssize_t SendmsgTransport::writeMessages( const std::vector<std::pair<std::shared_ptr<const DBus::Message>, uint32_t>>& messages,
+    std::vector<uint32_t>* unserializable ) {
+#ifdef _WIN32
+    return Transport::writeMessages( messages, unserializable );
+#else /* POSIX */
+    ssize_t total = 0;
+    ssize_t ret = 0;
+    size_t num_buffers = 0;
+
+    for( const std::pair<std::shared_ptr<const DBus::Message>, uint32_t>& msg : messages ) {
+        if( !msg.first->filedescriptors().empty() ) {
+            /*
+             * File descriptors go along with the data that they are sent with,
+             * so a message with file descriptors is always sent on its own.
+             */
+            if( num_buffers > 0 ) {
+                ret = m_priv->send_batch( num_buffers );
+                num_buffers = 0;
+
+                if( ret < 0 ) { break; }
+
+                total += ret;
+            }
+
+            ret = writeMessage( msg.first, msg.second );
+
+            if( ret < 0 ) { return ret; }
+
+            if( ret == 0 ) {
+                unserializable->push_back( msg.second );
+            }
+
+            total += ret;
+            continue;
+        }
+
+        if( num_buffers == m_priv->tx_batch_buffers.size() ) {
+            m_priv->tx_batch_buffers.emplace_back();
+        }
+
+        std::vector<uint8_t>& buffer = m_priv->tx_batch_buffers[ num_buffers ];
+        buffer.clear();
+
+        if( !msg.first->serialize_to_vector( &buffer, msg.second ) ) {
+            unserializable->push_back( msg.second );
+            continue;
+        }
+
+        std::ostringstream debug_str;
+        debug_str << "Going to send the following bytes: " << std::endl;
+        DBus::hexdump( &buffer, &debug_str );
+        SIMPLELOGGER_TRACE( LOGGER_NAME, debug_str.str() );
+
+        num_buffers++;
+
+        if( num_buffers == MAX_BATCH_MESSAGES ) {
+            ret = m_priv->send_batch( num_buffers );
+            num_buffers = 0;
+
+            if( ret < 0 ) { break; }
+
+            total += ret;
+        }
+    }
+
+    if( ret >= 0 && num_buffers > 0 ) {
+        ret = m_priv->send_batch( num_buffers );
+        total += ret;
+    }
+
+    if( ret < 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Can't send messages: " << strerror( errno ) );
+        m_priv->m_ok = false;
+        return ret;
+    }
+
+    return total;
+#endif
+}
+
 std::shared_ptr<DBus::Message> SendmsgTransport::readMessage() {
     uint32_t header_array_len;
     ssize_t body_len;
@@ -45,6 +45,9 @@ public:
 
     ssize_t writeMessage( std::shared_ptr<const Message> message, uint32_t serial );
 
+    ssize_t writeMessages( const std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>>& messages,
+        std::vector<uint32_t>* unserializable );
+
     std::shared_ptr<Message> readMessage();
 
     /**
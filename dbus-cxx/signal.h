@@ -77,9 +77,12 @@ public:
     }
 
     virtual void set_arg_name( size_t i, const std::string& name ) {
-        if( i < m_arg_names.size() ) {
-            m_arg_names[i] = name;
+        if( m_arg_names.size() <= i ) {
+            m_arg_names.resize( i + 1 );
         }
+
+        m_arg_names[i] = name;
+        signal_introspection_changed().emit();
     }
 
 protected:
@@ -91,7 +94,7 @@ protected:
     sigc::connection m_internal_callback_connection;
 
     void internal_callback( T_type... args ) {
-        std::shared_ptr<SignalMessage> __msg = SignalMessage::create( path(), interface_name(), name() );
+        std::shared_ptr<SignalMessage> __msg = this->create_signal_message();
         DBUSCXX_DEBUG_STDSTR( "DBus.Signal", "Sending following signal: "
             << __msg->path()
             << " "
@@ -99,8 +102,6 @@ protected:
             << " "
             << __msg->member() );
 
-        if( !destination().empty() ) { __msg->set_destination( destination() ); }
-
         ( *__msg << ... << args );
         bool result = this->handle_dbus_outgoing( __msg );
         DBUSCXX_DEBUG_STDSTR( "DBus.Signal", "signal::internal_callback: result=" << result );
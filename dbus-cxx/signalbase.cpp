@@ -8,6 +8,8 @@
 #include "signalbase.h"
 #include "connection.h"
 #include "path.h"
+#include "signalmessage.h"
+#include <mutex>
 
 namespace DBus {
 class Message;
@@ -23,6 +25,9 @@ public:
     std::string m_name;
     std::string m_destination;
     std::string m_match_rule;
+    std::mutex m_headerTemplateLock;
+    std::shared_ptr<const MessageHeaderTemplate> m_headerTemplate;
+    sigc::signal<void()> m_signal_introspection_changed;
 };
 
 SignalBase::SignalBase( const std::string& path, const std::string& interface_name, const std::string& name ):
@@ -72,12 +77,18 @@ void SignalBase::set_sender( const std::string& s ) {
     m_priv->m_sender = s;
 }
 
+sigc::signal<void()> SignalBase::signal_introspection_changed() {
+    return m_priv->m_signal_introspection_changed;
+}
+
 const std::string& SignalBase::interface_name() const {
     return m_priv->m_interface;
 }
 
 void SignalBase::set_interface( const std::string& i ) {
     m_priv->m_interface = i;
+    invalidate_signal_routes();
+    clear_header_template();
 }
 
 const std::string& SignalBase::name() const {
@@ -86,6 +97,8 @@ const std::string& SignalBase::name() const {
 
 void SignalBase::set_name( const std::string& n ) {
     m_priv->m_name = n;
+    invalidate_signal_routes();
+    clear_header_template();
 }
 
 const Path& SignalBase::path() const {
@@ -94,6 +107,8 @@ const Path& SignalBase::path() const {
 
 void SignalBase::set_path( const std::string& s ) {
     m_priv->m_path = s;
+    invalidate_signal_routes();
+    clear_header_template();
 }
 
 const std::string& SignalBase::destination() const {
@@ -102,6 +117,7 @@ const std::string& SignalBase::destination() const {
 
 void SignalBase::set_destination( const std::string& s ) {
     m_priv->m_destination = s;
+    clear_header_template();
 }
 
 bool SignalBase::handle_dbus_outgoing( std::shared_ptr<const Message> msg ) {
@@ -113,6 +129,31 @@ bool SignalBase::handle_dbus_outgoing( std::shared_ptr<const Message> msg ) {
     return true;
 }
 
+std::shared_ptr<SignalMessage> SignalBase::create_signal_message() {
+    std::scoped_lock lock( m_priv->m_headerTemplateLock );
+
+    if( !m_priv->m_headerTemplate ) {
+        std::shared_ptr<SignalMessage> msg = SignalMessage::create( m_priv->m_path, m_priv->m_interface, m_priv->m_name );
+
+        if( !m_priv->m_destination.empty() ) { msg->set_destination( m_priv->m_destination ); }
+
+        m_priv->m_headerTemplate = MessageHeaderTemplate::create( *msg );
+    }
+
+    return SignalMessage::create( m_priv->m_headerTemplate );
+}
+
+void SignalBase::clear_header_template() {
+    std::scoped_lock lock( m_priv->m_headerTemplateLock );
+    m_priv->m_headerTemplate.reset();
+}
+
+void SignalBase::invalidate_signal_routes() {
+    std::shared_ptr<Connection> conn = m_priv->m_connection.lock();
+
+    if( conn ) { conn->invalidate_signal_routes(); }
+}
+
 
 
 }
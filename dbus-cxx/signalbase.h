@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <memory>
 #include <string>
+#include <sigc++/sigc++.h>
 
 #ifndef DBUSCXX_SIGNALBASE_H
 #define DBUSCXX_SIGNALBASE_H
@@ -17,6 +18,8 @@
 namespace DBus {
 class Connection;
 class Message;
+class MessageHeaderTemplate;
+class SignalMessage;
 
 /**
  * @defgroup signals Signals
@@ -83,9 +86,30 @@ public:
 
     virtual void set_arg_name( size_t i, const std::string& name ) { }
 
+    /**
+     * Signal emitted when the name of an argument changes, so that the
+     * introspection of the interface that we are on changes too.
+     */
+    sigc::signal<void()> signal_introspection_changed();
+
 protected:
     bool handle_dbus_outgoing( std::shared_ptr<const Message> );
 
+    /**
+     * Create a new SignalMessage for this signal with the path, interface,
+     * name and destination(if set) already filled in.  The header fields are
+     * marshaled once and shared between all messages that this creates.
+     */
+    std::shared_ptr<SignalMessage> create_signal_message();
+
+private:
+    void clear_header_template();
+
+    /**
+     * Let our connection know that what we match on has changed.
+     */
+    void invalidate_signal_routes();
+
 private:
     class priv_data;
 
@@ -28,6 +28,11 @@ SignalMessage::SignalMessage( const std::string& path, const std::string& interf
     set_member( name );
 }
 
+SignalMessage::SignalMessage( std::shared_ptr<const MessageHeaderTemplate> header_template ) :
+    Message() {
+    set_header_template( header_template );
+}
+
 std::shared_ptr<SignalMessage> SignalMessage::create( ) {
     return std::shared_ptr<SignalMessage>( new SignalMessage() );
 }
@@ -40,6 +45,10 @@ std::shared_ptr<SignalMessage> SignalMessage::create( const std::string& path, c
     return std::shared_ptr<SignalMessage>( new SignalMessage( path, interface_name, name ) );
 }
 
+std::shared_ptr<SignalMessage> SignalMessage::create( std::shared_ptr<const MessageHeaderTemplate> header_template ) {
+    return std::shared_ptr<SignalMessage>( new SignalMessage( header_template ) );
+}
+
 bool SignalMessage::set_path( const std::string& p ) {
     set_header_field( MessageHeaderFields::Path, Variant( Path( p ) ) );
     return true;
@@ -37,6 +37,8 @@ protected:
 
     SignalMessage( const std::string& path, const std::string& interface_name, const std::string& name );
 
+    SignalMessage( std::shared_ptr<const MessageHeaderTemplate> header_template );
+
 public:
     static std::shared_ptr<SignalMessage> create( );
 
@@ -44,6 +46,14 @@ public:
 
     static std::shared_ptr<SignalMessage> create( const std::string& path, const std::string& interface_name, const std::string& name );
 
+    /**
+     * Create a new SignalMessage whose path, interface, member and destination
+     * come from the given pre-marshaled template.
+     *
+     * @param header_template The template to create the message from
+     */
+    static std::shared_ptr<SignalMessage> create( std::shared_ptr<const MessageHeaderTemplate> header_template );
+
     bool set_path( const std::string& p );
 
     Path path() const;
@@ -5,6 +5,7 @@
  *                                                                         *
  *   This file is part of the dbus-cxx library.                            *
  ***************************************************************************/
+#include <dbus-cxx/awaitable.h>
 #include <dbus-cxx/signalbase.h>
 #include <dbus-cxx/signalmessage.h>
 #include <dbus-cxx/utility.h>
@@ -84,6 +85,13 @@ public:
     static std::shared_ptr<SignalProxy> create( const SignalMatchRule& matchRule )
     { return std::shared_ptr<SignalProxy>( new SignalProxy( matchRule ) ); }
 
+    /**
+     * Returns an object that can be awaited from a C++20 coroutine to
+     * wait for the next emission of this signal.
+     */
+    SignalAwaitable<T_arg...> next_emission()
+    { return SignalAwaitable<T_arg...>( *this ); }
+
 protected:
     HandlerResult on_dbus_incoming( std::shared_ptr<const SignalMessage> msg ) {
         std::tuple<T_arg...> tup_args;
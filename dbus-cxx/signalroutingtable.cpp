@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "signalroutingtable.h"
+#include "signalmessage.h"
+#include "signalproxy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using DBus::priv::SignalRoutingTable;
+
+/*
+ * Which of the interface, member and path a proxy leaves empty; one bit each.
+ */
+#define WILDCARD_INTERFACE 0x01
+#define WILDCARD_MEMBER    0x02
+#define WILDCARD_PATH      0x04
+#define NUM_WILDCARDS      8
+
+typedef std::pair<uint32_t, std::shared_ptr<DBus::SignalProxyBase>> OrderedProxy;
+
+static std::string make_key( const std::string& interface_name, const std::string& member, const std::string& path ) {
+    std::string key;
+
+    key.reserve( interface_name.size() + member.size() + path.size() + 2 );
+    key += interface_name;
+    key += '\n';
+    key += member;
+    key += '\n';
+    key += path;
+
+    return key;
+}
+
+class SignalRoutingTable::priv_data {
+public:
+    priv_data() :
+        m_generation( 1 ),
+        m_builtGeneration( 0 ),
+        m_nextOrder( 0 ),
+        m_wildcardsUsed{}
+    {}
+
+    /* Bumped by invalidate() */
+    std::atomic<uint64_t> m_generation;
+    /* The generation when the table was last cleared */
+    uint64_t m_builtGeneration;
+    uint32_t m_nextOrder;
+    bool m_wildcardsUsed[ NUM_WILDCARDS ];
+    std::unordered_map<std::string, std::vector<OrderedProxy>> m_routes;
+};
+
+SignalRoutingTable::SignalRoutingTable() :
+    m_priv( std::make_unique<priv_data>() ) {
+}
+
+SignalRoutingTable::~SignalRoutingTable() {
+}
+
+void SignalRoutingTable::invalidate() {
+    m_priv->m_generation.fetch_add( 1, std::memory_order_acq_rel );
+}
+
+bool SignalRoutingTable::needs_rebuild() const {
+    return m_priv->m_builtGeneration != m_priv->m_generation.load( std::memory_order_acquire );
+}
+
+void SignalRoutingTable::clear() {
+    // Remember the generation first, so that any change made while the
+    // table is being filled in causes another rebuild
+    m_priv->m_builtGeneration = m_priv->m_generation.load( std::memory_order_acquire );
+    m_priv->m_nextOrder = 0;
+    m_priv->m_routes.clear();
+
+    for( int x = 0; x < NUM_WILDCARDS; x++ ) {
+        m_priv->m_wildcardsUsed[ x ] = false;
+    }
+}
+
+void SignalRoutingTable::add( std::shared_ptr<SignalProxyBase> proxy ) {
+    if( !proxy ) { return; }
+
+    int wildcards = 0;
+
+    if( proxy->interface_name().empty() ) { wildcards |= WILDCARD_INTERFACE; }
+
+    if( proxy->name().empty() ) { wildcards |= WILDCARD_MEMBER; }
+
+    if( proxy->path().empty() ) { wildcards |= WILDCARD_PATH; }
+
+    m_priv->m_wildcardsUsed[ wildcards ] = true;
+    m_priv->m_routes[ make_key( proxy->interface_name(), proxy->name(), proxy->path() ) ]
+        .push_back( std::make_pair( m_priv->m_nextOrder++, proxy ) );
+}
+
+std::vector<std::shared_ptr<DBus::SignalProxyBase>> SignalRoutingTable::lookup( std::shared_ptr<const SignalMessage> msg ) const {
+    std::vector<std::shared_ptr<SignalProxyBase>> retval;
+    std::vector<OrderedProxy> found;
+    std::string interface_name = msg->interface_name();
+    std::string member = msg->member();
+    std::string path = msg->path();
+    static const std::string empty;
+    int bucketsFound = 0;
+
+    for( int wildcards = 0; wildcards < NUM_WILDCARDS; wildcards++ ) {
+        if( !m_priv->m_wildcardsUsed[ wildcards ] ) { continue; }
+
+        std::unordered_map<std::string, std::vector<OrderedProxy>>::const_iterator it =
+            m_priv->m_routes.find( make_key( wildcards & WILDCARD_INTERFACE ? empty : interface_name,
+                    wildcards & WILDCARD_MEMBER ? empty : member,
+                    wildcards & WILDCARD_PATH ? empty : path ) );
+
+        if( it == m_priv->m_routes.end() ) { continue; }
+
+        found.insert( found.end(), it->second.begin(), it->second.end() );
+        bucketsFound++;
+    }
+
+    if( bucketsFound > 1 ) {
+        // Keep the order that the proxies were added in
+        std::sort( found.begin(), found.end(), []( const OrderedProxy& a, const OrderedProxy& b ) {
+            return a.first < b.first;
+        } );
+    }
+
+    retval.reserve( found.size() );
+
+    for( OrderedProxy& proxy : found ) {
+        retval.push_back( proxy.second );
+    }
+
+    return retval;
+}
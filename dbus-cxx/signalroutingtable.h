@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_SIGNALROUTINGTABLE_H
+#define DBUS_CXX_SIGNALROUTINGTABLE_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <memory>
+#include <vector>
+
+namespace DBus {
+
+class SignalMessage;
+class SignalProxyBase;
+
+namespace priv {
+
+/**
+ * An index of signal proxies by the interface, member and path that they
+ * match on, so that an incoming signal only has to be checked against the
+ * proxies that could possibly match it.  Proxies that leave one of these
+ * empty(and thus match anything) are found as well.
+ *
+ * The table does not track the proxies itself; instead, anything that
+ * changes which proxies exist or what they match on calls invalidate() on
+ * the table of its connection, and the owner of the table rebuilds it when
+ * needs_rebuild() is true.
+ */
+class SignalRoutingTable {
+public:
+    SignalRoutingTable();
+
+    ~SignalRoutingTable();
+
+    /**
+     * Mark this table as being out of date.  This may be called from any
+     * thread.
+     */
+    void invalidate();
+
+    /**
+     * Check to see if invalidate() has been called since this table was
+     * last cleared.
+     */
+    bool needs_rebuild() const;
+
+    /**
+     * Remove all proxies from this table, in preparation for adding them
+     * all again.
+     */
+    void clear();
+
+    /**
+     * Add a proxy to this table.
+     */
+    void add( std::shared_ptr<SignalProxyBase> proxy );
+
+    /**
+     * Find the proxies that could match the given signal, in the order that
+     * they were added to the table.  The proxies still need to check that
+     * they actually match.
+     */
+    std::vector<std::shared_ptr<SignalProxyBase>> lookup( std::shared_ptr<const SignalMessage> msg ) const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_SIGNALROUTINGTABLE_H */
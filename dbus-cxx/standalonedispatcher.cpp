@@ -136,6 +136,22 @@ void StandaloneDispatcher::dispatch_thread_main() {
     }
 
     while( m_priv->m_running ) {
+        int timeout = -1;
+        bool gotData = false;
+
+        // Connections that are set up to busy-poll get a chance to pick up
+        // a message before we go to sleep
+        for( std::shared_ptr<Connection> conn : m_priv->m_connections ) {
+            if( conn->busy_poll_window().count() > 0 && conn->busy_poll() ) {
+                gotData = true;
+            }
+        }
+
+        if( gotData ) {
+            dispatch_connections();
+            continue;
+        }
+
         fds.clear();
         fds.push_back( m_priv->process_fd[ 1 ] );
 
@@ -145,13 +161,25 @@ void StandaloneDispatcher::dispatch_thread_main() {
             }
 
             fds.push_back( conn->unix_fd() );
+
+            // Wake up in time to process the timeouts of any asynchronous calls
+            if( conn->timeout_fd() >= 0 ) {
+                fds.push_back( conn->timeout_fd() );
+                continue;
+            }
+
+            int conn_timeout = conn->next_timeout_milliseconds();
+
+            if( conn_timeout >= 0 && ( timeout < 0 || conn_timeout < timeout ) ) {
+                timeout = conn_timeout;
+            }
         }
 
         std::tuple<bool, int, std::vector<int>, std::chrono::milliseconds> fdResponse =
-            DBus::priv::wait_for_fd_activity( fds, -1 );
+            DBus::priv::wait_for_fd_activity( fds, timeout );
         std::vector<int> fdsToRead = std::get<2>( fdResponse );
 
-        if( fdsToRead[ 0 ] == m_priv->process_fd[ 1 ] ) {
+        if( !fdsToRead.empty() && fdsToRead[ 0 ] == m_priv->process_fd[ 1 ] ) {
             char discard;
             if( read( m_priv->process_fd[ 1 ], &discard, sizeof( char ) ) < 0 ){
                 SIMPLELOGGER_DEBUG( LOGGER_NAME, "Failure reading from dispatch thread process_fd: "
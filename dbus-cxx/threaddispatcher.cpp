@@ -1,6 +1,21 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
 #include "threaddispatcher.h"
+#include "dbus-cxx-private.h"
+#include "error.h"
 
 using DBus::ThreadDispatcher;
 
+static const char* LOGGER_NAME = "DBus.ThreadDispatcher";
+
 ThreadDispatcher::~ThreadDispatcher() {}
+
+void ThreadDispatcher::add_signals( const std::vector<std::shared_ptr<const SignalMessage>>& messages ) {
+    for( std::shared_ptr<const SignalMessage> msg : messages ) {
+        add_signal( msg );
+    }
+}
+
+void ThreadDispatcher::add_work( std::function<void()> work ) {
+    SIMPLELOGGER_ERROR( LOGGER_NAME, "This ThreadDispatcher does not implement add_work(), so it can't run work" );
+    throw DBus::ErrorNotSupported( "ThreadDispatcher::add_work() is not implemented" );
+}
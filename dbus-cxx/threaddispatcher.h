@@ -8,7 +8,9 @@
 #ifndef DBUSCXX_THREADDISPATCHER_H
 #define DBUSCXX_THREADDISPATCHER_H
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace DBus {
 
@@ -84,6 +86,35 @@ public:
      */
     virtual void add_signal( std::shared_ptr<const SignalMessage> message ) = 0;
 
+    /**
+     * Add several signal messages at once.  This is called instead of add_signal()
+     * when signals are delivered in a batch, so that the thread only needs to
+     * be woken up once.  Signals are only given to a ThreadDispatcher if one of
+     * its signal proxies could match them.
+     *
+     * The default implementation calls add_signal() for each message.
+     *
+     * @param messages The messages to be emitted, in order
+     */
+    virtual void add_signals( const std::vector<std::shared_ptr<const SignalMessage>>& messages );
+
+    /**
+     * Run the given function in the thread represented by this ThreadDispatcher.
+     * This is used to resume work(such as a coroutine waiting on a method call)
+     * in this thread.
+     *
+     * Like the other methods, this should push the function onto a queue and
+     * wakeup this thread, which then calls the function.  The function must
+     * not be called from the dispatcher thread.
+     *
+     * The default implementation has no thread to run the function in, so it
+     * logs an error and throws ErrorNotSupported; a coroutine that asked to be
+     * resumed in this thread gets the error from co_await instead.
+     *
+     * @param work The function to call
+     */
+    virtual void add_work( std::function<void()> work );
+
 };
 
 } /* namespace DBus */
@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "timerwheel.h"
+#include "dbus-cxx-private.h"
+
+#include <cstring>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+static const char* LOGGER_NAME = "DBus.TimerWheel";
+
+using DBus::priv::TimerWheel;
+
+#define LEVELS 4
+#define SLOT_BITS 6
+#define SLOTS ( 1 << SLOT_BITS )
+#define SLOT_MASK ( SLOTS - 1 )
+/* How many ticks the wheel covers before timers have to be re-cascaded */
+#define WHEEL_SPAN ( static_cast<uint64_t>( 1 ) << ( LEVELS * SLOT_BITS ) )
+#define NO_TICK UINT64_MAX
+
+class TimerWheel::Timer {
+public:
+    uint64_t expires;
+    uint32_t id;
+    int level;
+    int slot;
+    Timer* prev;
+    Timer* next;
+};
+
+/**
+ * Find the first bit that is set in the bits, starting at the given bit and
+ * wrapping around.
+ *
+ * @return How many bits after start the set bit is, or -1 if none are set
+ */
+static int first_set_from( uint64_t bits, int start ) {
+    if( bits == 0 ) { return -1; }
+
+    uint64_t rotated = ( bits >> start ) | ( start == 0 ? 0 : bits << ( SLOTS - start ) );
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_ctzll( rotated );
+#else
+    int bit = 0;
+
+    while( !( rotated & 1 ) ) {
+        rotated >>= 1;
+        bit++;
+    }
+
+    return bit;
+#endif
+}
+
+class TimerWheel::priv_data {
+public:
+    priv_data() :
+        m_base( std::chrono::steady_clock::now() ),
+        m_current( 0 ),
+        m_count( 0 ),
+        m_armedTick( NO_TICK ),
+        m_fd( -1 ) {
+        for( int level = 0; level < LEVELS; level++ ) {
+            m_occupied[ level ] = 0;
+
+            for( int slot = 0; slot < SLOTS; slot++ ) {
+                m_slots[ level ][ slot ] = nullptr;
+            }
+        }
+    }
+
+    uint64_t to_tick( std::chrono::steady_clock::time_point time, bool roundUp ) const {
+        if( time <= m_base ) { return 0; }
+
+        std::chrono::steady_clock::duration since = time - m_base;
+
+        if( roundUp ) {
+            return std::chrono::ceil<std::chrono::milliseconds>( since ).count();
+        }
+
+        return std::chrono::floor<std::chrono::milliseconds>( since ).count();
+    }
+
+    std::chrono::steady_clock::time_point from_tick( uint64_t tick ) const {
+        return m_base + std::chrono::milliseconds( tick );
+    }
+
+    /**
+     * Put a timer in the slot that it belongs in, relative to the current tick.
+     * The timer must not expire before the current tick.
+     */
+    void link( Timer* timer ) {
+        uint64_t delta = timer->expires - m_current;
+        uint64_t position = timer->expires;
+        int level = 0;
+
+        if( delta >= WHEEL_SPAN ) {
+            // Too far out; park it at the very end, and it will be put back
+            // in the right place when that slot is cascaded
+            position = m_current + WHEEL_SPAN - 1;
+            delta = WHEEL_SPAN - 1;
+        }
+
+        while( delta >= ( static_cast<uint64_t>( 1 ) << ( ( level + 1 ) * SLOT_BITS ) ) ) {
+            level++;
+        }
+
+        timer->level = level;
+        timer->slot = ( position >> ( level * SLOT_BITS ) ) & SLOT_MASK;
+        timer->prev = nullptr;
+        timer->next = m_slots[ level ][ timer->slot ];
+
+        if( timer->next ) { timer->next->prev = timer; }
+
+        m_slots[ level ][ timer->slot ] = timer;
+        m_occupied[ level ] |= static_cast<uint64_t>( 1 ) << timer->slot;
+    }
+
+    void unlink( Timer* timer ) {
+        if( timer->prev ) {
+            timer->prev->next = timer->next;
+        } else {
+            m_slots[ timer->level ][ timer->slot ] = timer->next;
+        }
+
+        if( timer->next ) { timer->next->prev = timer->prev; }
+
+        if( !m_slots[ timer->level ][ timer->slot ] ) {
+            m_occupied[ timer->level ] &= ~( static_cast<uint64_t>( 1 ) << timer->slot );
+        }
+    }
+
+    /**
+     * Take all of the timers out of the given slot.
+     */
+    Timer* take_slot( int level, int slot ) {
+        Timer* list = m_slots[ level ][ slot ];
+
+        m_slots[ level ][ slot ] = nullptr;
+        m_occupied[ level ] &= ~( static_cast<uint64_t>( 1 ) << slot );
+
+        return list;
+    }
+
+    uint64_t next_tick() const {
+        uint64_t next = NO_TICK;
+
+        if( m_count == 0 ) { return next; }
+
+        // Level 0 holds the timers for the next SLOTS ticks
+        int offset = first_set_from( m_occupied[ 0 ], ( m_current + 1 ) & SLOT_MASK );
+
+        if( offset >= 0 ) {
+            next = m_current + 1 + offset;
+        }
+
+        // The higher levels need to be cascaded down when we get to them
+        for( int level = 1; level < LEVELS; level++ ) {
+            uint64_t position = m_current >> ( level * SLOT_BITS );
+            offset = first_set_from( m_occupied[ level ], ( position + 1 ) & SLOT_MASK );
+
+            if( offset < 0 ) { continue; }
+
+            uint64_t cascade = ( position + 1 + offset ) << ( level * SLOT_BITS );
+
+            if( cascade < next ) { next = cascade; }
+        }
+
+        return next;
+    }
+
+    void arm( uint64_t tick ) {
+#ifdef __linux__
+        struct itimerspec spec;
+
+        if( m_fd < 0 || tick == m_armedTick ) { return; }
+
+        memset( &spec, 0, sizeof( spec ) );
+
+        if( tick != NO_TICK ) {
+            std::chrono::nanoseconds when = from_tick( tick ).time_since_epoch();
+            std::chrono::seconds secs = std::chrono::duration_cast<std::chrono::seconds>( when );
+
+            spec.it_value.tv_sec = secs.count();
+            spec.it_value.tv_nsec = ( when - secs ).count();
+
+            // All zeros would disarm the timer
+            if( spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0 ) {
+                spec.it_value.tv_nsec = 1;
+            }
+        }
+
+        if( timerfd_settime( m_fd, TFD_TIMER_ABSTIME, &spec, nullptr ) < 0 ) {
+            SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to set timerfd: " << strerror( errno ) );
+            return;
+        }
+
+        m_armedTick = tick;
+#endif
+    }
+
+    std::chrono::steady_clock::time_point m_base;
+    uint64_t m_current;
+    size_t m_count;
+    uint64_t m_armedTick;
+    int m_fd;
+    Timer* m_slots[ LEVELS ][ SLOTS ];
+    uint64_t m_occupied[ LEVELS ];
+};
+
+TimerWheel::TimerWheel() :
+    m_priv( std::make_unique<priv_data>() ) {
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC, so the deadlines can be used directly
+    m_priv->m_fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+
+    if( m_priv->m_fd < 0 ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unable to create timerfd: " << strerror( errno ) );
+    }
+#endif
+}
+
+TimerWheel::~TimerWheel() {
+    for( int level = 0; level < LEVELS; level++ ) {
+        for( int slot = 0; slot < SLOTS; slot++ ) {
+            Timer* timer = m_priv->m_slots[ level ][ slot ];
+
+            while( timer ) {
+                Timer* next = timer->next;
+                delete timer;
+                timer = next;
+            }
+        }
+    }
+
+#ifdef __linux__
+    if( m_priv->m_fd >= 0 ) {
+        close( m_priv->m_fd );
+    }
+#endif
+}
+
+TimerWheel::Timer* TimerWheel::schedule( std::chrono::steady_clock::time_point deadline, uint32_t id ) {
+    Timer* timer = new Timer();
+
+    timer->id = id;
+    timer->expires = m_priv->to_tick( deadline, true );
+
+    // The current tick has already been processed
+    if( timer->expires <= m_priv->m_current ) {
+        timer->expires = m_priv->m_current + 1;
+    }
+
+    m_priv->link( timer );
+    m_priv->m_count++;
+
+    if( m_priv->m_armedTick == NO_TICK || timer->expires < m_priv->m_armedTick ) {
+        m_priv->arm( m_priv->next_tick() );
+    }
+
+    return timer;
+}
+
+void TimerWheel::cancel( Timer* timer ) {
+    if( !timer ) { return; }
+
+    m_priv->unlink( timer );
+    m_priv->m_count--;
+    delete timer;
+
+    // The timerfd is left alone; waking up early is harmless
+}
+
+void TimerWheel::advance( std::chrono::steady_clock::time_point now, std::vector<uint32_t>* expired ) {
+    uint64_t target = m_priv->to_tick( now, false );
+
+#ifdef __linux__
+    if( m_priv->m_fd >= 0 ) {
+        uint64_t discard;
+
+        // Clear the readable state; if it isn't readable this does nothing
+        if( read( m_priv->m_fd, &discard, sizeof( discard ) ) < 0 && errno != EAGAIN ) {
+            SIMPLELOGGER_DEBUG( LOGGER_NAME, "Unable to read timerfd: " << strerror( errno ) );
+        }
+
+        m_priv->m_armedTick = NO_TICK;
+    }
+#endif
+
+    while( m_priv->m_current < target ) {
+        uint64_t tick = m_priv->m_current + 1;
+
+        if( m_priv->m_count == 0 ) {
+            m_priv->m_current = target;
+            break;
+        }
+
+        if( m_priv->m_occupied[ 0 ] == 0 ) {
+            // Nothing can expire before the next cascade, so skip to it
+            tick = ( tick + SLOT_MASK ) & ~static_cast<uint64_t>( SLOT_MASK );
+
+            if( tick > target ) {
+                m_priv->m_current = target;
+                break;
+            }
+        }
+
+        m_priv->m_current = tick;
+
+        // Move timers down from the higher levels whose slot has come up
+        for( int level = 1; level < LEVELS; level++ ) {
+            if( tick & ( ( static_cast<uint64_t>( 1 ) << ( level * SLOT_BITS ) ) - 1 ) ) { break; }
+
+            Timer* timer = m_priv->take_slot( level, ( tick >> ( level * SLOT_BITS ) ) & SLOT_MASK );
+
+            while( timer ) {
+                Timer* next = timer->next;
+                m_priv->link( timer );
+                timer = next;
+            }
+        }
+
+        Timer* timer = m_priv->take_slot( 0, tick & SLOT_MASK );
+
+        while( timer ) {
+            Timer* next = timer->next;
+            expired->push_back( timer->id );
+            m_priv->m_count--;
+            delete timer;
+            timer = next;
+        }
+    }
+
+    m_priv->arm( m_priv->next_tick() );
+}
+
+std::chrono::steady_clock::time_point TimerWheel::next_expiry() const {
+    uint64_t tick = m_priv->next_tick();
+
+    if( tick == NO_TICK ) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+
+    return m_priv->from_tick( tick );
+}
+
+int TimerWheel::fd() const {
+    return m_priv->m_fd;
+}
+
+bool TimerWheel::empty() const {
+    return m_priv->m_count == 0;
+}
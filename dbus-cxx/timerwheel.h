@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_TIMERWHEEL_H
+#define DBUS_CXX_TIMERWHEEL_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * A hierarchical timer wheel with a resolution of one millisecond.
+ *
+ * Each timer is identified by a 32-bit ID(the serial of the call that it
+ * is the timeout for).  Adding and cancelling a timer take constant time,
+ * and expiring timers takes constant time per timer.
+ *
+ * Where it is supported, the wheel also has a timerfd that becomes readable
+ * when the next timer is due, so that event loops can wait on it.
+ *
+ * This class is not thread-safe; the owner must lock around it.
+ */
+class TimerWheel {
+public:
+    class Timer;
+
+    TimerWheel();
+
+    ~TimerWheel();
+
+    /**
+     * Add a timer.
+     *
+     * @param deadline When the timer expires
+     * @param id The ID to report when the timer expires
+     * @return The timer, which is valid until it is cancelled or expires
+     */
+    Timer* schedule( std::chrono::steady_clock::time_point deadline, uint32_t id );
+
+    /**
+     * Remove a timer that has not expired yet.
+     */
+    void cancel( Timer* timer );
+
+    /**
+     * Expire all of the timers that are due at the given time.
+     *
+     * @param now The current time
+     * @param expired The IDs of the timers that expired are added to this
+     */
+    void advance( std::chrono::steady_clock::time_point now, std::vector<uint32_t>* expired );
+
+    /**
+     * The time that advance() next needs to be called at.  This may be
+     * earlier than the next timer actually expires.
+     *
+     * @return The time, or time_point::max() if there are no timers
+     */
+    std::chrono::steady_clock::time_point next_expiry() const;
+
+    /**
+     * A file descriptor that becomes readable at next_expiry(), or -1 if
+     * this is not supported on this platform.
+     */
+    int fd() const;
+
+    bool empty() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_TIMERWHEEL_H */
@@ -172,6 +172,28 @@ static int open_unix_socket( std::string socketAddress, bool is_abstract ) {
 
 Transport::~Transport() {}
 
+ssize_t Transport::writeMessages( const std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>>& messages,
+    std::vector<uint32_t>* unserializable ) {
+    ssize_t total = 0;
+
+    for( const std::pair<std::shared_ptr<const Message>, uint32_t>& msg : messages ) {
+        ssize_t written = writeMessage( msg.first, msg.second );
+
+        if( written < 0 ) {
+            return written;
+        }
+
+        // writeMessage() writes nothing at all for a message that can't be serialized
+        if( written == 0 ) {
+            unserializable->push_back( msg.second );
+        }
+
+        total += written;
+    }
+
+    return total;
+}
+
 std::shared_ptr<Transport> Transport::open_transport( std::string address ) {
     std::vector<ParsedTransport> transports = parseTransports( address );
     std::shared_ptr<Transport> retTransport;
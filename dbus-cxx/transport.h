@@ -11,6 +11,7 @@
 #include <memory>
 #include <stdint.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace DBus {
@@ -28,10 +29,26 @@ public:
      *
      * @param message The message to write
      * @param serial The serial of the message to write.
-     * @return The number of bytes written on success, an error code otherwise.
+     * @return The number of bytes written on success, 0 if the message could
+     * not be serialized, an error code otherwise.
      */
     virtual ssize_t writeMessage( std::shared_ptr<const Message> message, uint32_t serial ) = 0;
 
+    /**
+     * Writes several messages to the transport stream.  Transports that are
+     * able to should write as many of the messages as possible with a single
+     * system call; the default implementation calls writeMessage() for each
+     * message in turn.
+     *
+     * @param messages The messages to write, along with their serials, in the
+     * order that they are to be sent.
+     * @param unserializable Filled in with the serials of the messages that
+     * could not be serialized, and so were not sent.
+     * @return The number of bytes written on success, an error code otherwise.
+     */
+    virtual ssize_t writeMessages( const std::vector<std::pair<std::shared_ptr<const Message>, uint32_t>>& messages,
+        std::vector<uint32_t>* unserializable );
+
     /**
      * Read a message from the transport stream.  If there is no message
      * to be read, or there is not enough data to read a message yet,
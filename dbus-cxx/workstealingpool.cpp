@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include "workstealingpool.h"
+#include "dbus-cxx-private.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static const char* LOGGER_NAME = "DBus.WorkStealingPool";
+
+using DBus::priv::WorkStealingPool;
+
+typedef std::function<void()> Task;
+
+struct WorkerQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+};
+
+/**
+ * The tasks for one ordering key.  Only one of these tasks is in the pool
+ * at any time.
+ */
+struct Strand {
+    Strand() :
+        running( false )
+    {}
+
+    std::deque<Task> tasks;
+    bool running;
+};
+
+/*
+ * The state that the threads use.  This is shared with the threads so that
+ * a thread can outlive the pool if the pool is destroyed from one of its
+ * own tasks.
+ */
+struct PoolState {
+    PoolState( unsigned int numThreads ) :
+        pending( 0 ),
+        nextQueue( 0 ),
+        stop( false ) {
+        for( unsigned int x = 0; x < numThreads; x++ ) {
+            queues.push_back( std::make_unique<WorkerQueue>() );
+        }
+    }
+
+    void push( Task task );
+    bool pop( unsigned int index, Task* task );
+    void run_strand( const std::string& key, std::shared_ptr<Strand> strand );
+    void worker( unsigned int index );
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<size_t> pending;
+    std::atomic<unsigned int> nextQueue;
+    std::atomic<bool> stop;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::mutex strandLock;
+    std::unordered_map<std::string, std::shared_ptr<Strand>> strands;
+};
+
+/* The pool that the current thread belongs to, and its queue in that pool */
+static thread_local PoolState* t_pool = nullptr;
+static thread_local unsigned int t_queueIndex = 0;
+
+static void run_task( Task& task ) {
+    try {
+        task();
+    } catch( const std::exception& ex ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Exception from task: " << ex.what() );
+    } catch( ... ) {
+        SIMPLELOGGER_ERROR( LOGGER_NAME, "Unknown exception from task" );
+    }
+}
+
+void PoolState::push( Task task ) {
+    unsigned int index;
+
+    if( t_pool == this ) {
+        // Work submitted from one of our threads is likely to be related to
+        // what that thread is doing, so keep it local
+        index = t_queueIndex;
+    } else {
+        index = nextQueue.fetch_add( 1, std::memory_order_relaxed ) % queues.size();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( queues[ index ]->lock );
+        queues[ index ]->tasks.push_back( std::move( task ) );
+    }
+
+    {
+        // Taking the lock makes sure that a thread that is about to sleep
+        // sees the new task
+        std::unique_lock<std::mutex> lock( sleepLock );
+        pending.fetch_add( 1, std::memory_order_acq_rel );
+    }
+
+    wake.notify_one();
+}
+
+bool PoolState::pop( unsigned int index, Task* task ) {
+    // Our own tasks come off the back, which is the most recent(and the most
+    // likely to still be in the cache)
+    {
+        std::unique_lock<std::mutex> lock( queues[ index ]->lock );
+
+        if( !queues[ index ]->tasks.empty() ) {
+            *task = std::move( queues[ index ]->tasks.back() );
+            queues[ index ]->tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the front of the other queues, which is the oldest
+    for( size_t x = 1; x < queues.size(); x++ ) {
+        WorkerQueue* victim = queues[ ( index + x ) % queues.size() ].get();
+        std::unique_lock<std::mutex> lock( victim->lock );
+
+        if( !victim->tasks.empty() ) {
+            *task = std::move( victim->tasks.front() );
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PoolState::run_strand( const std::string& key, std::shared_ptr<Strand> strand ) {
+    Task task;
+
+    {
+        std::unique_lock<std::mutex> lock( strandLock );
+        task = std::move( strand->tasks.front() );
+        strand->tasks.pop_front();
+    }
+
+    run_task( task );
+
+    std::unique_lock<std::mutex> lock( strandLock );
+
+    if( strand->tasks.empty() ) {
+        strand->running = false;
+        strands.erase( key );
+        return;
+    }
+
+    // Give the next task back to the pool instead of running it here, so
+    // that a busy key can't keep this thread to itself
+    push( [this, key, strand]() {
+        run_strand( key, strand );
+    } );
+}
+
+void PoolState::worker( unsigned int index ) {
+    t_pool = this;
+    t_queueIndex = index;
+
+    while( !stop.load( std::memory_order_acquire ) ) {
+        Task task;
+
+        if( pop( index, &task ) ) {
+            pending.fetch_sub( 1, std::memory_order_acq_rel );
+            run_task( task );
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( sleepLock );
+        wake.wait( lock, [this]() {
+            return stop.load( std::memory_order_acquire ) ||
+                pending.load( std::memory_order_acquire ) > 0;
+        } );
+    }
+}
+
+class WorkStealingPool::priv_data {
+public:
+    priv_data() {}
+
+    std::shared_ptr<PoolState> m_state;
+    std::vector<std::thread> m_threads;
+};
+
+WorkStealingPool::WorkStealingPool( unsigned int numThreads ) :
+    m_priv( std::make_unique<priv_data>() ) {
+    if( numThreads == 0 ) {
+        numThreads = std::thread::hardware_concurrency();
+    }
+
+    if( numThreads == 0 ) {
+        numThreads = 1;
+    }
+
+    SIMPLELOGGER_DEBUG( LOGGER_NAME, "Starting " << numThreads << " threads" );
+
+    m_priv->m_state = std::make_shared<PoolState>( numThreads );
+
+    for( unsigned int x = 0; x < numThreads; x++ ) {
+        std::shared_ptr<PoolState> state = m_priv->m_state;
+        m_priv->m_threads.push_back( std::thread( [state, x]() {
+            state->worker( x );
+        } ) );
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock( m_priv->m_state->sleepLock );
+        m_priv->m_state->stop.store( true, std::memory_order_release );
+    }
+
+    m_priv->m_state->wake.notify_all();
+
+    for( std::thread& thr : m_priv->m_threads ) {
+        if( thr.get_id() == std::this_thread::get_id() ) {
+            // We are being destroyed from one of our own tasks; this thread
+            // will exit as soon as the task returns
+            thr.detach();
+        } else {
+            thr.join();
+        }
+    }
+}
+
+void WorkStealingPool::submit( std::function<void()> task ) {
+    m_priv->m_state->push( std::move( task ) );
+}
+
+void WorkStealingPool::submit( const std::string& orderingKey, std::function<void()> task ) {
+    PoolState* state = m_priv->m_state.get();
+    std::shared_ptr<Strand> strand;
+
+    {
+        std::unique_lock<std::mutex> lock( state->strandLock );
+        std::shared_ptr<Strand>& existing = state->strands[ orderingKey ];
+
+        if( !existing ) {
+            existing = std::make_shared<Strand>();
+        }
+
+        existing->tasks.push_back( std::move( task ) );
+
+        if( existing->running ) {
+            // This will run once the tasks ahead of it are done
+            return;
+        }
+
+        existing->running = true;
+        strand = existing;
+    }
+
+    state->push( [state, orderingKey, strand]() {
+        state->run_strand( orderingKey, strand );
+    } );
+}
+
+unsigned int WorkStealingPool::num_threads() const {
+    return m_priv->m_threads.size();
+}
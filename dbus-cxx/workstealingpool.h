@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#ifndef DBUS_CXX_WORKSTEALINGPOOL_H
+#define DBUS_CXX_WORKSTEALINGPOOL_H
+
+#include <dbus-cxx/dbus-cxx-config.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace DBus {
+
+namespace priv {
+
+/**
+ * A pool of threads that run tasks.  Each thread has its own queue of tasks;
+ * a thread that runs out of tasks steals them from the other threads.
+ *
+ * Tasks may be given an ordering key, in which case tasks with the same key
+ * are run one at a time in the order that they were submitted.  Tasks with
+ * different keys(or no key) may run at the same time.
+ *
+ * All methods may be called from any thread, including from a task.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * Create a pool and start its threads.
+     *
+     * @param numThreads How many threads to run; if 0, one per hardware thread
+     */
+    WorkStealingPool( unsigned int numThreads );
+
+    /**
+     * Stop all of the threads.  Tasks that have not started yet are dropped.
+     */
+    ~WorkStealingPool();
+
+    /**
+     * Run the given task on one of the threads.
+     */
+    void submit( std::function<void()> task );
+
+    /**
+     * Run the given task on one of the threads, after all of the tasks
+     * previously submitted with the same key have finished.
+     */
+    void submit( const std::string& orderingKey, std::function<void()> task );
+
+    unsigned int num_threads() const;
+
+private:
+    class priv_data;
+
+    DBUS_CXX_PROPAGATE_CONST( std::unique_ptr<priv_data> ) m_priv;
+};
+
+} /* namespace priv */
+
+} /* namespace DBus */
+
+#endif /* DBUS_CXX_WORKSTEALINGPOOL_H */
@@ -20,7 +20,10 @@
  ***************************************************************************/
 #include <dbus-cxx.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <thread>
 #include <chrono>
 
@@ -31,6 +34,9 @@ static std::thread::id mainThreadId;
 static std::thread::id rxThread;
 static bool rxSignal = false;
 static bool rxMessage = false;
+static std::atomic<int> concurrentCalls( 0 );
+static std::atomic<int> maxConcurrentCalls( 0 );
+static std::vector<int> callOrder;
 
 class AffinityThreadDispatcher : public DBus::ThreadDispatcher {
 public:
@@ -42,6 +48,7 @@ public:
     std::vector<std::shared_ptr<DBus::SignalProxyBase>> m_handlers;
     std::vector<std::shared_ptr<const DBus::SignalMessage>> m_signalMessages;
     std::vector<incoming_message> m_messages;
+    std::vector<std::function<void()>> m_work;
 
     void add_message( std::shared_ptr<DBus::Object> object, std::shared_ptr<const DBus::CallMessage> message ) {
         incoming_message incoming;
@@ -63,6 +70,10 @@ public:
         m_signalMessages.push_back( message );
     }
 
+    void add_work( std::function<void()> work ) {
+        m_work.push_back( work );
+    }
+
     // Call this from the main thread
     void processMessages() {
         for( std::shared_ptr<const DBus::SignalMessage> message : m_signalMessages ) {
@@ -74,6 +85,68 @@ public:
         for( incoming_message incoming : m_messages ) {
             incoming.object->handle_message( incoming.message );
         }
+
+        for( std::function<void()> work : m_work ) {
+            work();
+        }
+    }
+};
+
+/**
+ * Handles each call in a thread of its own, as soon as it comes in, but
+ * keeps any other work for the main thread.
+ */
+class SpawningThreadDispatcher : public DBus::ThreadDispatcher {
+public:
+    std::mutex m_workLock;
+    std::vector<std::function<void()>> m_work;
+    int m_numWork = 0;
+
+    void add_message( std::shared_ptr<DBus::Object> object, std::shared_ptr<const DBus::CallMessage> message ) {
+        std::thread( [object, message]() {
+            object->handle_message( message );
+        } ).detach();
+    }
+
+    void add_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> handler ) {}
+
+    bool remove_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> handler ) {
+        return true;
+    }
+
+    void add_signal( std::shared_ptr<const DBus::SignalMessage> message ) {}
+
+    void add_work( std::function<void()> work ) {
+        std::unique_lock<std::mutex> lock( m_workLock );
+        m_work.push_back( work );
+        m_numWork++;
+    }
+
+    // Call this from the main thread
+    void processWork() {
+        std::vector<std::function<void()>> work;
+
+        {
+            std::unique_lock<std::mutex> lock( m_workLock );
+            work.swap( m_work );
+        }
+
+        for( std::function<void()> func : work ) {
+            func();
+        }
+    }
+};
+
+/**
+ * A method that fails by throwing, rather than with an error reply.
+ */
+class ThrowingMethod : public DBus::MethodBase {
+public:
+    ThrowingMethod() : DBus::MethodBase( "throwingMethod" ) {}
+
+    DBus::HandlerResult handle_call_message( std::shared_ptr<DBus::Connection> connection,
+        std::shared_ptr<const DBus::CallMessage> message ) {
+        throw std::runtime_error( "throwingMethod failed" );
     }
 };
 
@@ -87,6 +160,57 @@ static void receiveMethodCall() {
     rxMessage = true;
 }
 
+static void slowMethodCall() {
+    int current = ++concurrentCalls;
+    int max = maxConcurrentCalls;
+
+    while( current > max && !maxConcurrentCalls.compare_exchange_weak( max, current ) ) {}
+
+    rxThread = std::this_thread::get_id();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    concurrentCalls--;
+}
+
+static void orderedMethodCall( int value ) {
+    callOrder.push_back( value );
+
+    // Give the rest of the calls time to all come in
+    if( callOrder.size() == 1 ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    }
+}
+
+/**
+ * Call a slow method on an object on the thread pool a few times at once,
+ * and return how many of the calls ran at the same time.
+ */
+static int call_on_thread_pool( DBus::ThreadPoolOrdering ordering ) {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::future<void>> results;
+
+    conn->set_thread_pool_size( 4 );
+    conn->set_thread_pool_ordering( ordering );
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::ThreadPool );
+
+    object->create_method<void()>( "test.for.dbuscxx", "slowMethod", sigc::ptr_fun( slowMethodCall ) );
+
+    std::shared_ptr<DBus::ObjectProxy> remote = conn->create_object_proxy( "dbuscxx.test", "/test" );
+    std::shared_ptr<DBus::MethodProxy<void()>> remoteMethod =
+            remote->create_method<void()>( "test.for.dbuscxx", "slowMethod" );
+
+    for( int x = 0; x < 4; x++ ) {
+        results.push_back( remoteMethod->call_async() );
+    }
+
+    for( std::future<void>& result : results ) {
+        result.get();
+    }
+
+    return maxConcurrentCalls;
+}
+
 bool affinity_signal_dispatcher_thread() {
     std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
 
@@ -140,6 +264,39 @@ bool affinity_signal_main_thread() {
     return false;
 }
 
+bool affinity_signal_main_thread_targeted() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<AffinityThreadDispatcher> afDisp = std::shared_ptr<AffinityThreadDispatcher>( new AffinityThreadDispatcher );
+    conn->add_thread_dispatcher( afDisp );
+
+    std::shared_ptr<DBus::SignalProxy<void()>> proxy = conn->create_free_signal_proxy<void()>(
+                DBus::MatchRuleBuilder::create()
+                .set_interface( "interface.name" )
+                .set_member( "myname" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::CurrentThread );
+
+    proxy->connect( sigc::ptr_fun( receiveSignal ) );
+
+    // Only the signal that the proxy in this thread can match should get here
+    std::shared_ptr<DBus::Signal<void()>> other = conn->create_free_signal<void()>( "/", "interface.name", "othername" );
+    std::shared_ptr<DBus::Signal<void()>> signal = conn->create_free_signal<void()>( "/", "interface.name", "myname" );
+
+    other->emit();
+    signal->emit();
+
+    std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+    TEST_EQUALS_RET_FAIL( afDisp->m_signalMessages.size(), 1 );
+    TEST_EQUALS_RET_FAIL( afDisp->m_signalMessages[ 0 ]->member(), "myname" );
+    afDisp->processMessages();
+
+    if( rxSignal && ( mainThreadId == rxThread ) ) {
+        return true;
+    }
+
+    return false;
+}
+
 bool affinity_message_dispatch_thread() {
     std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
     conn->request_name( "dbuscxx.test" );
@@ -232,6 +389,213 @@ bool affinity_message_change_thread() {
     return dispatcherThreadOk && mainThreadOk;
 }
 
+bool affinity_message_thread_pool() {
+    int maxConcurrent = call_on_thread_pool( DBus::ThreadPoolOrdering::None );
+
+    return maxConcurrent > 1 && mainThreadId != rxThread;
+}
+
+bool affinity_message_thread_pool_ordered() {
+    int maxConcurrent = call_on_thread_pool( DBus::ThreadPoolOrdering::PerObject );
+
+    return maxConcurrent == 1 && mainThreadId != rxThread;
+}
+
+bool affinity_message_concurrency_limit() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::future<void>> results;
+    int numRejected = 0;
+
+    conn->set_thread_pool_size( 4 );
+    conn->set_thread_pool_ordering( DBus::ThreadPoolOrdering::None );
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::ThreadPool );
+    std::shared_ptr<DBus::Method<void()>> method =
+        object->create_method<void()>( "test.for.dbuscxx", "slowMethod", sigc::ptr_fun( slowMethodCall ) );
+
+    // One call at a time, with room for one more to wait
+    method->set_concurrency_limit( 1, 1 );
+
+    std::shared_ptr<DBus::ObjectProxy> remote = conn->create_object_proxy( "dbuscxx.test", "/test" );
+    std::shared_ptr<DBus::MethodProxy<void()>> remoteMethod =
+            remote->create_method<void()>( "test.for.dbuscxx", "slowMethod" );
+
+    for( int x = 0; x < 4; x++ ) {
+        results.push_back( remoteMethod->call_async() );
+    }
+
+    for( std::future<void>& result : results ) {
+        try {
+            result.get();
+        } catch( DBus::ErrorLimitsExceeded& ) {
+            numRejected++;
+        }
+    }
+
+    TEST_ASSERT_RET_FAIL( maxConcurrentCalls == 1 );
+    TEST_ASSERT_RET_FAIL( numRejected == 2 );
+    TEST_ASSERT_RET_FAIL( method->rejected_calls() == 2 );
+
+    return true;
+}
+
+bool affinity_message_concurrency_parked() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::future<void>> results;
+
+    conn->set_thread_pool_size( 2 );
+    conn->set_thread_pool_ordering( DBus::ThreadPoolOrdering::None );
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::ThreadPool );
+    std::shared_ptr<DBus::Method<void()>> method =
+        object->create_method<void()>( "test.for.dbuscxx", "slowMethod", sigc::ptr_fun( slowMethodCall ) );
+    object->create_method<void()>( "test.for.dbuscxx", "fastMethod", []() {} );
+
+    // One call at a time, with room for the rest to wait
+    method->set_concurrency_limit( 1, 3 );
+
+    std::shared_ptr<DBus::ObjectProxy> remote = conn->create_object_proxy( "dbuscxx.test", "/test" );
+    std::shared_ptr<DBus::MethodProxy<void()>> slowMethod =
+            remote->create_method<void()>( "test.for.dbuscxx", "slowMethod" );
+    std::shared_ptr<DBus::MethodProxy<void()>> fastMethod =
+            remote->create_method<void()>( "test.for.dbuscxx", "fastMethod" );
+
+    for( int x = 0; x < 4; x++ ) {
+        results.push_back( slowMethod->call_async() );
+    }
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+
+    // The calls that are waiting for a turn don't take up the other thread
+    // in the pool, so this doesn't have to wait for the slow calls
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ( *fastMethod )();
+    std::chrono::steady_clock::duration fastTime = std::chrono::steady_clock::now() - start;
+
+    for( std::future<void>& result : results ) {
+        result.get();
+    }
+
+    TEST_ASSERT_RET_FAIL( fastTime < std::chrono::milliseconds( 150 ) );
+    TEST_ASSERT_RET_FAIL( maxConcurrentCalls == 1 );
+    TEST_ASSERT_RET_FAIL( method->rejected_calls() == 0 );
+
+    return true;
+}
+
+bool affinity_message_concurrency_throw() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Interface> iface = DBus::Interface::create( "test.for.dbuscxx" );
+    std::shared_ptr<ThrowingMethod> method = std::make_shared<ThrowingMethod>();
+    std::shared_ptr<DBus::CallMessage> message =
+        DBus::CallMessage::create( "dbuscxx.test", "/test", "test.for.dbuscxx", "throwingMethod" );
+    int numThrown = 0;
+
+    iface->add_method( method );
+    iface->set_concurrency_limit( 1 );
+    method->set_concurrency_limit( 1 );
+
+    // Each call still gets its turn, since the one before it gave its turns
+    // back even though it threw
+    for( int x = 0; x < 3; x++ ) {
+        try {
+            iface->handle_call_message( conn, message );
+        } catch( std::runtime_error& ) {
+            numThrown++;
+        }
+    }
+
+    TEST_EQUALS_RET_FAIL( numThrown, 3 );
+    TEST_EQUALS_RET_FAIL( method->rejected_calls(), 0 );
+
+    return true;
+}
+
+bool affinity_message_concurrency_resume_thread() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<SpawningThreadDispatcher> spawnDisp = std::make_shared<SpawningThreadDispatcher>();
+    std::vector<std::future<void>> results;
+
+    conn->add_thread_dispatcher( spawnDisp );
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::CurrentThread );
+    std::shared_ptr<DBus::Method<void()>> method =
+        object->create_method<void()>( "test.for.dbuscxx", "slowMethod", sigc::ptr_fun( slowMethodCall ) );
+
+    // One call at a time, with room for the rest to wait
+    method->set_concurrency_limit( 1, 3 );
+
+    std::shared_ptr<DBus::ObjectProxy> remote = conn->create_object_proxy( "dbuscxx.test", "/test" );
+    std::shared_ptr<DBus::MethodProxy<void()>> slowMethod =
+            remote->create_method<void()>( "test.for.dbuscxx", "slowMethod" );
+
+    for( int x = 0; x < 3; x++ ) {
+        results.push_back( slowMethod->call_async() );
+    }
+
+    // The calls that were parked must come back to this thread once they
+    // get their turn, not go to the thread pool
+    for( std::future<void>& result : results ) {
+        while( result.wait_for( std::chrono::milliseconds( 10 ) ) != std::future_status::ready ) {
+            spawnDisp->processWork();
+        }
+
+        result.get();
+    }
+
+    TEST_EQUALS_RET_FAIL( spawnDisp->m_numWork, 2 );
+    TEST_ASSERT_RET_FAIL( rxThread == mainThreadId );
+    TEST_ASSERT_RET_FAIL( maxConcurrentCalls == 1 );
+    TEST_ASSERT_RET_FAIL( method->rejected_calls() == 0 );
+
+    return true;
+}
+
+bool affinity_message_fair_scheduling() {
+    // The server needs its own dispatcher so that the clients can send while it is busy
+    std::shared_ptr<DBus::Dispatcher> serverDispatch = DBus::StandaloneDispatcher::create();
+    std::shared_ptr<DBus::Connection> conn = serverDispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> busyClient = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Connection> quietClient = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::future<void>> results;
+
+    conn->set_fair_call_scheduling( true );
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+
+    object->create_method<void(int)>( "test.for.dbuscxx", "orderedMethod", sigc::ptr_fun( orderedMethodCall ) );
+
+    std::shared_ptr<DBus::MethodProxy<void(int)>> busyMethod =
+        busyClient->create_object_proxy( "dbuscxx.test", "/test" )
+        ->create_method<void(int)>( "test.for.dbuscxx", "orderedMethod" );
+    std::shared_ptr<DBus::MethodProxy<void(int)>> quietMethod =
+        quietClient->create_object_proxy( "dbuscxx.test", "/test" )
+        ->create_method<void(int)>( "test.for.dbuscxx", "orderedMethod" );
+
+    for( int x = 0; x < 20; x++ ) {
+        results.push_back( busyMethod->call_async( x ) );
+    }
+
+    results.push_back( quietMethod->call_async( 100 ) );
+
+    for( std::future<void>& result : results ) {
+        result.get();
+    }
+
+    TEST_ASSERT_RET_FAIL( callOrder.size() == 21 );
+
+    // The one call from the quiet client shouldn't have to wait for all of
+    // the calls from the busy client
+    std::vector<int>::iterator quietCall = std::find( callOrder.begin(), callOrder.end(), 100 );
+    TEST_ASSERT_RET_FAIL( quietCall - callOrder.begin() < 10 );
+
+    return true;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = affinity_##name();\
         } \
@@ -253,9 +617,17 @@ int main( int argc, char** argv ) {
 
     ADD_TEST( signal_dispatcher_thread );
     ADD_TEST( signal_main_thread );
+    ADD_TEST( signal_main_thread_targeted );
     ADD_TEST( message_dispatch_thread );
     ADD_TEST( message_main_thread );
     ADD_TEST( message_change_thread );
+    ADD_TEST( message_thread_pool );
+    ADD_TEST( message_thread_pool_ordered );
+    ADD_TEST( message_concurrency_limit );
+    ADD_TEST( message_concurrency_parked );
+    ADD_TEST( message_concurrency_throw );
+    ADD_TEST( message_concurrency_resume_thread );
+    ADD_TEST( message_fair_scheduling );
 
     return !ret;
 }
@@ -177,6 +177,98 @@ bool call_message_insertion_extraction_operator_multiple( ) {
     return true;
 }
 
+bool call_message_header_template() {
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "method" );
+    std::shared_ptr<const DBus::MessageHeaderTemplate> header_template =
+        DBus::MessageHeaderTemplate::create( *msg );
+    std::shared_ptr<DBus::CallMessage> fromTemplate = DBus::CallMessage::create( header_template );
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+    std::string s_1( "Hello World" ), s_2;
+    int32_t i32_1 = -47892, i32_2 = 0;
+
+    msg << s_1 << i32_1;
+    fromTemplate << s_1 << i32_1;
+
+    TEST_EQUALS_RET_FAIL( fromTemplate->path(), msg->path() );
+    TEST_EQUALS_RET_FAIL( fromTemplate->interface_name(), msg->interface_name() );
+    TEST_EQUALS_RET_FAIL( fromTemplate->member(), msg->member() );
+    TEST_EQUALS_RET_FAIL( fromTemplate->destination(), msg->destination() );
+
+    TEST_ASSERT_RET_FAIL( msg->serialize_to_vector( &expected, 5 ) );
+    TEST_ASSERT_RET_FAIL( fromTemplate->serialize_to_vector( &actual, 5 ) );
+    TEST_EQUALS_RET_FAIL( expected, actual );
+
+    std::shared_ptr<DBus::Message> parsed = DBus::Message::create_from_data( actual.data(), actual.size() );
+    parsed >> s_2 >> i32_2;
+    TEST_EQUALS_RET_FAIL( s_1, s_2 );
+    TEST_EQUALS_RET_FAIL( i32_1, i32_2 );
+
+    // Overriding a field from the template must still serialize correctly
+    msg->set_destination( "org.freedesktop.Other" );
+    fromTemplate->set_destination( "org.freedesktop.Other" );
+    expected.clear();
+    actual.clear();
+
+    TEST_ASSERT_RET_FAIL( msg->serialize_to_vector( &expected, 6 ) );
+    TEST_ASSERT_RET_FAIL( fromTemplate->serialize_to_vector( &actual, 6 ) );
+    TEST_EQUALS_RET_FAIL( expected, actual );
+
+    return true;
+}
+
+bool call_message_header_field_view() {
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "method" );
+    std::shared_ptr<DBus::CallMessage> fromTemplate =
+        DBus::CallMessage::create( DBus::MessageHeaderTemplate::create( *msg ) );
+    std::vector<uint8_t> data;
+
+    TEST_EQUALS_RET_FAIL( msg->header_field_view( DBus::MessageHeaderFields::Interface ), "org.freedesktop.DBus" );
+    TEST_EQUALS_RET_FAIL( msg->header_field_view( DBus::MessageHeaderFields::Member ), "method" );
+    TEST_EQUALS_RET_FAIL( msg->header_field_view( DBus::MessageHeaderFields::Path ), "/org/freedesktop/DBus" );
+    TEST_EQUALS_RET_FAIL( msg->header_field_view( DBus::MessageHeaderFields::Sender ), "" );
+    TEST_EQUALS_RET_FAIL( fromTemplate->header_field_view( DBus::MessageHeaderFields::Member ), "method" );
+
+    msg << std::string( "Hello World" );
+    TEST_EQUALS_RET_FAIL( msg->header_field_view( DBus::MessageHeaderFields::Signature ), "s" );
+
+    TEST_ASSERT_RET_FAIL( msg->serialize_to_vector( &data, 5 ) );
+    std::shared_ptr<DBus::Message> parsed = DBus::Message::create_from_data( data.data(), data.size() );
+    TEST_EQUALS_RET_FAIL( parsed->header_field_view( DBus::MessageHeaderFields::Member ), "method" );
+
+    return true;
+}
+
+bool call_message_retarget_method_proxy() {
+    std::shared_ptr<DBus::ObjectProxy> object = DBus::ObjectProxy::create( "dbuscxx.first", "/first" );
+    std::shared_ptr<DBus::MethodProxy<void()>> method = object->create_method<void()>( "dbuscxx.iface", "method" );
+
+    std::shared_ptr<DBus::CallMessage> msg = method->create_call_message();
+    TEST_EQUALS_RET_FAIL( msg->path(), DBus::Path( "/first" ) );
+    TEST_EQUALS_RET_FAIL( msg->destination(), "dbuscxx.first" );
+
+    object->set_path( "/second" );
+    msg = method->create_call_message();
+    TEST_EQUALS_RET_FAIL( msg->path(), DBus::Path( "/second" ) );
+
+    object->set_destination( "dbuscxx.second" );
+    msg = method->create_call_message();
+    TEST_EQUALS_RET_FAIL( msg->destination(), "dbuscxx.second" );
+
+    // Moving the interface to another object picks up that object's path
+    std::shared_ptr<DBus::InterfaceProxy> iface = object->interface_by_name( "dbuscxx.iface" );
+    std::shared_ptr<DBus::ObjectProxy> other = DBus::ObjectProxy::create( "dbuscxx.third", "/third" );
+    object->remove_interface( iface );
+    other->add_interface( iface );
+    msg = method->create_call_message();
+    TEST_EQUALS_RET_FAIL( msg->path(), DBus::Path( "/third" ) );
+    TEST_EQUALS_RET_FAIL( msg->destination(), "dbuscxx.third" );
+
+    return true;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = call_message_insertion_extraction_operator_##name();\
         } \
@@ -204,6 +296,18 @@ int main( int argc, char** argv ) {
     ADD_TEST( array_double );
     ADD_TEST( multiple );
 
+    if( test_name == "header_template" ) {
+        ret = call_message_header_template();
+    }
+
+    if( test_name == "header_field_view" ) {
+        ret = call_message_header_field_view();
+    }
+
+    if( test_name == "retarget_method_proxy" ) {
+        ret = call_message_retarget_method_proxy();
+    }
+
     return !ret;
 }
 
@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "test_macros.h"
+
+/*
+ * Minimal coroutine type for the tests: starts immediately, and sets the
+ * value of a promise when it finishes.
+ */
+struct TestTask {
+    struct promise_type {
+        std::promise<bool> result;
+
+        TestTask get_return_object() {
+            return TestTask{ result.get_future() };
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_value( bool value ) { result.set_value( value ); }
+        void unhandled_exception() { result.set_exception( std::current_exception() ); }
+    };
+
+    std::future<bool> result;
+};
+
+/*
+ * A ThreadDispatcher that only runs work, in whichever thread calls run_one()
+ */
+class WorkThreadDispatcher : public DBus::ThreadDispatcher {
+public:
+    void add_message( std::shared_ptr<DBus::Object>, std::shared_ptr<const DBus::CallMessage> ) {}
+
+    void add_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> ) {}
+
+    bool remove_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> ) {
+        return false;
+    }
+
+    void add_signal( std::shared_ptr<const DBus::SignalMessage> ) {}
+
+    void add_work( std::function<void()> work ) {
+        std::unique_lock<std::mutex> lock( m_lock );
+        m_work.push_back( work );
+        m_cv.notify_one();
+    }
+
+    bool run_one( std::chrono::milliseconds timeout ) {
+        std::function<void()> work;
+
+        {
+            std::unique_lock<std::mutex> lock( m_lock );
+
+            if( !m_cv.wait_for( lock, timeout, [this]() { return !m_work.empty(); } ) ) {
+                return false;
+            }
+
+            work = m_work.front();
+            m_work.pop_front();
+        }
+
+        work();
+        return true;
+    }
+
+private:
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_work;
+};
+
+/*
+ * A ThreadDispatcher written before add_work() existed
+ */
+class OldThreadDispatcher : public DBus::ThreadDispatcher {
+public:
+    void add_message( std::shared_ptr<DBus::Object>, std::shared_ptr<const DBus::CallMessage> ) {}
+
+    void add_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> ) {}
+
+    bool remove_signal_proxy( std::shared_ptr<DBus::SignalProxyBase> ) {
+        return false;
+    }
+
+    void add_signal( std::shared_ptr<const DBus::SignalMessage> ) {}
+};
+
+static std::shared_ptr<DBus::Dispatcher> dispatch;
+static std::shared_ptr<DBus::Connection> conn;
+
+static int add( int a, int b ) {
+    return a + b;
+}
+
+static void setup_object() {
+    conn->request_name( "dbuscxx.test.coroutine", DBUSCXX_NAME_FLAG_REPLACE_EXISTING );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int( int, int )>( "foo.what", "add", sigc::ptr_fun( add ) );
+}
+
+TestTask add_many( std::shared_ptr<DBus::MethodProxy<int( int, int )>> method ) {
+    int total = 0;
+
+    for( int x = 0; x < 50; x++ ) {
+        total += co_await method->async( x, 1 );
+    }
+
+    co_return total == ( 49 * 50 / 2 ) + 50;
+}
+
+bool coroutine_method_call() {
+    setup_object();
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "dbuscxx.test.coroutine", "/test" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> method = proxy->create_method<int( int, int )>( "foo.what", "add" );
+
+    return add_many( method ).result.get();
+}
+
+TestTask call_unknown( std::shared_ptr<DBus::MethodProxy<void()>> method ) {
+    try {
+        co_await method->async();
+    } catch( DBus::ErrorUnknownMethod& ex ) {
+        co_return true;
+    }
+
+    co_return false;
+}
+
+bool coroutine_method_error() {
+    setup_object();
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "dbuscxx.test.coroutine", "/test" );
+    std::shared_ptr<DBus::MethodProxy<void()>> method = proxy->create_method<void()>( "foo.what", "nonexistant" );
+
+    return call_unknown( method ).result.get();
+}
+
+TestTask add_resumed_on( std::shared_ptr<DBus::MethodProxy<int( int, int )>> method,
+                         std::shared_ptr<DBus::ThreadDispatcher> disp,
+                         std::thread::id* resumed ) {
+    int value = co_await method->async( 2, 3 ).resume_on( disp );
+
+    *resumed = std::this_thread::get_id();
+
+    co_return value == 5;
+}
+
+bool coroutine_resume_on() {
+    setup_object();
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "dbuscxx.test.coroutine", "/test" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> method = proxy->create_method<int( int, int )>( "foo.what", "add" );
+    std::shared_ptr<WorkThreadDispatcher> disp = std::make_shared<WorkThreadDispatcher>();
+    std::thread::id resumed;
+
+    std::future<bool> result = add_resumed_on( method, disp, &resumed ).result;
+
+    // The coroutine must only continue once this thread runs it
+    TEST_ASSERT_RET_FAIL( disp->run_one( std::chrono::seconds( 5 ) ) );
+    TEST_ASSERT_RET_FAIL( result.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( resumed == std::this_thread::get_id() );
+
+    return result.get();
+}
+
+TestTask add_resumed_on_old( std::shared_ptr<DBus::MethodProxy<int( int, int )>> method,
+                             std::shared_ptr<DBus::ThreadDispatcher> disp ) {
+    try {
+        co_await method->async( 2, 3 ).resume_on( disp );
+    } catch( DBus::ErrorNotSupported& ex ) {
+        co_return true;
+    }
+
+    co_return false;
+}
+
+bool coroutine_resume_on_unsupported() {
+    setup_object();
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "dbuscxx.test.coroutine", "/test" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> method = proxy->create_method<int( int, int )>( "foo.what", "add" );
+    std::shared_ptr<OldThreadDispatcher> disp = std::make_shared<OldThreadDispatcher>();
+
+    std::future<bool> result = add_resumed_on_old( method, disp ).result;
+
+    TEST_ASSERT_RET_FAIL( result.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+
+    return result.get();
+}
+
+TestTask call_canceled( std::shared_ptr<DBus::MethodProxy<int( int, int )>> method,
+                        std::shared_ptr<DBus::PendingCall>* pending ) {
+    DBus::MethodCallAwaitable<int> call = method->async( 1, 2 );
+
+    *pending = call.pending_call();
+
+    try {
+        co_await call;
+    } catch( DBus::ErrorCallCanceled& ex ) {
+        co_return true;
+    }
+
+    co_return false;
+}
+
+bool coroutine_cancel() {
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    conn->request_name( "dbuscxx.test.coroutine", DBUSCXX_NAME_FLAG_REPLACE_EXISTING );
+
+    // Don't answer until the call has been canceled
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int( int, int )>( "foo.what", "add",
+        sigc::slot<int( int, int )>( [&started, released]( int a, int b ) {
+            started.set_value();
+            released.wait();
+            return a + b;
+        } ) );
+
+    std::shared_ptr<DBus::ObjectProxy> proxy = conn->create_object_proxy( "dbuscxx.test.coroutine", "/test" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> method = proxy->create_method<int( int, int )>( "foo.what", "add" );
+    std::shared_ptr<DBus::PendingCall> pending;
+
+    std::future<bool> result = call_canceled( method, &pending ).result;
+
+    TEST_ASSERT_RET_FAIL( started.get_future().wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+    TEST_ASSERT_RET_FAIL( result.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::timeout );
+
+    // The coroutine is resumed from here, and not left waiting forever
+    pending->cancel();
+    release.set_value();
+
+    TEST_ASSERT_RET_FAIL( result.wait_for( std::chrono::seconds( 5 ) ) == std::future_status::ready );
+
+    return result.get();
+}
+
+TestTask wait_for_signal( std::shared_ptr<DBus::SignalProxy<void( std::string, int )>> proxy ) {
+    std::tuple<std::string, int> values = co_await proxy->next_emission();
+
+    co_return std::get<0>( values ) == "TestSignal" && std::get<1>( values ) == 5;
+}
+
+bool coroutine_signal() {
+    std::shared_ptr<DBus::Signal<void( std::string, int )>> signal =
+        conn->create_free_signal<void( std::string, int )>( "/test/signal", "test.signal.type", "Coroutine" );
+    std::shared_ptr<DBus::SignalProxy<void( std::string, int )>> proxy =
+        conn->create_free_signal_proxy<void( std::string, int )>(
+            DBus::MatchRuleBuilder::create()
+            .set_path( "/test/signal" )
+            .set_interface( "test.signal.type" )
+            .set_member( "Coroutine" )
+            .as_signal_match(),
+            DBus::ThreadForCalling::DispatcherThread );
+
+    // Nothing emits on the proxy until we send the signal, so it is safe to
+    // start waiting from this thread; we are resumed in the dispatcher thread.
+    std::future<bool> result = wait_for_signal( proxy ).result;
+
+    signal->emit( "TestSignal", 5 );
+
+    if( result.wait_for( std::chrono::seconds( 5 ) ) != std::future_status::ready ) {
+        return false;
+    }
+
+    return result.get();
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = coroutine_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 1 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    DBus::set_logging_function( DBus::log_std_err );
+    DBus::set_log_level( SL_TRACE );
+
+    dispatch = DBus::StandaloneDispatcher::create();
+    conn = dispatch->create_connection( DBus::BusType::SESSION );
+
+    ADD_TEST( method_call );
+    ADD_TEST( method_error );
+    ADD_TEST( signal );
+    ADD_TEST( resume_on );
+    ADD_TEST( cancel );
+    ADD_TEST( resume_on_unsupported );
+
+    return !ret;
+}
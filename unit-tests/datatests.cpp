@@ -21,6 +21,7 @@
 //#include <dbus-cxx.h>
 #include <unistd.h>
 #include <iostream>
+#include <thread>
 
 #include "test_macros.h"
 #include "custom-type.h"
@@ -31,6 +32,7 @@ std::shared_ptr<DBus::Connection> conn;
 std::shared_ptr<DBus::ObjectProxy> proxy;
 std::shared_ptr<DBus::MethodProxy<int( int, int )>> int_method_proxy;
 std::shared_ptr<DBus::MethodProxy<void()>> void_method_proxy;
+std::shared_ptr<DBus::MethodProxy<int()>> void_calls_proxy;
 std::shared_ptr<DBus::MethodProxy<void( struct custom )>> void_custom_method_proxy;
 std::shared_ptr<DBus::MethodProxy<int( int, struct custom )>> int_custom_method_proxy2;
 std::shared_ptr<DBus::MethodProxy<std::map<DBus::Path, std::map<std::string, std::map<std::string, DBus::Variant>>>()>> complex_method_proxy;
@@ -43,6 +45,7 @@ std::shared_ptr<DBus::MethodProxy<DBus::MultipleReturn<int32_t>(int32_t)>> multi
 std::shared_ptr<DBus::Object> object;
 std::shared_ptr<DBus::Method<int( int, int )>> int_method;
 std::shared_ptr<DBus::Method<void()>> void_method;
+std::shared_ptr<DBus::Method<int()>> void_calls_method;
 std::shared_ptr<DBus::Method<void( struct custom )>> void_custom_method;
 std::shared_ptr<DBus::Method<int( int, struct custom )>> int_custom_method2;
 std::shared_ptr<DBus::Method<std::map<DBus::Path, std::map<std::string, std::map<std::string,DBus::Variant>>>()>> complex_method;
@@ -73,7 +76,15 @@ int add( int a, int b ) {
     return a + b;
 }
 
-void void_method_symbol() {}
+int void_method_calls = 0;
+
+void void_method_symbol() {
+    void_method_calls++;
+}
+
+int void_calls_symbol() {
+    return void_method_calls;
+}
 
 void void_custom_method_symbol( struct custom c ) {
 }
@@ -128,6 +139,7 @@ void client_setup() {
 
     int_method_proxy = proxy->create_method<int( int, int )>( "foo.what", "add" );
     void_method_proxy = proxy->create_method<void()>( "foo.what", "void" );
+    void_calls_proxy = proxy->create_method<int()>( "foo.what", "void_calls" );
     void_custom_method_proxy = proxy->create_method<void( struct custom )>( "foo.what", "void_custom" );
     int_custom_method_proxy2 = proxy->create_method<int( int, struct custom )>( "foo.what", "int_intcustom" );
     complex_method_proxy = proxy->create_method<std::map<DBus::Path, std::map<std::string, std::map<std::string, DBus::Variant>>>()>( "foo.what", "complex_custom" );
@@ -144,8 +156,14 @@ void server_setup() {
     if( ret != DBus::RequestNameResponse::PrimaryOwner ) { exit( 1 ); }
 
     object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+
+    std::shared_ptr<DBus::Object> fallback_object = DBus::Object::create( "/fallback" );
+    fallback_object->create_method<int( int, int )>( "foo.what", "add", sigc::ptr_fun( add ) );
+    conn->register_fallback_object( fallback_object );
+
     int_method = object->create_method<int( int, int )>( "foo.what", "add", sigc::ptr_fun( add ) );
     void_method = object->create_method<void()>( "foo.what", "void", sigc::ptr_fun( void_method_symbol ) );
+    void_calls_method = object->create_method<int()>( "foo.what", "void_calls", sigc::ptr_fun( void_calls_symbol ) );
     void_custom_method = object->create_method<void( struct custom )>( "foo.what", "void_custom", sigc::ptr_fun( void_custom_method_symbol ) );
     int_custom_method2 = object->create_method<int( int, struct custom )>( "foo.what", "int_intcustom", sigc::ptr_fun( int_intcustom_symbol ) );
     complex_method = object->create_method<std::map<DBus::Path, std::map<std::string, std::map<std::string, DBus::Variant>>>()>( "foo.what", "complex_custom", sigc::ptr_fun( complex_custom_symbol ) );
@@ -161,12 +179,223 @@ bool data_send_integers() {
     return TEST_EQUALS( val, 5 );
 }
 
+/**
+ * Make blocking calls from a few threads at once, returning how many of
+ * them failed.
+ */
+static int send_integers_from_threads() {
+    std::vector<std::thread> threads;
+    std::atomic<int> failures( 0 );
+
+    // The server only stays around for a second, so keep this short
+    for( int x = 0; x < 4; x++ ) {
+        threads.push_back( std::thread( [x, &failures]() {
+            for( int y = 0; y < 10; y++ ) {
+                if( ( *int_method_proxy )( x, y ) != x + y ) {
+                    failures++;
+                }
+            }
+        } ) );
+    }
+
+    for( std::thread& t : threads ) {
+        t.join();
+    }
+
+    return failures;
+}
+
+bool data_send_integers_threads() {
+    return TEST_EQUALS( send_integers_from_threads(), 0 );
+}
+
+bool data_send_integers_direct() {
+    conn->set_direct_blocking_send( true );
+
+    return TEST_EQUALS( send_integers_from_threads(), 0 );
+}
+
+bool data_send_integers_busy_poll() {
+    // Long enough that the replies come in while we are still spinning
+    conn->set_busy_poll_window( std::chrono::milliseconds( 20 ) );
+
+    for( int x = 0; x < 20; x++ ) {
+        TEST_EQUALS_RET_FAIL( ( *int_method_proxy )( x, 3 ), x + 3 );
+    }
+
+    DBus::BusyPollStats stats = conn->busy_poll_stats();
+
+    // Both the calls and the dispatcher spin, but at least some of them
+    // must have got a message for it
+    TEST_ASSERT_RET_FAIL( stats.hits > 0 );
+    return true;
+}
+
+bool data_busy_poll_timeout() {
+    std::promise<std::chrono::steady_clock::duration> waited;
+    std::future<std::chrono::steady_clock::duration> result = waited.get_future();
+
+    conn->set_busy_poll_window( std::chrono::milliseconds( 200 ) );
+
+    // A blocking call from the dispatcher thread to ourselves can't be
+    // answered until it returns, so this always times out
+    conn->run_on_dispatcher( [&waited]() {
+        std::shared_ptr<DBus::CallMessage> msg =
+            DBus::CallMessage::create( conn->unique_name(), "/nothing", "foo.what", "add" );
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        try {
+            conn->send_with_reply_blocking( msg, 300 );
+        } catch( const DBus::ErrorNoReply& ) {}
+
+        waited.set_value( std::chrono::steady_clock::now() - start );
+    } );
+
+    // The time spent spinning is part of the timeout, not on top of it
+    TEST_ASSERT_RET_FAIL( result.get() < std::chrono::milliseconds( 450 ) );
+    return true;
+}
+
+bool data_send_integers_async() {
+    std::vector<std::future<int>> futures;
+
+    for( int x = 0; x < 100; x++ ) {
+        futures.push_back( int_method_proxy->call_async( x, 3 ) );
+    }
+
+    for( int x = 0; x < 100; x++ ) {
+        TEST_EQUALS_RET_FAIL( futures[ x ].get(), x + 3 );
+    }
+
+    return true;
+}
+
+bool data_send_integers_batch() {
+    std::vector<std::shared_ptr<const DBus::CallMessage>> msgs;
+    std::vector<std::shared_ptr<DBus::PendingCall>> calls;
+
+    for( int x = 0; x < 50; x++ ) {
+        std::shared_ptr<DBus::CallMessage> msg = int_method_proxy->create_call_message();
+        *msg << x << 3;
+        msgs.push_back( msg );
+    }
+
+    // A failing call must not affect the rest of the batch
+    msgs.push_back( nonexistant_proxy->create_call_message() );
+
+    calls = conn->send_with_reply_batch( msgs );
+    TEST_EQUALS_RET_FAIL( calls.size(), msgs.size() );
+
+    for( int x = 0; x < 50; x++ ) {
+        int retval;
+        TEST_EQUALS_RET_FAIL( calls[ x ]->completed(), true );
+        calls[ x ]->return_message() >> retval;
+        TEST_EQUALS_RET_FAIL( retval, x + 3 );
+    }
+
+    try {
+        calls[ 50 ]->return_message();
+    } catch( const DBus::ErrorUnknownMethod& ex ) {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * A call that can never be serialized, since it doesn't say what type of
+ * message it is.
+ */
+class UnserializableCallMessage : public DBus::CallMessage {
+public:
+    UnserializableCallMessage() :
+        DBus::CallMessage( "dbuscxx.test", "/test", "foo.what", "add" ) {}
+
+    DBus::MessageType type() const {
+        return DBus::MessageType::INVALID;
+    }
+};
+
+bool data_send_batch_unserializable() {
+    std::vector<std::shared_ptr<const DBus::CallMessage>> msgs;
+    std::vector<std::shared_ptr<DBus::PendingCall>> calls;
+    std::shared_ptr<DBus::CallMessage> unserializable = std::make_shared<UnserializableCallMessage>();
+
+    for( int x = 0; x < 3; x++ ) {
+        std::shared_ptr<DBus::CallMessage> msg = int_method_proxy->create_call_message();
+        *msg << x << 3;
+        msgs.push_back( msg );
+    }
+
+    msgs.insert( msgs.begin() + 1, unserializable );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    calls = conn->send_with_reply_batch( msgs );
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    TEST_EQUALS_RET_FAIL( calls.size(), msgs.size() );
+
+    // The message that can't be sent fails right away instead of timing out
+    TEST_ASSERT_RET_FAIL( elapsed < std::chrono::seconds( 5 ) );
+
+    // The rest of the batch still goes out
+    int retval;
+    calls[ 0 ]->return_message() >> retval;
+    TEST_EQUALS_RET_FAIL( retval, 3 );
+    calls[ 2 ]->return_message() >> retval;
+    TEST_EQUALS_RET_FAIL( retval, 4 );
+    calls[ 3 ]->return_message() >> retval;
+    TEST_EQUALS_RET_FAIL( retval, 5 );
+
+    try {
+        calls[ 1 ]->return_message();
+    } catch( const DBus::ErrorFailed& ex ) {
+        return true;
+    }
+
+    return false;
+}
+
+bool data_fallback_object() {
+    std::shared_ptr<DBus::ObjectProxy> deviceProxy = conn->create_object_proxy( "dbuscxx.test", "/fallback/device/17" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> deviceAdd =
+        deviceProxy->create_method<int( int, int )>( "foo.what", "add" );
+
+    TEST_EQUALS_RET_FAIL( ( *deviceAdd )( 2, 3 ), 5 );
+
+    // A path that only starts with the same characters is not below the fallback
+    std::shared_ptr<DBus::ObjectProxy> otherProxy = conn->create_object_proxy( "dbuscxx.test", "/fallbackother" );
+    std::shared_ptr<DBus::MethodProxy<int( int, int )>> otherAdd =
+        otherProxy->create_method<int( int, int )>( "foo.what", "add" );
+
+    try {
+        ( *otherAdd )( 2, 3 );
+    } catch( const DBus::ErrorFailed& ex ) {
+        return true;
+    }
+
+    return false;
+}
+
 bool data_void_method() {
     ( *void_method_proxy )();
 
     return true;
 }
 
+bool data_void_method_no_reply() {
+    void_method_proxy->call_no_reply();
+    void_method_proxy->set_no_reply();
+    ( *void_method_proxy )();
+    ( *void_method_proxy )();
+
+    // Calls are handled in order, so all of the one-way calls must have
+    // been handled by the time that this returns.
+    int calls = ( *void_calls_proxy )();
+
+    return TEST_EQUALS( calls, 3 );
+}
+
 bool data_void_custom() {
     struct custom c;
     c.first = 5;
@@ -283,6 +512,75 @@ bool data_nonexistant_method() {
     return false;
 }
 
+bool data_nonexistant_method_async() {
+    std::future<void> future = nonexistant_proxy->call_async();
+
+    try {
+        future.get();
+    } catch( const DBus::ErrorUnknownMethod& ex ) {
+        return true;
+    }
+
+    return false;
+}
+
+bool data_cancel_async_call() {
+    // Nothing ever reads from this connection, so the call is never answered
+    std::shared_ptr<DBus::Connection> silent = DBus::Connection::create( DBus::BusType::SESSION );
+    TEST_ASSERT_RET_FAIL( silent->bus_register() );
+
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( silent->unique_name(), "/test", "foo.what", "add" );
+    std::shared_ptr<DBus::PendingCall> pending = conn->send_with_reply_async( msg, 10000 );
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::thread waiter( [pending]() {
+        pending->block();
+    } );
+
+    usleep( 100000 );
+    pending->cancel();
+    waiter.join();
+
+    TEST_ASSERT_RET_FAIL( std::chrono::steady_clock::now() - start < std::chrono::seconds( 5 ) );
+    TEST_ASSERT_RET_FAIL( pending->is_canceled() );
+    TEST_ASSERT_RET_FAIL( !pending->completed() );
+
+    // The timeout went away along with the call
+    TEST_ASSERT_RET_FAIL( conn->next_timeout_milliseconds() == -1 );
+
+    return true;
+}
+
+bool data_default_timeout_async() {
+    // Nothing ever reads from this connection, so the call is never answered
+    std::shared_ptr<DBus::Connection> silent = DBus::Connection::create( DBus::BusType::SESSION );
+    TEST_ASSERT_RET_FAIL( silent->bus_register() );
+
+    conn->set_default_timeout( std::chrono::milliseconds( 300 ) );
+
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( silent->unique_name(), "/test", "foo.what", "add" );
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::shared_ptr<DBus::PendingCall> pending = conn->send_with_reply_async( msg );
+
+    pending->block();
+
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+    TEST_ASSERT_RET_FAIL( elapsed >= std::chrono::milliseconds( 300 ) );
+    TEST_ASSERT_RET_FAIL( elapsed < std::chrono::milliseconds( 1000 ) );
+    TEST_ASSERT_RET_FAIL( pending->is_timeout() );
+
+    try {
+        pending->return_message();
+    } catch( const DBus::ErrorNoReply& ) {
+        return true;
+    }
+
+    return false;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = data_##name();\
         } \
@@ -306,7 +604,16 @@ int main( int argc, char** argv ) {
     if( is_client ) {
         client_setup();
         ADD_TEST( send_integers );
+        ADD_TEST( send_integers_threads );
+        ADD_TEST( send_integers_direct );
+        ADD_TEST( send_integers_busy_poll );
+        ADD_TEST( busy_poll_timeout );
+        ADD_TEST( send_integers_async );
+        ADD_TEST( send_integers_batch );
+        ADD_TEST( send_batch_unserializable );
+        ADD_TEST( fallback_object );
         ADD_TEST( void_method );
+        ADD_TEST( void_method_no_reply );
         ADD_TEST( void_custom );
         ADD_TEST( send_intcustom );
         ADD_TEST( send_complex );
@@ -317,12 +624,17 @@ int main( int argc, char** argv ) {
         ADD_TEST( variant_map );
         ADD_TEST( variant_tuple );
         ADD_TEST( nonexistant_method );
+        ADD_TEST( nonexistant_method_async );
+        ADD_TEST( cancel_async_call );
+        ADD_TEST( default_timeout_async );
         ADD_TEST(send_multiplereturn);
         ADD_TEST(send_multiplereturn2);
     } else {
         server_setup();
         ret = true;
-        sleep( 1 );
+
+        // Stay around until the client is done and the wrapper kills us
+        pause();
     }
 
 
@@ -16,7 +16,8 @@ sleep .1
 # get the exit code 
 EXIT_CODE=$?
 
-# wait for server to be done
+# the server runs until it is told to stop
+kill $SERVER_PID
 wait $SERVER_PID
 
 kill $DBUS_SESSION_BUS_PID
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx.h>
+#include <dbus-cxx/incomingqueue.h>
+#include <string>
+
+#include "test_macros.h"
+
+using DBus::priv::IncomingQueue;
+
+static std::shared_ptr<DBus::Message> new_signal() {
+    return DBus::SignalMessage::create( "/test", "test.signal.type", "ExampleMember" );
+}
+
+static std::shared_ptr<DBus::Message> new_call() {
+    return DBus::CallMessage::create( "dbuscxx.test", "/test", "test.for.dbuscxx", "method" );
+}
+
+bool incomingqueue_reject_calls_drops_signals() {
+    IncomingQueue queue;
+
+    queue.set_limits( 4, 0 );
+    queue.set_policy( DBus::IncomingOverflowPolicy::RejectCalls );
+
+    for( int x = 0; x < 4; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue.push( new_signal() ) == IncomingQueue::PushResult::Queued );
+    }
+
+    // A burst of signals must not grow the queue past its limit
+    for( int x = 0; x < 100; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue.push( new_signal() ) == IncomingQueue::PushResult::Dropped );
+    }
+
+    TEST_ASSERT_RET_FAIL( queue.push( new_call() ) == IncomingQueue::PushResult::Rejected );
+
+    TEST_EQUALS_RET_FAIL( queue.size(), 4 );
+    TEST_EQUALS_RET_FAIL( queue.peak_size(), 4 );
+    TEST_EQUALS_RET_FAIL( queue.dropped_signals(), 100 );
+    TEST_EQUALS_RET_FAIL( queue.rejected_calls(), 1 );
+
+    return true;
+}
+
+bool incomingqueue_drop_oldest_rejects_calls() {
+    IncomingQueue queue;
+
+    queue.set_limits( 4, 0 );
+    queue.set_policy( DBus::IncomingOverflowPolicy::DropOldestSignals );
+
+    TEST_ASSERT_RET_FAIL( queue.push( new_signal() ) == IncomingQueue::PushResult::Queued );
+
+    for( int x = 0; x < 3; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue.push( new_call() ) == IncomingQueue::PushResult::Queued );
+    }
+
+    // The signal makes room for one more call
+    TEST_ASSERT_RET_FAIL( queue.push( new_call() ) == IncomingQueue::PushResult::Queued );
+    TEST_EQUALS_RET_FAIL( queue.dropped_signals(), 1 );
+
+    // Nothing is left to drop, so the queue stays at its limit
+    for( int x = 0; x < 100; x++ ) {
+        TEST_ASSERT_RET_FAIL( queue.push( new_call() ) == IncomingQueue::PushResult::Rejected );
+    }
+
+    TEST_ASSERT_RET_FAIL( queue.push( new_signal() ) == IncomingQueue::PushResult::Dropped );
+
+    TEST_EQUALS_RET_FAIL( queue.size(), 4 );
+    TEST_EQUALS_RET_FAIL( queue.peak_size(), 4 );
+    TEST_EQUALS_RET_FAIL( queue.dropped_signals(), 2 );
+    TEST_EQUALS_RET_FAIL( queue.rejected_calls(), 100 );
+
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = incomingqueue_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( reject_calls_drops_signals );
+    ADD_TEST( drop_oldest_rejects_calls );
+
+    return !ret;
+}
@@ -32,9 +32,12 @@ std::shared_ptr<DBus::ObjectProxy> proxy;
 std::shared_ptr<DBus::MethodProxy<int( int, int )>> int_method_proxy;
 std::shared_ptr<DBus::ObjectProxy> introspectionProxy;
 std::shared_ptr<DBus::MethodProxy<std::string()>> introspection_method_proxy;
+std::shared_ptr<DBus::MethodProxy<void()>> add_later_method_proxy;
+std::shared_ptr<DBus::MethodProxy<void()>> rename_args_method_proxy;
 
 std::shared_ptr<DBus::Object> object;
 std::shared_ptr<DBus::Method<int( int, int )>> int_method;
+std::shared_ptr<DBus::Signal<void(std::string)>> tim_signal;
 
 struct XMLParseResults {
     XMLParseResults() :
@@ -72,6 +75,15 @@ int add( int, int ) {
 
 void doublefun( double ) {}
 
+void add_later() {
+    object->create_method<int( int, int )>( "foo.what", "later", sigc::ptr_fun( add ) );
+}
+
+void rename_args() {
+    int_method->set_arg_name( 1, "renamed" );
+    tim_signal->set_arg_name( 1, "renamedsig" );
+}
+
 DBus::MultipleReturn<int32_t,std::string> multi_return(){
     return DBus::MultipleReturn<int32_t,std::string>( 5, "hi" );
 }
@@ -254,6 +266,33 @@ bool introspect_multiple_return() {
     return parseResults.num_multi_return == 2;
 }
 
+bool introspect_method_added_after_introspect() {
+    std::string before = ( *introspection_method_proxy )();
+
+    if( before.find( "\"later\"" ) != std::string::npos ) { return false; }
+
+    ( *add_later_method_proxy )();
+
+    std::string after = ( *introspection_method_proxy )();
+
+    return after.find( "<method name=\"later\">" ) != std::string::npos;
+}
+
+bool introspect_arg_renamed_after_introspect() {
+    std::string before = ( *introspection_method_proxy )();
+
+    if( before.find( "\"renamed" ) != std::string::npos ) { return false; }
+
+    ( *rename_args_method_proxy )();
+
+    std::string after = ( *introspection_method_proxy )();
+
+    TEST_ASSERT_RET_FAIL( after.find( "name=\"renamed\"" ) != std::string::npos );
+    TEST_ASSERT_RET_FAIL( after.find( "name=\"renamedsig\"" ) != std::string::npos );
+
+    return true;
+}
+
 void client_setup() {
     proxy = conn->create_object_proxy( "dbuscxx.test", "/test" );
 
@@ -261,6 +300,8 @@ void client_setup() {
 
     introspectionProxy = conn->create_object_proxy( "dbuscxx.test", "/test" );
     introspection_method_proxy = proxy->create_method<std::string()>( "org.freedesktop.DBus.Introspectable", "Introspect" );
+    add_later_method_proxy = proxy->create_method<void()>( "foo.what", "addLater" );
+    rename_args_method_proxy = proxy->create_method<void()>( "foo.what", "renameArgs" );
 }
 
 void server_setup() {
@@ -272,10 +313,12 @@ void server_setup() {
     int_method = object->create_method<int( int, int )>( "foo.what", "add", sigc::ptr_fun( add ) );
     int_method->set_arg_name( 1, "first" );
     int_method->set_arg_name( 2, "second" );
+    object->create_method<void()>( "foo.what", "addLater", sigc::ptr_fun( add_later ) );
+    object->create_method<void()>( "foo.what", "renameArgs", sigc::ptr_fun( rename_args ) );
 
     object->create_method<void( double )>( "what.bob", "setBar", sigc::ptr_fun( doublefun ) );
 
-    object->create_signal<void(std::string)>( "sig.interface", "tim" );
+    tim_signal = object->create_signal<void(std::string)>( "sig.interface", "tim" );
 
     object->create_method<DBus::MultipleReturn<int32_t,std::string>()>( "foo.multi", "multi", sigc::ptr_fun( multi_return ) );
 }
@@ -309,6 +352,8 @@ int main( int argc, char** argv ) {
         ADD_TEST( second_argname_correct );
         ADD_TEST( signal_found );
         ADD_TEST( multiple_return );
+        ADD_TEST( method_added_after_introspect );
+        ADD_TEST( arg_renamed_after_introspect );
     } else {
         server_setup();
         ret = true;
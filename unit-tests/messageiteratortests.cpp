@@ -401,6 +401,28 @@ bool call_message_append_extract_iterator_map_string_string() {
     return true;
 }
 
+bool call_message_append_extract_iterator_empty_map_unaligned() {
+    std::map<std::string, DBus::Variant> themap;
+    std::vector<std::string> thelist = { "invalidated" };
+    std::string first;
+    std::map<std::string, DBus::Variant> extracted_map;
+    std::vector<std::string> extracted_list;
+
+    // The map length lands on a 4 byte boundary, so there is padding before
+    // where the (non-existent) first dict entry would be
+    std::shared_ptr<DBus::CallMessage> msg = DBus::CallMessage::create( "/org/freedesktop/DBus", "method" );
+    msg << std::string( "dbuscxx.interface" ) << themap << thelist;
+
+    msg >> first >> extracted_map >> extracted_list;
+
+    TEST_EQUALS_RET_FAIL( first, "dbuscxx.interface" );
+    TEST_EQUALS_RET_FAIL( extracted_map.size(), 0 );
+    TEST_EQUALS_RET_FAIL( extracted_list.size(), 1 );
+    TEST_EQUALS_RET_FAIL( extracted_list[ 0 ], "invalidated" );
+
+    return true;
+}
+
 bool call_message_append_extract_iterator_map_string_string_many() {
     std::map<std::string, std::string> themap;
     std::map<std::string, std::string> extracted_map;
@@ -1194,6 +1216,7 @@ int main( int argc, char** argv ) {
     ADD_TEST( map_string_variant_many );
     ADD_TEST( map_string_string );
     ADD_TEST( map_string_string_many );
+    ADD_TEST( empty_map_unaligned );
     ADD_TEST( correct_variant_signature );
     ADD_TEST( array_array_bytes );
     ADD_TEST( array_array_int );
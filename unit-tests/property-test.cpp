@@ -22,6 +22,8 @@
 #include <iostream>
 #include <string>
 #include "test_macros.h"
+#include <atomic>
+#include <functional>
 #include <thread>
 
 static std::shared_ptr<DBus::Dispatcher> dispatch;
@@ -128,6 +130,187 @@ bool property_updated_from_signal(){
     return times == 1 && value == 7878;
 }
 
+bool property_prefetch(){
+    std::shared_ptr<DBus::InterfaceProxy> iface = proxy->interface_by_name( "dbuscxx.interface" );
+    std::shared_ptr<DBus::PropertyProxyBase> readonly = iface->property( "readonly" );
+    int readonlyUpdates = 0;
+
+    readonly->signal_generic_property_changed().connect( [&readonlyUpdates]( DBus::Variant ){
+        readonlyUpdates++;
+    });
+
+    iface->set_property_prefetch( true );
+
+    // Reading one property fills in all of them
+    bool intOk = iface->property( "intproperty" )->variant_value().to_int32() == 9834;
+
+    return intOk &&
+        readonlyUpdates == 1 &&
+        readonly->variant_value().to_int32() == 44 &&
+        readonlyUpdates == 1;
+}
+
+static std::map<std::string,DBus::Variant> get_all_raw(){
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( "dbuscxx.test", "/test", DBUS_CXX_PROPERTIES_INTERFACE, "GetAll" );
+    msg << std::string( "dbuscxx.interface" );
+
+    std::shared_ptr<DBus::ReturnMessage> ret = conn->send_with_reply_blocking( msg );
+    std::map<std::string,DBus::Variant> values;
+    ret >> values;
+
+    return values;
+}
+
+bool property_get_all_after_set(){
+    std::shared_ptr<DBus::InterfaceProxy> iface = proxy->interface_by_name( "dbuscxx.interface" );
+
+    // The second GetAll is answered from the cache, the third can't be
+    bool firstOk = get_all_raw()[ "intproperty" ].to_int32() == 9834;
+    bool secondOk = get_all_raw()[ "intproperty" ].to_int32() == 9834;
+
+    iface->property( "intproperty" )->set_value( 1234 );
+
+    std::map<std::string,DBus::Variant> values = get_all_raw();
+
+    return firstOk && secondOk &&
+        values.size() == 2 &&
+        values[ "intproperty" ].to_int32() == 1234 &&
+        values[ "readonly" ].to_int32() == 44;
+}
+
+/*
+ * Wait up to a second for the condition to become true.
+ */
+static bool wait_for( std::function<bool()> condition ){
+    for( int x = 0; x < 100 && !condition(); x++ ){
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+
+    return condition();
+}
+
+bool property_refresh_names(){
+    std::shared_ptr<DBus::InterfaceProxy> iface = proxy->interface_by_name( "dbuscxx.interface" );
+    int intUpdates = 0;
+    int readonlyUpdates = 0;
+
+    iface->property( "intproperty" )->signal_generic_property_changed().connect( [&intUpdates]( DBus::Variant v ){
+        if( v.to_int32() == 9834 ) { intUpdates++; }
+    });
+    iface->property( "readonly" )->signal_generic_property_changed().connect( [&readonlyUpdates]( DBus::Variant v ){
+        if( v.to_int32() == 44 ) { readonlyUpdates++; }
+    });
+
+    // Names that we don't have a proxy for are left out
+    iface->refresh_properties( { "intproperty", "readonly", "ThisDoesntExist" } );
+
+    return intUpdates == 1 && readonlyUpdates == 1;
+}
+
+bool property_refresh_async(){
+    std::shared_ptr<DBus::InterfaceProxy> iface = proxy->interface_by_name( "dbuscxx.interface" );
+    std::atomic<int> intUpdates( 0 );
+    std::atomic<int> readonlyUpdates( 0 );
+
+    iface->property( "intproperty" )->signal_generic_property_changed().connect( [&intUpdates]( DBus::Variant v ){
+        if( v.to_int32() == 9834 ) { intUpdates++; }
+    });
+    iface->property( "readonly" )->signal_generic_property_changed().connect( [&readonlyUpdates]( DBus::Variant v ){
+        if( v.to_int32() == 44 ) { readonlyUpdates++; }
+    });
+
+    std::shared_ptr<DBus::PendingCall> pending = iface->refresh_properties_async();
+    TEST_ASSERT_RET_FAIL( pending );
+
+    pending->block();
+    TEST_ASSERT_RET_FAIL( pending->return_message() );
+
+    // The properties are filled in from the dispatching thread
+    return wait_for( [&intUpdates, &readonlyUpdates](){
+        return intUpdates == 1 && readonlyUpdates == 1;
+    } );
+}
+
+bool property_invalidated_refetch(){
+    std::shared_ptr<DBus::PropertyProxy<int32_t>> invalidating =
+        proxy->create_property<int32_t>( "dbuscxx.invalidating", "invalidating" );
+    std::shared_ptr<DBus::InterfaceProxy> iface = proxy->interface_by_name( "dbuscxx.invalidating" );
+    std::atomic<int> lastValue( 0 );
+
+    iface->set_property_prefetch( true );
+    iface->refresh_properties();
+    TEST_ASSERT_RET_FAIL( invalidating->value() == 1 );
+
+    invalidating->signal_generic_property_changed().connect( [&lastValue]( DBus::Variant v ){
+        lastValue = v.to_int32();
+    });
+
+    // Set it behind the proxy's back; the server only says that it has
+    // changed, so the proxy has to go and get the new value itself
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( "dbuscxx.test", "/test", DBUS_CXX_PROPERTIES_INTERFACE, "Set" );
+    msg << std::string( "dbuscxx.invalidating" ) << std::string( "invalidating" ) << DBus::Variant( int32_t( 77 ) );
+    conn->send_with_reply_blocking( msg );
+
+    return wait_for( [&lastValue](){
+        return lastValue == 77;
+    } );
+}
+
+/*
+ * The match rules that the bus has for our connection that contain the
+ * given text.
+ */
+static std::vector<std::string> our_match_rules( const std::string& containing ){
+    std::shared_ptr<DBus::CallMessage> msg =
+        DBus::CallMessage::create( "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus.Debug.Stats", "GetAllMatchRules" );
+    std::shared_ptr<DBus::ReturnMessage> ret = conn->send_with_reply_blocking( msg );
+    std::map<std::string,std::vector<std::string>> allRules;
+    std::vector<std::string> rules;
+
+    ret >> allRules;
+
+    for( const std::string& rule : allRules[ conn->unique_name() ] ){
+        if( rule.find( containing ) != std::string::npos ){
+            rules.push_back( rule );
+        }
+    }
+
+    return rules;
+}
+
+bool property_changes_subscription(){
+    std::shared_ptr<DBus::ObjectProxy> other = conn->create_object_proxy( "dbuscxx.test", "/test/other" );
+
+    // Nothing to listen for until there is a property
+    other->create_interface( "dbuscxx.interface" );
+    TEST_ASSERT_RET_FAIL( our_match_rules( "path='/test/other'" ).empty() );
+
+    std::shared_ptr<DBus::PropertyProxy<int32_t>> first =
+        other->create_property<int32_t>( "dbuscxx.interface", "first" );
+    std::vector<std::string> rules = our_match_rules( "path='/test/other'" );
+
+    TEST_ASSERT_RET_FAIL( rules.size() == 1 );
+    TEST_ASSERT_RET_FAIL( rules[ 0 ].find( "sender='dbuscxx.test'" ) != std::string::npos );
+    TEST_ASSERT_RET_FAIL( rules[ 0 ].find( "member='PropertiesChanged'" ) != std::string::npos );
+
+    // All of the properties share the one rule
+    std::shared_ptr<DBus::PropertyProxy<int32_t>> second =
+        other->create_property<int32_t>( "dbuscxx.interface", "second" );
+    TEST_ASSERT_RET_FAIL( our_match_rules( "path='/test/other'" ).size() == 1 );
+
+    std::shared_ptr<DBus::InterfaceProxy> iface = other->interface_by_name( "dbuscxx.interface" );
+
+    iface->remove_property( first );
+    TEST_ASSERT_RET_FAIL( our_match_rules( "path='/test/other'" ).size() == 1 );
+
+    iface->remove_property( second );
+    TEST_ASSERT_RET_FAIL( our_match_rules( "path='/test/other'" ).empty() );
+
+    return true;
+}
+
 void client_setup() {
     proxy = conn->create_object_proxy( "dbuscxx.test", "/test" );
 
@@ -152,6 +335,12 @@ void server_setup() {
     std::shared_ptr<DBus::Property<int32_t>> readonly =
             object->create_property<int32_t>( "dbuscxx.interface", "readonly", DBus::PropertyAccess::ReadOnly );
     readonly->set_value( 44 );
+
+    std::shared_ptr<DBus::Property<int32_t>> invalidating =
+            object->create_property<int32_t>( "dbuscxx.invalidating", "invalidating",
+                                              DBus::PropertyAccess::ReadWrite,
+                                              DBus::PropertyUpdateType::Invalidates );
+    invalidating->set_value( 1 );
 }
 
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
@@ -184,6 +373,12 @@ int main( int argc, char** argv ) {
         ADD_TEST( set_readonly );
         ADD_TEST( signal_emitted );
         ADD_TEST( updated_from_signal );
+        ADD_TEST( prefetch );
+        ADD_TEST( get_all_after_set );
+        ADD_TEST( changes_subscription );
+        ADD_TEST( refresh_names );
+        ADD_TEST( refresh_async );
+        ADD_TEST( invalidated_refetch );
     } else {
         server_setup();
         ret = true;
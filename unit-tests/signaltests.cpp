@@ -21,6 +21,7 @@
 #include <dbus-cxx.h>
 #include <unistd.h>
 #include <iostream>
+#include <sstream>
 
 #include "test_macros.h"
 
@@ -205,6 +206,342 @@ bool signal_remove_handler() {
     return true;
 }
 
+bool signal_object_proxy_routing() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::ObjectProxy>> objects;
+
+    for( int x = 0; x < 20; x++ ) {
+        std::shared_ptr<DBus::ObjectProxy> object =
+            conn->create_object_proxy( conn->unique_name(), "/test/signal/" + std::to_string( x ) );
+
+        if( x != 7 ) {
+            object->create_signal<void()>( "test.signal.type", "ExampleMember" )
+                ->connect( sigc::ptr_fun( voidSigHandle ) );
+        }
+
+        objects.push_back( object );
+    }
+
+    // Only the proxy on the path of the signal gets it
+    std::shared_ptr<DBus::Signal<void()>> signal = conn->create_free_signal<void()>( "/test/signal/5", "test.signal.type", "ExampleMember" );
+    signal->emit();
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( num_rx == 1 );
+
+    // A signal proxy created after signals have been routed gets them too
+    objects[ 7 ]->create_signal<void()>( "test.signal.type", "ExampleMember" )
+        ->connect( sigc::ptr_fun( voidSigHandle ) );
+
+    std::shared_ptr<DBus::Signal<void()>> signal2 = conn->create_free_signal<void()>( "/test/signal/7", "test.signal.type", "ExampleMember" );
+    signal2->emit();
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( num_rx == 2 );
+    return true;
+}
+
+bool signal_incoming_overflow() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    int watermark_count = 0;
+
+    conn->set_incoming_queue_limits( 4, 0 );
+    conn->set_incoming_overflow_policy( DBus::IncomingOverflowPolicy::DropOldestSignals );
+    conn->signal_incoming_queue_watermark().connect( [&watermark_count]( bool ) {
+        watermark_count++;
+    } );
+
+    std::shared_ptr<DBus::Signal<void()>> signal = conn->create_free_signal<void()>( "/test/signal", "test.signal.type", "ExampleMember" );
+    std::shared_ptr<DBus::SignalProxy<void()>> proxy = conn->create_free_signal_proxy<void()>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    // Handle the signals slowly, so that they pile up
+    proxy->connect( []() {
+        num_rx++;
+        usleep( 10000 );
+    } );
+
+    for( int x = 0; x < 20; x++ ) {
+        signal->emit();
+    }
+
+    sleep( 1 );
+
+    DBus::IncomingQueueStats stats = conn->incoming_queue_stats();
+
+    TEST_ASSERT_RET_FAIL( stats.droppedSignals > 0 );
+    // The NameAcquired signal from the bus may have been dropped as well
+    TEST_ASSERT_RET_FAIL( num_rx + stats.droppedSignals >= 20 );
+    TEST_ASSERT_RET_FAIL( num_rx + stats.droppedSignals <= 21 );
+    TEST_ASSERT_RET_FAIL( stats.peakMessages <= 4 );
+    TEST_ASSERT_RET_FAIL( watermark_count >= 2 );
+    return true;
+}
+
+/*
+ * Send a burst of calls to a slow method on a connection that can only queue
+ * up two messages, and sort out how each of the calls finished.
+ */
+static bool flood_limited_connection( DBus::IncomingOverflowPolicy policy,
+    std::shared_ptr<DBus::Connection> server,
+    int* num_ok,
+    int* num_limited ) {
+    std::shared_ptr<DBus::Connection> client = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<const DBus::CallMessage>> calls;
+
+    server->set_incoming_queue_limits( 2, 0 );
+    server->set_incoming_overflow_policy( policy );
+    TEST_ASSERT_RET_FAIL( server->request_name( "dbuscxx.test.limits" ) == DBus::RequestNameResponse::PrimaryOwner );
+
+    std::shared_ptr<DBus::Object> object = server->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<void()>( "test.for.dbuscxx", "slow", []() {
+        usleep( 20000 );
+    } );
+
+    for( int x = 0; x < 10; x++ ) {
+        calls.push_back( DBus::CallMessage::create( "dbuscxx.test.limits", "/test", "test.for.dbuscxx", "slow" ) );
+    }
+
+    for( std::shared_ptr<DBus::PendingCall> call : client->send_with_reply_batch( calls, 5000 ) ) {
+        std::shared_ptr<const DBus::Message> reply = call->reply();
+
+        TEST_ASSERT_RET_FAIL( reply );
+
+        if( reply->type() == DBus::MessageType::RETURN ) {
+            ( *num_ok )++;
+        } else if( std::static_pointer_cast<const DBus::ErrorMessage>( reply )->name() == DBUSCXX_ERROR_LIMITS_EXCEEDED ) {
+            ( *num_limited )++;
+        }
+    }
+
+    return true;
+}
+
+bool signal_incoming_reject_calls() {
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    int num_ok = 0;
+    int num_limited = 0;
+
+    TEST_ASSERT_RET_FAIL( flood_limited_connection( DBus::IncomingOverflowPolicy::RejectCalls, server, &num_ok, &num_limited ) );
+
+    DBus::IncomingQueueStats stats = server->incoming_queue_stats();
+
+    TEST_ASSERT_RET_FAIL( num_limited > 0 );
+    TEST_ASSERT_RET_FAIL( num_ok + num_limited == 10 );
+    TEST_ASSERT_RET_FAIL( stats.rejectedCalls == static_cast<uint64_t>( num_limited ) );
+    TEST_ASSERT_RET_FAIL( stats.peakMessages <= 2 );
+    return true;
+}
+
+bool signal_incoming_pause_reading() {
+    std::shared_ptr<DBus::Connection> server = dispatch->create_connection( DBus::BusType::SESSION );
+    int num_ok = 0;
+    int num_limited = 0;
+
+    TEST_ASSERT_RET_FAIL( flood_limited_connection( DBus::IncomingOverflowPolicy::PauseReading, server, &num_ok, &num_limited ) );
+
+    DBus::IncomingQueueStats stats = server->incoming_queue_stats();
+
+    // Everything waits on the socket instead of being turned away
+    TEST_ASSERT_RET_FAIL( num_ok == 10 );
+    TEST_ASSERT_RET_FAIL( stats.rejectedCalls == 0 );
+    TEST_ASSERT_RET_FAIL( stats.pausedReads > 0 );
+    TEST_ASSERT_RET_FAIL( stats.peakMessages <= 2 );
+    return true;
+}
+
+bool signal_call_priority() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+
+    conn->request_name( "dbuscxx.test" );
+
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    object->create_method<int()>( "test.for.dbuscxx", "getRx", []() { return num_rx; } );
+
+    std::shared_ptr<DBus::Signal<void()>> signal = conn->create_free_signal<void()>( "/test/signal", "test.signal.type", "ExampleMember" );
+    std::shared_ptr<DBus::SignalProxy<void()>> proxy = conn->create_free_signal_proxy<void()>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    proxy->connect( []() {
+        num_rx++;
+        usleep( 20000 );
+    } );
+
+    for( int x = 0; x < 20; x++ ) {
+        signal->emit();
+    }
+
+    usleep( 100000 );
+
+    // The call and its reply should get ahead of the signals that are
+    // still waiting to be processed
+    std::shared_ptr<DBus::MethodProxy<int()>> getRx =
+        conn->create_object_proxy( "dbuscxx.test", "/test" )
+        ->create_method<int()>( "test.for.dbuscxx", "getRx" );
+    int rxAtCall = ( *getRx )();
+
+    TEST_ASSERT_RET_FAIL( rxAtCall < 20 );
+
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( num_rx == 20 );
+    return true;
+}
+
+bool signal_batched_matches() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::vector<std::shared_ptr<DBus::SignalProxy<void()>>> proxies;
+    int error_count = 0;
+
+    conn->signal_match_error().connect( [&error_count]( std::string, std::string ) {
+        error_count++;
+    } );
+
+    // An add that is removed before it is sent cancels out.  Nothing
+    // dispatches this connection, so nothing can be sent in between.
+    std::shared_ptr<DBus::Connection> quiet = DBus::Connection::create( DBus::BusType::SESSION );
+    TEST_ASSERT_RET_FAIL( quiet->bus_register() );
+    quiet->add_match_nonblocking( "type='signal',path='/test/never'" );
+    quiet->remove_match_nonblocking( "type='signal',path='/test/never'" );
+    TEST_ASSERT_RET_FAIL( quiet->pending_match_changes() == 0 );
+
+    // This goes out after anything that is queued, so if the bus had ever
+    // been told about the first rule it would have had two at once
+    TEST_ASSERT_RET_FAIL( quiet->add_match( "type='signal',path='/test/sent'" ) );
+
+    std::shared_ptr<DBus::ObjectProxy> busProxy = conn->create_object_proxy( "org.freedesktop.DBus", "/org/freedesktop/DBus" );
+    std::shared_ptr<DBus::MethodProxy<std::map<std::string, DBus::Variant>( std::string )>> getStats =
+        busProxy->create_method<std::map<std::string, DBus::Variant>( std::string )>( "org.freedesktop.DBus.Debug.Stats", "GetConnectionStats" );
+    std::map<std::string, DBus::Variant> stats = ( *getStats )( quiet->unique_name() );
+
+    TEST_ASSERT_RET_FAIL( stats[ "MatchRules" ].to_uint32() == 1 );
+    TEST_ASSERT_RET_FAIL( stats[ "PeakMatchRules" ].to_uint32() == 1 );
+
+    for( int x = 0; x < 50; x++ ) {
+        std::ostringstream path;
+        path << "/test/signal" << x;
+        std::shared_ptr<DBus::SignalProxy<void()>> proxy = conn->create_free_signal_proxy<void()>(
+                    DBus::MatchRuleBuilder::create()
+                    .set_path( path.str() )
+                    .as_signal_match(),
+                    DBus::ThreadForCalling::DispatcherThread );
+        proxy->connect( []() { num_rx++; } );
+        proxies.push_back( proxy );
+    }
+
+    std::shared_ptr<DBus::Signal<void()>> signal = conn->create_free_signal<void()>( "/test/signal49", "test.signal.type", "ExampleMember" );
+    signal->emit();
+
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( conn->pending_match_changes() == 0 );
+    TEST_ASSERT_RET_FAIL( error_count == 0 );
+    TEST_ASSERT_RET_FAIL( num_rx == 1 );
+    return true;
+}
+
+bool signal_properties_coalesced() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    std::shared_ptr<DBus::Interface> iface = object->create_interface( "test.for.dbuscxx" );
+    std::vector<std::shared_ptr<DBus::Property<int32_t>>> props;
+    std::vector<size_t> changes;
+
+    for( int x = 0; x < 10; x++ ) {
+        props.push_back( iface->create_property<int32_t>( "prop" + std::to_string( x ) ) );
+    }
+
+    std::shared_ptr<DBus::SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> proxy =
+        conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test" )
+                .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
+                .set_member( "PropertiesChanged" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    proxy->connect( [&changes]( std::string, std::map<std::string,DBus::Variant> changed, std::vector<std::string> ) {
+        changes.push_back( changed.size() );
+    } );
+
+    // Everything set within the window goes in one signal
+    iface->set_property_coalescing( true, std::chrono::milliseconds( 100 ) );
+
+    for( int x = 0; x < 10; x++ ) {
+        props[ x ]->set_value( x );
+    }
+
+    sleep( 1 );
+
+    // ...as does everything set within a batch
+    iface->set_property_coalescing( false );
+
+    {
+        DBus::PropertyChangeBatch batch( iface );
+
+        for( int x = 0; x < 5; x++ ) {
+            props[ x ]->set_value( x + 100 );
+        }
+    }
+
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( changes.size() == 2 );
+    TEST_ASSERT_RET_FAIL( changes[ 0 ] == 10 );
+    TEST_ASSERT_RET_FAIL( changes[ 1 ] == 5 );
+    return true;
+}
+
+bool signal_properties_reentrant() {
+    std::shared_ptr<DBus::Connection> conn = dispatch->create_connection( DBus::BusType::SESSION );
+    std::shared_ptr<DBus::Object> object = conn->create_object( "/test", DBus::ThreadForCalling::DispatcherThread );
+    std::shared_ptr<DBus::Interface> iface = object->create_interface( "test.for.dbuscxx" );
+    std::shared_ptr<DBus::Property<int32_t>> prop0 = iface->create_property<int32_t>( "prop0" );
+    std::shared_ptr<DBus::Property<int32_t>> prop1 = iface->create_property<int32_t>( "prop1" );
+    int num_changes = 0;
+
+    std::shared_ptr<DBus::Signal<void(int32_t)>> signal = conn->create_free_signal<void(int32_t)>( "/test/signal", "test.signal.type", "Set" );
+    std::shared_ptr<DBus::SignalProxy<void(int32_t)>> setProxy = conn->create_free_signal_proxy<void(int32_t)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test/signal" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+    std::shared_ptr<DBus::SignalProxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>> changedProxy =
+        conn->create_free_signal_proxy<void(std::string,std::map<std::string,DBus::Variant>,std::vector<std::string>)>(
+                DBus::MatchRuleBuilder::create()
+                .set_path( "/test" )
+                .set_interface( DBUS_CXX_PROPERTIES_INTERFACE )
+                .set_member( "PropertiesChanged" )
+                .as_signal_match(),
+                DBus::ThreadForCalling::DispatcherThread );
+
+    // Sending the change for the first property dispatches again, which
+    // handles the second signal and changes the other property
+    setProxy->connect( [prop0, prop1]( int32_t which ) {
+        if( which == 0 ) {
+            prop0->set_value( 10 );
+        } else {
+            prop1->set_value( 11 );
+        }
+    } );
+    changedProxy->connect( [&num_changes]( std::string, std::map<std::string,DBus::Variant>, std::vector<std::string> ) {
+        num_changes++;
+    } );
+
+    signal->emit( 0 );
+    signal->emit( 1 );
+
+    sleep( 1 );
+
+    TEST_ASSERT_RET_FAIL( num_changes == 2 );
+    return true;
+}
+
 #define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
             ret = signal_##name();\
         } \
@@ -231,6 +568,14 @@ int main( int argc, char** argv ) {
     ADD_TEST( member_match_only );
     ADD_TEST( multiple_handlers );
     ADD_TEST( remove_handler );
+    ADD_TEST( object_proxy_routing );
+    ADD_TEST( incoming_overflow );
+    ADD_TEST( incoming_reject_calls );
+    ADD_TEST( incoming_pause_reading );
+    ADD_TEST( call_priority );
+    ADD_TEST( batched_matches );
+    ADD_TEST( properties_coalesced );
+    ADD_TEST( properties_reentrant );
 
     return !ret;
 }
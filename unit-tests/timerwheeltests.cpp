@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later OR BSD-3-Clause
+/***************************************************************************
+ *   Copyright (C) 2022 by Robert Middleton                                *
+ *   robert.middleton@rm5248.com                                           *
+ *                                                                         *
+ *   This file is part of the dbus-cxx library.                            *
+ ***************************************************************************/
+#include <dbus-cxx/timerwheel.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "test_macros.h"
+
+using DBus::priv::TimerWheel;
+
+/*
+ * The wheel counts whole milliseconds from when it was created.  A deadline
+ * is rounded up to the next tick and the time that the wheel is advanced to
+ * is rounded down, so a timer has always expired one millisecond after its
+ * deadline and never one millisecond before, no matter how far into a tick
+ * the base time is.
+ */
+static std::chrono::steady_clock::time_point base;
+
+static std::chrono::steady_clock::time_point at( int64_t milliseconds ) {
+    return base + std::chrono::milliseconds( milliseconds );
+}
+
+/*
+ * Advance the wheel to the given time, and return the IDs that expired, sorted.
+ */
+static std::vector<uint32_t> advance_to( TimerWheel& wheel, int64_t milliseconds ) {
+    std::vector<uint32_t> expired;
+
+    wheel.advance( at( milliseconds ), &expired );
+    std::sort( expired.begin(), expired.end() );
+
+    return expired;
+}
+
+bool timerwheel_schedule() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() == std::chrono::steady_clock::time_point::max() );
+
+    wheel.schedule( at( 5 ), 1 );
+    wheel.schedule( at( 10 ), 2 );
+    wheel.schedule( at( 10 ), 3 );
+    wheel.schedule( at( 20 ), 4 );
+
+    TEST_ASSERT_RET_FAIL( !wheel.empty() );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() <= at( 6 ) );
+
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 4 ).empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 6 ) == std::vector<uint32_t>( { 1 } ) );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 9 ).empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 11 ) == std::vector<uint32_t>( { 2, 3 } ) );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 21 ) == std::vector<uint32_t>( { 4 } ) );
+
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() == std::chrono::steady_clock::time_point::max() );
+    return true;
+}
+
+bool timerwheel_schedule_past() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 50 ).empty() );
+
+    // A deadline that has already gone by expires on the next tick
+    wheel.schedule( at( 10 ), 1 );
+
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 52 ) == std::vector<uint32_t>( { 1 } ) );
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    return true;
+}
+
+bool timerwheel_cancel() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+
+    TimerWheel::Timer* first = wheel.schedule( at( 10 ), 1 );
+    wheel.schedule( at( 10 ), 2 );
+    TimerWheel::Timer* far = wheel.schedule( at( 5000 ), 3 );
+
+    wheel.cancel( first );
+    wheel.cancel( far );
+
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 11 ) == std::vector<uint32_t>( { 2 } ) );
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 6000 ).empty() );
+
+    // Cancelling nothing does nothing
+    wheel.cancel( nullptr );
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    return true;
+}
+
+bool timerwheel_level_boundaries() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+
+    // Each level has 64 slots, so these are on either side of where the
+    // timers move down from one level to the next
+    std::vector<int64_t> deadlines = { 63, 64, 65, 127, 128, 4095, 4096, 4097, 262143, 262144, 262145 };
+
+    for( size_t x = 0; x < deadlines.size(); x++ ) {
+        wheel.schedule( at( deadlines[ x ] ), x );
+    }
+
+    for( size_t x = 0; x < deadlines.size(); x++ ) {
+        TEST_ASSERT_RET_FAIL( advance_to( wheel, deadlines[ x ] - 1 ).empty() );
+        TEST_ASSERT_RET_FAIL( wheel.next_expiry() <= at( deadlines[ x ] + 1 ) );
+        TEST_ASSERT_RET_FAIL( advance_to( wheel, deadlines[ x ] + 1 ) == std::vector<uint32_t>( { static_cast<uint32_t>( x ) } ) );
+    }
+
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    return true;
+}
+
+bool timerwheel_advance_many() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+    std::vector<uint32_t> expected;
+
+    for( uint32_t x = 0; x < 200; x++ ) {
+        wheel.schedule( at( x * 37 + 1 ), x );
+        expected.push_back( x );
+    }
+
+    // Jumping over all of the levels at once expires everything
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, 200 * 37 + 1 ) == expected );
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    return true;
+}
+
+bool timerwheel_long_timeout() {
+    TimerWheel wheel;
+    base = std::chrono::steady_clock::now();
+
+    // The wheel itself only covers 2^24 ms(about 4.6 hours); anything past
+    // that waits at the end and is put back in place when it is reached
+    int64_t span = static_cast<int64_t>( 1 ) << 24;
+    int64_t day = 24 * 60 * 60 * 1000;
+
+    wheel.schedule( at( span + 1000 ), 1 );
+    wheel.schedule( at( day ), 2 );
+
+    TEST_ASSERT_RET_FAIL( wheel.next_expiry() <= at( span + 1001 ) );
+
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, span ).empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, span + 999 ).empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, span + 1001 ) == std::vector<uint32_t>( { 1 } ) );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, day - 1 ).empty() );
+    TEST_ASSERT_RET_FAIL( advance_to( wheel, day + 1 ) == std::vector<uint32_t>( { 2 } ) );
+    TEST_ASSERT_RET_FAIL( wheel.empty() );
+    return true;
+}
+
+#define ADD_TEST(name) do{ if( test_name == STRINGIFY(name) ){ \
+            ret = timerwheel_##name();\
+        } \
+    } while( 0 )
+
+int main( int argc, char** argv ) {
+    if( argc < 2 ) {
+        return 1;
+    }
+
+    std::string test_name = argv[1];
+    bool ret = false;
+
+    ADD_TEST( schedule );
+    ADD_TEST( schedule_past );
+    ADD_TEST( cancel );
+    ADD_TEST( level_boundaries );
+    ADD_TEST( advance_many );
+    ADD_TEST( long_timeout );
+
+    return !ret;
+}